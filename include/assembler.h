@@ -0,0 +1,27 @@
+// Assembler: source in the syntax the disassembler prints into rom bytes
+//
+// One instruction per line (see decoded_instruction_from_string), ; starts a comment. A line may start with a
+// label (name:), which address operands can use instead of a number. db 0xF0, 0x90, ... places bytes, for sprites.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ASSEMBLER_MAX_LABELS 512
+#define ASSEMBLER_LABEL_SIZE 32
+#define ASSEMBLER_LINE_SIZE 256
+
+struct AssemblerLabel {
+  char name[ASSEMBLER_LABEL_SIZE];
+  uint16_t address;
+};
+
+// Assembles source_size bytes of source for a rom loaded at load_address, errors go to stderr as source_name:line.
+// output is left partly written on failure.
+bool assembler_assemble(const char *source, size_t source_size, const char *source_name, uint16_t load_address,
+                        uint8_t *output, size_t capacity, size_t *output_size);
+
+// Same, for a file
+bool assembler_assemble_file(const char *source_name, uint16_t load_address, uint8_t *output, size_t capacity, size_t *output_size);
@@ -0,0 +1,35 @@
+// Instructions per frame auto-tuner: adjusts the budget from host headroom and guest pacing hints
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "emulated.h"
+#include "rom_profile.h"
+
+#define AUTOTUNE_WINDOW_FRAMES 60 // Hints are summed over a window before each decision
+#define AUTOTUNE_STABLE_WINDOWS 5 // Windows in a row without a change before the budget is settled
+
+struct Autotune {
+  bool is_enabled;
+  bool is_settled;
+  uint16_t minimum;
+  uint16_t maximum;
+
+  // Current window
+  unsigned int frame_count;
+  uint64_t busy_ns; // Host time spent running instructions
+  uint64_t frame_ns; // Host time available for them
+  uint32_t draw_count; // struct EmulatedSystem counters at the start of the window
+  uint32_t delay_timer_read_count;
+
+  unsigned int stable_windows;
+};
+
+// Takes the limits from the profile and moves the current budget inside them
+void autotune_begin(struct Autotune *autotune, const struct RomProfile *rom_profile, struct EmulatedSystem *emulated_system);
+
+// Called after each frame. May change emulated_system->instructions_per_frame,
+// returns true once, when it settles (the caller then stores it in the profile).
+bool autotune_frame(struct Autotune *autotune, struct EmulatedSystem *emulated_system, uint64_t busy_ns, uint64_t frame_ns);
@@ -0,0 +1,79 @@
+// Breakpoints and watchpoints, checked only by the debug dispatch loop
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "emulated.h"
+
+#define DEBUGGER_MAX_WATCHPOINTS 32
+#define DEBUGGER_MAX_CONDITIONS 64
+#define DEBUGGER_CONDITION_CODE_SIZE 96
+#define DEBUGGER_CONDITION_STACK_SIZE 16
+
+// Condition bytecode, each opcode may be followed by operand bytes
+enum DebuggerConditionOpcode {
+  CONDITION_END,
+  CONDITION_PUSH_CONSTANT, // 2 bytes, big endian
+  CONDITION_PUSH_REGISTER, // 1 byte, register index
+  CONDITION_PUSH_I,
+  CONDITION_PUSH_PC,
+  CONDITION_PUSH_DELAY_TIMER,
+  CONDITION_PUSH_SOUND_TIMER,
+  CONDITION_EQUAL,
+  CONDITION_NOT_EQUAL,
+  CONDITION_LESS,
+  CONDITION_LESS_EQUAL,
+  CONDITION_GREATER,
+  CONDITION_GREATER_EQUAL,
+  CONDITION_AND,
+  CONDITION_OR,
+  CONDITION_NOT,
+};
+
+struct DebuggerCondition {
+  uint16_t address; // Breakpoint it belongs to
+  uint8_t code[DEBUGGER_CONDITION_CODE_SIZE];
+};
+
+struct DebuggerWatchpoint {
+  uint16_t first;
+  uint16_t last; // Inclusive
+  enum {
+    WATCH_READ = 1 << 0,
+    WATCH_WRITE = 1 << 1,
+  } access;
+};
+
+struct Debugger {
+  // Set along with the first breakpoint or watchpoint, the emulator then dispatches through debugger_run
+  bool is_active;
+
+  uint64_t breakpoints[4096 / 64]; // Bit per PC value
+
+  struct DebuggerCondition conditions[DEBUGGER_MAX_CONDITIONS];
+  uint8_t condition_count;
+
+  struct DebuggerWatchpoint watchpoints[DEBUGGER_MAX_WATCHPOINTS];
+  uint8_t watchpoint_count;
+  bool watch_I; // Stop whenever I changes
+
+  // Execution stopped before the instruction at this address, it is let through once on resume
+  bool is_stopped;
+  uint16_t stopped_at;
+};
+
+// address: PC value; condition: expression such as "V3 == 5 && I > 0x300", NULL for always
+bool debugger_add_breakpoint(struct Debugger *debugger, uint16_t address, const char *condition);
+bool debugger_add_watchpoint(struct Debugger *debugger, uint16_t first, uint16_t last, int access);
+void debugger_watch_I(struct Debugger *debugger);
+
+// Compiles a condition into bytecode, false on syntax errors
+bool debugger_compile_condition(const char *text, uint8_t *code, size_t code_size);
+uint16_t debugger_evaluate_condition(const uint8_t *code, const struct EmulatedSystem *emulated_system);
+
+// Runs up to count instructions, returns how many were executed.
+// Pauses the emulated system before a breakpoint or right after a watchpoint is hit.
+unsigned int debugger_run(struct Debugger *debugger, struct EmulatedSystem *emulated_system,
+                          EmulatedSystemCore emulate_decoded_instruction, unsigned int count);
@@ -14,31 +14,23 @@
 extern const uint32_t emulated_system_entry_point;
 extern const uint8_t emulated_system_font[16][5];
 
-struct EmulatedSystem {
-  unsigned int frames_per_second;
-  unsigned int instructions_per_frame;
+// Display rows, bit 63 is the leftmost pixel
+#define EMULATED_DISPLAY_WIDTH 64
+#define EMULATED_DISPLAY_HEIGHT 32
 
-  enum {
-    QUIT,
-    RUNNING,
-    PAUSE,
-  } state;
-  enum {
-    CHIP8,
-    SUPERCHIP,
-    XOCHIP,
-  } extension;
-  uint8_t ram[4096]; // 4 kilobytes of fully writable RAM
-  bool display[64*32]; // 64x32 pixels, each can be on or off (boolean)
-  uint16_t stack[STACK_SIZE]; // stores 16-bit adresses, used for function call and return
+// Laid out by how often it is touched: the first cache line holds every register and what each instruction reads or
+// writes besides RAM, the second the rest of the per-instruction and per-frame state, then the display and RAM.
+struct EmulatedSystem {
+  // stack to sound_timer is the register block the embedding API points at (tracua_chip8.h), keep it in this order
+  _Alignas(64) uint16_t stack[STACK_SIZE]; // stores 16-bit adresses, used for function call and return
   uint8_t SP;
   uint8_t V[16]; // general-purpose registers
   uint16_t I; // points at some location in memory
   uint16_t PC; // points at the current instruction in memory
   uint8_t delay_timer; // decrements at the rate of 60hz (60 times per second until reaches 0)
   uint8_t sound_timer; // like the delay_timer
-  bool keypad[16];
-  const char *rom_name;
+  uint16_t keypad; // bit per key, set while it is held
+  uint16_t keypad_observed; // bit per key read by Ex9E, ExA1 or Fx0A, cleared by whoever measures input latency
 
   // data as it appears in the rom
   //
@@ -51,17 +43,56 @@ struct EmulatedSystem {
   //  - 4bit-value and 8-bit value.
   //
   //  - 3 parts, 4-bit value each
-  uint16_t encoded_instruction; 
+  uint16_t encoded_instruction;
+
+  enum {
+    QUIT,
+    RUNNING,
+    PAUSE,
+  } state;
+
+  // pacing hints for the instructions per frame auto-tuner, only ever incremented
+  uint32_t draw_count;
+  uint32_t delay_timer_read_count; // Fx07, games waiting on the delay timer spin on it
 
   struct DecodedInstruction decoded_instruction;
+
+  unsigned int frames_per_second;
+  unsigned int instructions_per_frame;
+  enum {
+    CHIP8,
+    SUPERCHIP,
+    XOCHIP,
+  } extension;
+  const char *rom_name;
+
+  _Alignas(64) uint64_t display[EMULATED_DISPLAY_HEIGHT]; // 64x32 pixels, a row per word
+  uint8_t ram[4096]; // 4 kilobytes of fully writable RAM
 };
 
+static inline bool emulated_display_pixel(const uint64_t *display, uint32_t x, uint32_t y) {
+  return (display[y] >> (63 - x)) & 1;
+}
+
 // emulated.c
 
+// Executes struct EmulatedSystem->decoded_instruction
+typedef void (*EmulatedSystemCore)(struct EmulatedSystem *emulated_system);
+
 void emulated_system_initialize(struct EmulatedSystem *emulated_system);
 bool emulated_system_consume_instruction(struct EmulatedSystem *emulated_system);
+
+// Picks the core specialized for the quirks of emulated_system->extension
+EmulatedSystemCore emulated_system_core(const struct EmulatedSystem *emulated_system);
 void emulated_system_emulate_decoded_instruction(struct EmulatedSystem *emulated_system);
 
+// Cores generated from core.c with quirks fixed at compile time
+void emulated_system_chip8_emulate_decoded_instruction(struct EmulatedSystem *emulated_system);
+void emulated_system_superchip_emulate_decoded_instruction(struct EmulatedSystem *emulated_system);
+
+// Same core, checking quirks at runtime
+void emulated_system_generic_emulate_decoded_instruction(struct EmulatedSystem *emulated_system);
+
 // state.c
 
 // Writes struct Emulator->EmulatedSystem data to a binary file
@@ -6,27 +6,93 @@
 #include <stdbool.h>
 
 #include "emulated.h"
+#include "autotune.h"
+#include "debugger.h"
+#include "live_patch.h"
+#include "predecode.h"
+#include "rom_library.h"
+#include "rom_profile.h"
+#include "scheduler.h"
+#include "startup_trace.h"
+#include "trace.h"
+#include "vip_timing.h"
 #include "user_interface/sdl/interface.h"
+#include "user_interface/frame_share.h"
+#include "user_interface/video_stream.h"
 
+// Ordered by how often emulator_update touches it: the emulated system, then the flags checked every frame,
+// then subsystems that are mostly idle, with the user interface (its pixel colours, glyph quads) last.
 struct Emulator {
+  // represents the system that will be emulated
+  struct EmulatedSystem emulated_system;
+
+  // no window, audio or keyboard, frames are emulated as fast as possible
+  bool is_headless;
+
+  enum {
+    EMULATOR_TIMING_FAST, // instructions_per_frame instructions, whatever they cost
+    EMULATOR_TIMING_VIP, // machine cycles of the COSMAC VIP, debugger, trace, auto-tuner and fusion statistics are refused with it
+  } timing;
+  struct VipTiming vip_timing;
+
+  // timer, audio and vblank events in instructions executed, drives the fast timing
+  struct Scheduler scheduler;
+
+  // quit after this many frames, 0 means never
+  uint64_t frame_limit;
+  uint64_t frame_count;
+
+  // instructions go through it unless the debugger, trace, auto-tuner or VIP timing take over
+  struct Predecode predecode;
+  bool print_fusion_statistics; // on exit
+
+  // breakpoints and watchpoints, instructions go through debugger_run once any is set
+  struct Debugger debugger;
+  // per-instruction records, instructions go through trace_run while open
+  struct Trace trace;
+  // reassembles a source and patches RAM on every save while watching
+  struct LivePatch live_patch;
+
+  // adjusts emulated_system.instructions_per_frame when enabled, the settled value goes into rom_profile
+  struct Autotune autotune;
+
+  // records every emulated frame when open
+  struct VideoStream video_stream;
+  // publishes every emulated frame to other processes when open
+  struct FrameShare frame_share;
+
   unsigned int frames_per_second;
 
   // how many instructions are executed each frame.
   unsigned int instructions_per_frame;
 
-  // represents the system that will be emulated
-  struct EmulatedSystem emulated_system;
+  const char *rom_name; // binary file loaded into the virtual machine
+
+  // roms can be loaded from here by name or hash when open
+  struct RomLibrary rom_library;
+
+  // static analysis of the loaded rom, picks its quirks
+  struct RomProfile rom_profile;
+
+  // time from main to the first frame, reported once it is shown when enabled
+  struct StartupTrace startup_trace;
 
   // handles the user interaction with the emulated system (audio, video, keypresses)
   struct UserInterface user_interface;
-
-  const char *rom_name; // binary file loaded into the virtual machine
 };
 
-// Loads binary file to emulated system memory
+// Resets the emulated system and loads binary file to its memory, then picks quirks from its profile.
+// Also used to switch roms or start one over while running.
 bool emulator_load_rom(struct Emulator *emulator, const char* rom_name);
 
-// Initializes emulator
+// Same, for rom bytes already in memory
+bool emulator_load_rom_from_memory(struct Emulator *emulator, const char *rom_name, const uint8_t *rom, size_t rom_size);
+
+// Same, for a rom in struct Emulator->rom_library, key is its name or hash
+bool emulator_load_rom_from_library(struct Emulator *emulator, const char *key);
+
+// Initializes emulator and loads rom_name, from rom_library when it is open.
+// The window comes up while the rom is loaded, audio, fonts and the pause menu wait until they are first needed.
 bool emulator_initialize(struct Emulator *emulator);
 
 // Performs interpretation cycle
@@ -0,0 +1,37 @@
+// Pool of struct EmulatedSystem in one mapping, for hosting many instances densely
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "emulated.h"
+
+enum {
+  INSTANCE_ARENA_HUGEPAGES = 1 << 0, // Explicit hugepages when the system has them reserved, transparent ones otherwise
+};
+
+struct InstanceArena {
+  struct EmulatedSystem *instances; // capacity slots, one after the other, so a range of them can go to lockstep_create
+  size_t capacity;
+  size_t used; // Slots from the start handed out at least once, the rest were never touched and take no memory
+  struct EmulatedSystem *free_list; // Freed slots, linked through their RAM
+
+  size_t mapping_size;
+  bool has_hugepages; // Backed by explicit hugepages
+
+  // RAM every instance starts with (font and rom), a single read-only page shared by every allocation and reset
+  const uint8_t *image;
+};
+
+bool instance_arena_create(struct InstanceArena *arena, size_t capacity, int flags);
+void instance_arena_destroy(struct InstanceArena *arena);
+
+// Rom later allocations start with, loaded at emulated_system_entry_point
+bool instance_arena_set_rom(struct InstanceArena *arena, const uint8_t *rom, size_t rom_size);
+
+// Initialized instance holding the arena's rom, NULL once every slot is taken
+struct EmulatedSystem *instance_arena_allocate(struct InstanceArena *arena);
+void instance_arena_reset(const struct InstanceArena *arena, struct EmulatedSystem *emulated_system);
+void instance_arena_free(struct InstanceArena *arena, struct EmulatedSystem *emulated_system);
@@ -70,8 +70,10 @@ struct DecodedInstruction {
   };
 };
 
-// The string to be parsed into a decoded instructions is consumed until either a newline, a NULL or a EOF after the instruction or the last operand, depending on the instruction type. Thus, it is ok to pass a pointer to a buffer position, given these conditions are met.
+// The string to be parsed into a decoded instructions is consumed until either a newline, a NULL, a EOF or a ; comment after the instruction or the last operand, depending on the instruction type. Thus, it is ok to pass a pointer to a buffer position, given these conditions are met.
 // Example of string: add V0, 4\n
+// Same syntax instruction_decoded_sprint writes, registers may also be written VA, numbers in decimal or hex (0x), jp V0, address is BNNN.
+// Returns type INVALID when the line can't be parsed.
 struct DecodedInstruction decoded_instruction_from_string(const char *string);
 
 struct DecodedInstruction decoded_instruction_from_encoded_instruction(uint16_t encoded_instruction);
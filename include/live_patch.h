@@ -0,0 +1,37 @@
+// Live patching: watches an assembly source and, on every save, reassembles it and writes the bytes that changed into
+// the running instance's RAM. Registers, display, timers and the rest of RAM are left as they are.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "emulated.h"
+
+#define LIVE_PATCH_PROGRAM_SIZE (4096 - 0x200)
+
+struct LivePatch {
+  bool is_watching;
+  int inotify;
+  const char *source_name;
+  const char *base_name; // Events come for the directory, editors that save by renaming replace the file itself
+
+  // Last program written into RAM, each save is compared against it and not against RAM, so data the rom stored
+  // over its own bytes is only overwritten where the source changed
+  uint8_t program[LIVE_PATCH_PROGRAM_SIZE];
+  size_t program_size;
+};
+
+// Starts watching source_name and patches RAM to match it right away, in case the loaded rom is older
+bool live_patch_open(struct LivePatch *live_patch, const char *source_name, struct EmulatedSystem *emulated_system);
+
+// Compares the source against RAM itself and patches the difference, for when RAM was replaced, such as by loading
+// the rom again. False if the source does not assemble, the next save is then still compared against RAM.
+bool live_patch_sync(struct LivePatch *live_patch, struct EmulatedSystem *emulated_system);
+
+// Never blocks, reassembles and patches when the source was saved since the last call.
+// A source that no longer assembles leaves RAM as it is.
+void live_patch_poll(struct LivePatch *live_patch, struct EmulatedSystem *emulated_system);
+
+void live_patch_close(struct LivePatch *live_patch);
@@ -0,0 +1,61 @@
+// Many instances of the same rom stepped together, one vector lane each.
+// Lanes at the same PC run an instruction together, lanes that diverge wait for their turn.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "emulated.h"
+
+#define LOCKSTEP_LANES 16 // 16-bit lanes in an AVX2 vector
+
+struct LockstepGroup {
+  // Registers lane-wise, 8-bit ones widened so every row is one vector
+  uint16_t V[16][LOCKSTEP_LANES];
+  uint16_t I[LOCKSTEP_LANES];
+  uint16_t PC[LOCKSTEP_LANES];
+  uint16_t delay_timer[LOCKSTEP_LANES];
+  uint16_t sound_timer[LOCKSTEP_LANES];
+  uint16_t keypad[LOCKSTEP_LANES];
+  uint16_t keypad_observed[LOCKSTEP_LANES];
+
+  uint16_t running; // Bit per lane
+  struct EmulatedSystem *systems[LOCKSTEP_LANES]; // RAM, display and stack of each lane, registers there are stale until lockstep_sync
+
+  // Bit per address where the lanes' RAM may differ, fetches there check every lane's instruction
+  uint64_t written[4096 / 64];
+};
+
+struct Lockstep {
+  struct LockstepGroup *groups;
+  size_t group_count;
+  size_t instance_count;
+  unsigned int instructions_per_frame;
+
+  // Quirks of the shared extension
+  bool quirk_vf_reset;
+  bool quirk_shift_vy;
+  bool quirk_load_increments_i;
+  EmulatedSystemCore emulate_decoded_instruction; // For instructions run lane by lane
+
+  bool use_avx2; // Set when the CPU has it, may be cleared to compare with the portable lanes
+
+  // Occupancy, lane_steps / (steps * LOCKSTEP_LANES) is how full the vectors were
+  uint64_t steps;
+  uint64_t lane_steps;
+};
+
+// The instances must share extension and instructions per frame, and outlive the lockstep
+bool lockstep_create(struct Lockstep *lockstep, struct EmulatedSystem *instances, size_t instance_count);
+void lockstep_destroy(struct Lockstep *lockstep);
+
+void lockstep_set_keypad(struct Lockstep *lockstep, size_t instance, uint16_t keypad);
+
+// Runs every instance for count frames (instructions per frame, then a timer tick),
+// returns the instructions executed over all of them
+uint64_t lockstep_run_frames(struct Lockstep *lockstep, uint64_t count);
+
+// Copies the lanes' registers back into the instances
+void lockstep_sync(struct Lockstep *lockstep);
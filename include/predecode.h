@@ -0,0 +1,48 @@
+// Predecoded instruction stream: each address decoded once, with common sequences fused into one dispatch.
+// Entries keep the words they were built from and are rebuilt whenever RAM no longer holds them,
+// so stores into code, loaded states and hosts writing RAM need no invalidation.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "emulated.h"
+
+enum PredecodeFusion {
+  PREDECODE_SINGLE, // Not fused, goes through the core as is
+  PREDECODE_LOAD_I_DRAW, // ANNN; DXYN
+  PREDECODE_LOAD_I_LOAD_REGISTERS, // ANNN; FX65
+  PREDECODE_COUNTED_LOOP, // 7XKK; 3XKK or 4XKK; 1NNN
+  PREDECODE_DELAY_WAIT, // FX07; 3XKK or 4XKK; 1NNN
+  PREDECODE_FUSION_COUNT,
+};
+
+extern const char *const predecode_fusion_names[PREDECODE_FUSION_COUNT];
+
+struct PredecodedInstruction {
+  uint16_t words[3]; // Encoded instructions covered, checked against RAM before every dispatch
+  uint8_t length; // How many of them, 0 for an address never predecoded
+  uint8_t fusion; // enum PredecodeFusion
+  struct DecodedInstruction decoded_instruction; // The one handed to the core, the last one for fused pairs
+};
+
+struct PredecodeStatistics {
+  uint64_t dispatches;
+  uint64_t instructions;
+  uint64_t fused_instructions[PREDECODE_FUSION_COUNT]; // Instructions run by each kind of dispatch
+};
+
+struct Predecode {
+  struct PredecodedInstruction entries[4096]; // By address, odd ones included
+  struct PredecodeStatistics statistics;
+};
+
+// Runs up to count instructions like emulated_system_consume_instruction and the core would,
+// stops early once the emulated system is no longer running. Returns how many were executed.
+unsigned int predecode_run(struct Predecode *predecode, struct EmulatedSystem *emulated_system,
+                           EmulatedSystemCore emulate_decoded_instruction, unsigned int count);
+
+// Dispatches per frame with and without fusion, coverage of each kind and how many places in RAM were fused
+void predecode_report(const struct Predecode *predecode, FILE *output, const char *rom_name, uint64_t frames);
@@ -0,0 +1,77 @@
+// Static analysis of a rom image (control flow recovery)
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "instruction.h"
+
+#define PROGRAM_ANALYSIS_MEMORY_SIZE 4096
+#define PROGRAM_ANALYSIS_MAX_BLOCKS PROGRAM_ANALYSIS_MEMORY_SIZE // Overlapping (unaligned) code may start at any byte
+#define PROGRAM_ANALYSIS_NO_BLOCK 0xFFFF
+
+// Flags set for each byte of memory
+enum ProgramAnalysisByteFlag {
+  PROGRAM_ANALYSIS_CODE = 1 << 0, // First byte of a reachable instruction
+  PROGRAM_ANALYSIS_OPERAND = 1 << 1, // Second byte of a reachable instruction
+  PROGRAM_ANALYSIS_BLOCK_START = 1 << 2,
+  PROGRAM_ANALYSIS_JUMP_TARGET = 1 << 3,
+  PROGRAM_ANALYSIS_SUBROUTINE_ENTRY = 1 << 4,
+};
+
+// How control leaves a basic block
+enum ProgramAnalysisTerminator {
+  TERMINATOR_FALLTHROUGH, // Next instruction starts another block
+  TERMINATOR_JUMP,
+  TERMINATOR_CALL, // successors: called address, return site
+  TERMINATOR_SKIP, // successors: next instruction, skipped instruction
+  TERMINATOR_RETURN,
+  TERMINATOR_INDIRECT, // Bnnn, target depends on V0
+  TERMINATOR_INVALID, // Undecodable instruction or address out of the rom
+};
+
+struct ProgramAnalysisBlock {
+  uint16_t start; // Address of the first instruction
+  uint16_t end; // Address right after the last instruction
+  uint16_t successors[2];
+  uint8_t successor_count;
+  enum ProgramAnalysisTerminator terminator;
+  uint16_t subroutine; // Entry of the subroutine (or program entry) that owns the block
+};
+
+struct ProgramAnalysis {
+  uint8_t memory[PROGRAM_ANALYSIS_MEMORY_SIZE]; // Copy of the analysed image
+  uint8_t flags[PROGRAM_ANALYSIS_MEMORY_SIZE]; // enum ProgramAnalysisByteFlag, per byte
+  uint16_t block_at[PROGRAM_ANALYSIS_MEMORY_SIZE]; // Index of the block that contains each code byte
+  uint16_t load_address; // Also the entry point
+  uint16_t rom_end; // load_address + rom size
+
+  struct ProgramAnalysisBlock blocks[PROGRAM_ANALYSIS_MAX_BLOCKS];
+  uint16_t block_count;
+
+  uint16_t subroutines[PROGRAM_ANALYSIS_MAX_BLOCKS]; // Subroutine entries, sorted by address
+  uint16_t subroutine_count;
+
+  uint16_t code_bytes;
+  uint16_t data_bytes;
+};
+
+// Recovers code, data, basic blocks and subroutines by following control flow
+// from load_address (the entry point). Bytes never reached are considered data.
+void program_analysis_run(struct ProgramAnalysis *analysis, const uint8_t *rom, size_t rom_size, uint16_t load_address);
+
+static inline bool program_analysis_is_code(const struct ProgramAnalysis *analysis, uint16_t address) {
+  return address < PROGRAM_ANALYSIS_MEMORY_SIZE && (analysis->flags[address] & PROGRAM_ANALYSIS_CODE);
+}
+
+static inline uint16_t program_analysis_encoded_instruction_at(const struct ProgramAnalysis *analysis, uint16_t address) {
+  return (analysis->memory[address] << 8) | analysis->memory[(address + 1) % PROGRAM_ANALYSIS_MEMORY_SIZE];
+}
+
+const char *program_analysis_terminator_name(enum ProgramAnalysisTerminator terminator);
+
+// Control flow graph exporters
+void program_analysis_write_dot(const struct ProgramAnalysis *analysis, FILE *output);
+void program_analysis_write_json(const struct ProgramAnalysis *analysis, FILE *output);
@@ -0,0 +1,48 @@
+// Runtime for roms recompiled ahead of time to C by tracua-chip8-recompiler
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "emulated.h"
+
+struct RecompiledRuntime;
+
+// Runs recompiled blocks starting at emulated_system->PC, at most budget instructions.
+// Returns how many ran, 0 when PC is not the start of a block the runtime still trusts.
+typedef unsigned int (*RecompiledRun)(struct RecompiledRuntime *runtime, struct EmulatedSystem *emulated_system, unsigned int budget);
+
+// Emitted by the recompiler, one per rom
+struct RecompiledProgram {
+  const char *rom_name;
+  const uint8_t *rom; // Image the code was recompiled from, loaded at emulated_system_entry_point
+  uint16_t rom_size;
+  int extension; // Quirks baked into the code, a value of EmulatedSystem.extension
+  const uint16_t (*blocks)[2]; // Start and end address of each block
+  uint16_t block_count;
+  RecompiledRun run;
+};
+
+struct RecompiledRuntime {
+  const struct RecompiledProgram *program;
+  EmulatedSystemCore core; // Interpreter for whatever the recompiled code does not cover
+  bool is_code[4096]; // Byte belongs to a recompiled block
+  bool is_disabled[4096]; // Per block, its bytes were overwritten so it runs interpreted
+  uint64_t recompiled_instructions;
+  uint64_t interpreted_instructions;
+};
+
+// Loads the program's rom into emulated_system and gets runtime ready to run it
+void recompiled_runtime_initialize(struct RecompiledRuntime *runtime, const struct RecompiledProgram *program, struct EmulatedSystem *emulated_system);
+
+// Runs count instructions, recompiled where possible and interpreted elsewhere, like as many
+// emulated_system_consume_instruction and core calls would
+void recompiled_runtime_run(struct RecompiledRuntime *runtime, struct EmulatedSystem *emulated_system, unsigned int count);
+
+// For recompiled code: interprets the instruction at address, with registers already stored in emulated_system.
+// Returns false when execution can't go on in the same block (PC moved, the rom overwrote code or stopped).
+bool recompiled_runtime_emulate(struct RecompiledRuntime *runtime, struct EmulatedSystem *emulated_system, uint16_t address);
+
+// Entry point of a recompiled executable: runs the rom headless, optionally against the interpreter
+int recompiled_main(const struct RecompiledProgram *program, int argc, char **argv);
@@ -0,0 +1,18 @@
+// Content hash used to identify roms
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 64-bit FNV-1a
+static inline uint64_t rom_hash(const uint8_t *data, size_t size) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+
+  for (size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= 0x100000001b3ULL;
+  }
+
+  return hash;
+}
@@ -0,0 +1,58 @@
+// Packed rom archive, memory-mapped and looked up by name or content hash
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ROM_LIBRARY_MAGIC "CH8L"
+#define ROM_LIBRARY_VERSION 1
+
+// File layout: header, entries (sorted by hash), names (sorted by name hash), name strings, rom data.
+// Numbers are stored in host byte order.
+struct RomLibraryHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t entry_count;
+  uint32_t name_count;
+  uint64_t entries_offset;
+  uint64_t names_offset;
+  uint64_t strings_offset;
+  uint64_t strings_size;
+};
+
+// One per distinct rom content
+struct RomLibraryEntry {
+  uint64_t hash; // rom_hash() of the rom bytes
+  uint64_t data_offset;
+  uint32_t size;
+  uint32_t padding;
+};
+
+// One per file name, several names may share an entry
+struct RomLibraryName {
+  uint64_t name_hash; // rom_hash() of the name, without the terminator
+  uint32_t entry_index;
+  uint32_t string_offset; // Into the strings section, NUL terminated
+};
+
+struct RomLibrary {
+  const uint8_t *data; // Whole file, NULL when closed
+  size_t size;
+
+  const struct RomLibraryHeader *header;
+  const struct RomLibraryEntry *entries;
+  const struct RomLibraryName *names;
+  const char *strings;
+};
+
+// Maps the library and validates its tables, no rom is read yet
+bool rom_library_open(struct RomLibrary *rom_library, const char *filename);
+void rom_library_close(struct RomLibrary *rom_library);
+
+// key: file name, or a 16 hex digit content hash. rom points into the mapping.
+bool rom_library_find(const struct RomLibrary *rom_library, const char *key, const uint8_t **rom, size_t *rom_size);
+
+// Name of names[index], "" if out of bounds
+const char *rom_library_name(const struct RomLibrary *rom_library, uint32_t index);
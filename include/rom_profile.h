@@ -0,0 +1,44 @@
+// Per-rom static analysis profile, cached on disk by content hash
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ROM_PROFILE_VERSION 5
+
+// Auto-tuner range until --ipf-limits sets one for the rom
+#define ROM_PROFILE_DEFAULT_MINIMUM_INSTRUCTIONS_PER_FRAME 5
+#define ROM_PROFILE_DEFAULT_MAXIMUM_INSTRUCTIONS_PER_FRAME 1000
+
+// What the rom was seen doing, only what picks its quirks. Every rom runs through the predecoded stream,
+// which stays correct and ahead of the plain loop even for roms that store into their own code.
+enum RomProfileFeature {
+  ROM_PROFILE_SUPERCHIP = 1 << 0, // Any SUPER-CHIP only instruction
+  ROM_PROFILE_XOCHIP = 1 << 1, // Any XO-CHIP only instruction
+};
+
+struct RomProfile {
+  uint32_t version; // ROM_PROFILE_VERSION, stale cache entries are discarded
+  uint64_t hash; // rom_hash() of the rom bytes
+  uint32_t size;
+  uint32_t features; // enum RomProfileFeature
+  uint8_t extension; // Quirk set for struct EmulatedSystem->extension
+
+  // Instructions per frame
+  uint16_t instructions_per_frame; // Settled by the auto-tuner, 0 until it has
+  uint16_t instructions_per_frame_minimum; // Range the auto-tuner stays in
+  uint16_t instructions_per_frame_maximum;
+};
+
+// Analyses rom bytes (to be loaded at load_address), without touching the cache.
+// Safe to call from several threads at once, false if memory runs out.
+bool rom_profile_analyze(struct RomProfile *rom_profile, const uint8_t *rom, size_t rom_size, uint16_t load_address);
+
+// Cache access, profiles live in $XDG_CACHE_HOME/tracua-chip8 (or ~/.cache/tracua-chip8)
+bool rom_profile_load(struct RomProfile *rom_profile, uint64_t hash, uint32_t size);
+bool rom_profile_save(const struct RomProfile *rom_profile);
+
+// Reads the cached profile for the rom, analysing (and caching) it when missing, false if it could not be analysed
+bool rom_profile_get(struct RomProfile *rom_profile, const uint8_t *rom, size_t rom_size, uint16_t load_address);
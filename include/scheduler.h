@@ -0,0 +1,44 @@
+// Emulated time: events posted at instruction counts and taken in order as execution reaches them,
+// so guest timing follows instructions executed instead of how often the host calls emulator_update
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SCHEDULER_MAX_EVENTS 16
+#define SCHEDULER_TIMER_HZ 60 // Delay and sound timers, one tick per instructions_per_frame instructions
+
+// Also the order of events due at the same time
+enum SchedulerEventType {
+  SCHEDULER_TIMER_TICK, // Delay and sound timers count down
+  SCHEDULER_AUDIO, // The sound timer started or ran out, the tone follows
+  SCHEDULER_VBLANK, // End of a guest frame, the display is presented
+};
+
+struct SchedulerEvent {
+  uint64_t time; // Instructions executed since start
+  enum SchedulerEventType type;
+};
+
+struct Scheduler {
+  uint64_t now; // Instructions executed since start
+  struct SchedulerEvent events[SCHEDULER_MAX_EVENTS]; // Binary min-heap on time, then type
+  unsigned int event_count;
+};
+
+// Returns false when the queue is full
+bool scheduler_post(struct Scheduler *scheduler, uint64_t time, enum SchedulerEventType type);
+
+// Takes the earliest event if it is due
+bool scheduler_take_due(struct Scheduler *scheduler, struct SchedulerEvent *event);
+
+// Instructions that can run before the next event is due, UINT64_MAX when none is posted
+static inline uint64_t scheduler_until_next(const struct Scheduler *scheduler) {
+  if (scheduler->event_count == 0) return UINT64_MAX;
+  return (scheduler->events[0].time > scheduler->now) ? scheduler->events[0].time - scheduler->now : 0;
+}
+
+static inline void scheduler_advance(struct Scheduler *scheduler, uint64_t instructions) {
+  scheduler->now += instructions;
+}
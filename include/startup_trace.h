@@ -0,0 +1,29 @@
+// Startup trace: when each step between entering main and the first frame happened
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdatomic.h>
+
+#define STARTUP_TRACE_MAX_MARKS 16
+
+struct StartupTrace {
+  bool is_enabled;
+  uint64_t start; // Nanoseconds, CLOCK_MONOTONIC, when main began
+  struct {
+    const char *name;
+    uint64_t at;
+  } marks[STARTUP_TRACE_MAX_MARKS];
+  _Atomic unsigned int mark_count; // The rom is loaded on another thread, it marks its own steps
+};
+
+// Takes the start time, called first thing in main whether or not the trace is enabled later
+void startup_trace_begin(struct StartupTrace *startup_trace);
+
+// Records that the step called name just finished, nothing unless enabled. name must outlive the trace.
+void startup_trace_mark(struct StartupTrace *startup_trace, const char *name);
+
+// Steps in the order they finished, with the time since start and since the previous step
+void startup_trace_report(const struct StartupTrace *startup_trace, FILE *output, const char *rom_name);
@@ -0,0 +1,57 @@
+// Per-instruction execution trace, written to disk by a background thread
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "emulated.h"
+
+#define TRACE_MAGIC "TRC8"
+#define TRACE_VERSION 1
+#define TRACE_RING_RECORDS (1 << 16) // Power of 2
+#define TRACE_NO_REGISTER 0xFF
+
+// Fixed size record, stored in host byte order
+struct TraceRecord {
+  uint16_t PC; // Address the instruction was fetched from
+  uint16_t encoded_instruction;
+  uint16_t I; // After execution
+  uint8_t register_index; // V register the instruction writes (Vx, VF for draw), TRACE_NO_REGISTER for none
+  uint8_t register_value; // After execution
+};
+
+struct TraceFileHeader {
+  char magic[4];
+  uint8_t version;
+  uint8_t record_size;
+  uint16_t load_address;
+};
+
+// Single producer, single consumer ring. Each emulating thread owns its own Trace.
+struct Trace {
+  bool is_open;
+  FILE *output;
+  void *compressed_output; // gzFile, used instead of output when the filename ends in .gz
+
+  struct TraceRecord *records; // TRACE_RING_RECORDS entries
+  _Atomic uint32_t head; // Written by the emulating thread only
+  _Atomic uint32_t tail; // Written by the writer thread only
+  atomic_bool is_closing;
+  pthread_t writer;
+
+  uint64_t stalls; // Times the emulating thread found the ring full and waited for the writer
+};
+
+// A filename ending in .gz is compressed, if built with zlib
+bool trace_open(struct Trace *trace, const char *filename, uint16_t load_address);
+
+// Runs up to count instructions, appending a record for each, returns how many were executed
+unsigned int trace_run(struct Trace *trace, struct EmulatedSystem *emulated_system,
+                       EmulatedSystemCore emulate_decoded_instruction, unsigned int count);
+
+// Drains queued records and stops the writer
+void trace_close(struct Trace *trace);
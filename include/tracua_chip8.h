@@ -0,0 +1,74 @@
+// Embedding API: run the core from a host program without the emulator's main loop.
+// Only this header is needed. Views point into the instance and are valid until it is destroyed.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bumped whenever a function or struct below changes incompatibly
+#define TRACUA_CHIP8_ABI_VERSION 1
+
+typedef struct TracuaChip8 TracuaChip8;
+
+enum TracuaChip8Extension {
+  TRACUA_CHIP8_EXTENSION_AUTO = -1, // Picked by static analysis of the rom
+  TRACUA_CHIP8_EXTENSION_CHIP8 = 0,
+  TRACUA_CHIP8_EXTENSION_SUPERCHIP = 1,
+  TRACUA_CHIP8_EXTENSION_XOCHIP = 2,
+};
+
+// Hosts check format, new ones are only ever added
+enum TracuaChip8DisplayFormat {
+  TRACUA_CHIP8_DISPLAY_BYTES, // One byte per pixel, 0 or 1, row after row
+  TRACUA_CHIP8_DISPLAY_ROWS_U64, // A native uint64_t per row, bit 63 is the leftmost pixel
+};
+
+struct TracuaChip8Display {
+  const void *pixels;
+  uint32_t width;
+  uint32_t height;
+  uint32_t row_stride; // Bytes from one row to the next
+  uint32_t format; // enum TracuaChip8DisplayFormat
+};
+
+// Same layout as the registers inside the instance
+struct TracuaChip8Registers {
+  uint16_t stack[12];
+  uint8_t SP;
+  uint8_t V[16];
+  uint16_t I;
+  uint16_t PC;
+  uint8_t delay_timer;
+  uint8_t sound_timer;
+};
+
+// ABI version the library was built with, compare with TRACUA_CHIP8_ABI_VERSION
+uint32_t tracua_chip8_abi_version(void);
+
+// Copies the rom to 0x200, NULL if it does not fit or memory runs out. May be called from several threads at once.
+TracuaChip8 *tracua_chip8_create(const uint8_t *rom, size_t rom_size, int extension);
+void tracua_chip8_destroy(TracuaChip8 *chip8);
+
+// Both return how many instructions ran, fewer than asked once the program stops (invalid instruction)
+uint64_t tracua_chip8_step_instructions(TracuaChip8 *chip8, uint64_t count);
+// A frame is instructions_per_frame instructions followed by a timer tick
+uint64_t tracua_chip8_step_frames(TracuaChip8 *chip8, uint64_t count);
+
+bool tracua_chip8_is_running(const TracuaChip8 *chip8);
+void tracua_chip8_set_instructions_per_frame(TracuaChip8 *chip8, uint32_t instructions_per_frame);
+void tracua_chip8_set_keypad(TracuaChip8 *chip8, uint16_t keypad); // Bit per key, 0 to F
+
+// Read-only views, no copies
+void tracua_chip8_display(const TracuaChip8 *chip8, struct TracuaChip8Display *display);
+const uint8_t *tracua_chip8_ram(const TracuaChip8 *chip8); // 4096 bytes
+const struct TracuaChip8Registers *tracua_chip8_registers(const TracuaChip8 *chip8);
+
+#ifdef __cplusplus
+}
+#endif
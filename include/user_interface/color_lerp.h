@@ -1,5 +0,0 @@
-// Efeito de "flick" de monitores antigos
-
-#include <stdint.h>
-
-uint32_t user_interface_color_lerp(const uint32_t start_color, const uint32_t end_color, const float t);
\ No newline at end of file
@@ -0,0 +1,75 @@
+// Live frames in a POSIX shared-memory segment: the emulator publishes the display and registers every frame under a
+// sequence lock, any number of local processes map the segment and read it without the emulator ever waiting on them
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#include "emulated.h"
+
+#define FRAME_SHARE_MAGIC 0x53384843u // "CH8S" in memory on little endian hosts
+#define FRAME_SHARE_VERSION 1
+#define FRAME_SHARE_NAME_SIZE 64
+#define FRAME_SHARE_READ_ATTEMPTS 1000 // Torn reads in a row before a reader gives up, the emulator may have died mid-write
+
+// One published frame, fixed layout so tools in other languages can map it
+struct FrameShareFrame {
+  uint64_t frame_number; // Emulator frames so far, this one included, a gap means missed frames or a pause
+  uint64_t display[EMULATED_DISPLAY_HEIGHT]; // Same packing as struct EmulatedSystem->display, bit 63 is the leftmost pixel
+  uint8_t V[16];
+  uint16_t I;
+  uint16_t PC;
+  uint16_t stack[STACK_SIZE];
+  uint8_t SP;
+  uint8_t delay_timer;
+  uint8_t sound_timer;
+  uint8_t extension; // 0 CHIP8, 1 SUPERCHIP, 2 XOCHIP
+  uint32_t instructions_per_frame;
+};
+
+struct FrameShareSegment {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t size; // sizeof struct FrameShareSegment
+  uint32_t owner_pid; // Emulator publishing into it, a segment whose owner is gone was left by a crashed run
+
+  // Odd while the emulator writes frame, even and bumped by 2 per frame otherwise. In its own cache line so
+  // readers polling it don't share one with the header.
+  _Alignas(64) _Atomic uint64_t sequence;
+
+  _Alignas(64) struct FrameShareFrame frame;
+};
+
+// Emulator side
+struct FrameShare {
+  struct FrameShareSegment *segment; // NULL when not publishing
+  char name[FRAME_SHARE_NAME_SIZE];
+};
+
+// Reader side
+struct FrameShareReader {
+  const struct FrameShareSegment *segment;
+  uint64_t last_sequence; // Of the last frame copied, polling only touches the sequence until it moves
+  uint64_t torn_read_count; // Reads retried because the emulator was writing
+};
+
+// Creates the segment /name (a leading / is added when missing). A stale one left by a crashed run or another version
+// is replaced, one another emulator is still publishing into is left alone and false is returned.
+bool frame_share_open(struct FrameShare *frame_share, const char *name);
+
+// Copies the display and registers into the segment, no system call and no lock
+void frame_share_publish(struct FrameShare *frame_share, const struct EmulatedSystem *emulated_system, uint64_t frame_number);
+
+// Unmaps and removes the segment, readers that have it mapped keep their mapping
+void frame_share_close(struct FrameShare *frame_share);
+
+// Maps an existing segment read only, false when it does not exist or was written by another version
+bool frame_share_reader_open(struct FrameShareReader *reader, const char *name);
+
+// Copies the last published frame if it is newer than the one copied before, false when there is no new frame or
+// no consistent copy could be taken
+bool frame_share_read(struct FrameShareReader *reader, struct FrameShareFrame *frame);
+
+void frame_share_reader_close(struct FrameShareReader *reader);
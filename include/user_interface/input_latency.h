@@ -0,0 +1,28 @@
+// Input latency: time from a key event to the first instruction that reads that key
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#define INPUT_LATENCY_BUCKETS 128 // 1 ms each, the last one collects everything slower
+
+struct InputLatency {
+  bool is_enabled;
+  uint16_t pending; // Keys pressed and not yet read by the guest
+  uint64_t pressed_at[16]; // Milliseconds, SDL_GetTicks time base
+  uint32_t histogram[INPUT_LATENCY_BUCKETS];
+  uint32_t sample_count;
+  uint32_t unseen_count; // Released before the guest read them
+};
+
+void input_latency_key_down(struct InputLatency *input_latency, uint8_t key, uint64_t timestamp);
+void input_latency_key_up(struct InputLatency *input_latency, uint8_t key);
+
+// Records pending keys found in observed (bit per key read by Ex9E, ExA1 or Fx0A)
+void input_latency_collect(struct InputLatency *input_latency, uint16_t observed, uint64_t now);
+
+// Percentiles and the non-empty buckets
+void input_latency_report(const struct InputLatency *input_latency, FILE *output, const char *rom_name, uint64_t rom_hash,
+                          unsigned int instructions_per_frame, unsigned int frames_per_second);
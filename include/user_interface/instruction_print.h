@@ -1,4 +1,35 @@
+// Instruction text for every output: disassembler listings, decoded traces and the overlay
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
 #include "instruction.h"
 
+enum InstructionSyntax {
+  INSTRUCTION_SYNTAX_OWN, // ld V10, 3 / or V1, V2, 0 / misc V3, 101, what decoded_instruction_from_string reads back
+  INSTRUCTION_SYNTAX_COWGOD, // LD VA, 0x03 / OR V1, V2 / LD [I], V3, as in Cowgod's Chip-8 technical reference
+};
+
+#define INSTRUCTION_TEXT_SIZE 24 // Longest instruction in either syntax
+
+// Writes the instruction at buffer, which must have room for INSTRUCTION_TEXT_SIZE bytes, and returns its end.
+// No terminator and no stdio, so a caller can build a whole listing in one buffer and write it at once.
+char *instruction_format(char *buffer, struct DecodedInstruction decoded_instruction, enum InstructionSyntax syntax);
+
+// Writes digits lowercase hex digits of value, for the addresses and opcodes around an instruction
+static inline char *instruction_format_hex(char *buffer, uint32_t value, int digits) {
+  static const char hex_digits[] = "0123456789abcdef";
+  for (int i = digits - 1; i >= 0; i--) {
+    buffer[i] = hex_digits[value & 0xF];
+    value >>= 4;
+  }
+  return buffer + digits;
+}
+
 // Prints decoded instruction in a friendly format
 void instruction_decoded_print(struct DecodedInstruction decoded_instruction);
+
+// Same format, written into buffer without the trailing newline. Returns like snprintf.
+int instruction_decoded_sprint(char *buffer, size_t size, struct DecodedInstruction decoded_instruction);
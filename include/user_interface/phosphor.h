@@ -0,0 +1,27 @@
+// Phosphor persistence: pixels fade towards their target colour instead of switching at once
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define PHOSPHOR_PIXELS (64*32)
+#define PHOSPHOR_ROWS 32 // Displays come as a word per row, bit 63 leftmost
+#define PHOSPHOR_WEIGHT_BITS 7 // Fixed-point fraction bits of the fade rate
+
+struct Phosphor {
+  uint32_t pixel_color[PHOSPHOR_PIXELS]; // RGBA, what is currently shown
+  uint64_t last_display[PHOSPHOR_ROWS]; // Display the colours were last stepped towards
+  bool is_settled; // Every pixel reached its target for last_display
+};
+
+// Every pixel starts at bg_color
+void phosphor_reset(struct Phosphor *phosphor, uint32_t bg_color);
+
+// Moves each pixel color_lerp_rate (0 to 1) of the way to fg_color or bg_color, depending on display.
+// Steps round towards the target, so every pixel gets there. Does nothing once settled on the same display.
+void phosphor_update(struct Phosphor *phosphor, const uint64_t *display, uint32_t fg_color, uint32_t bg_color, float color_lerp_rate);
+
+// The kernel itself, returns whether every pixel now equals its target. count is a multiple of 64.
+bool phosphor_step(uint32_t *pixel_color, const uint64_t *display, size_t count, uint32_t fg_color, uint32_t bg_color, uint16_t weight);
@@ -6,6 +6,28 @@
 #include <SDL2/SDL_ttf.h>
 
 #include "emulated.h"
+#include "user_interface/phosphor.h"
+#include "user_interface/input_latency.h"
+
+// Printable ASCII, rasterized once into a single texture
+#define GLYPH_ATLAS_FIRST ' '
+#define GLYPH_ATLAS_LAST '~'
+#define GLYPH_ATLAS_SIZE (GLYPH_ATLAS_LAST - GLYPH_ATLAS_FIRST + 1)
+#define GLYPH_ATLAS_MAX_QUADS 1024 // Glyphs batched per draw call
+
+struct GlyphAtlas {
+  SDL_Texture *texture;
+  int texture_width;
+  int texture_height;
+  int line_height;
+  SDL_Rect glyphs[GLYPH_ATLAS_SIZE]; // Where each glyph sits in the texture
+  int advances[GLYPH_ATLAS_SIZE];
+
+  // Quads queued since the last flush
+  SDL_Vertex vertices[GLYPH_ATLAS_MAX_QUADS * 4];
+  int indices[GLYPH_ATLAS_MAX_QUADS * 6];
+  int quad_count;
+};
 
 struct UserInterface {
   uint32_t desired_window_width;
@@ -21,28 +43,34 @@ struct UserInterface {
   SDL_Window *window;
   SDL_Renderer *renderer;
   SDL_AudioSpec want, have;
-  SDL_AudioDeviceID dev;
-  uint32_t pixel_color[64*32];
+  SDL_AudioDeviceID dev; // 0 until the first sound
+  bool is_audio_unavailable; // Opening it failed, the rom runs silent
+  struct Phosphor phosphor; // Colour shown for each pixel
+  SDL_Keycode keymap[16]; // Key bound to each CHIP8 key, 0 to F
+  struct InputLatency input_latency;
   uint64_t expected_moment_to_draw;
   bool should_play_sound;
-  TTF_Font* font;
+  bool should_reset; // '=' was pressed, the emulator loads the rom again
+  TTF_Font* font; // Opened the first time text is drawn
+  bool is_font_unavailable; // No font could be opened, no text is drawn
   struct {
-    SDL_Surface* message_surface;
+    SDL_Surface* message_surface; // Rendered on the first pause
     SDL_Texture* message;
   } pause_menu;
   struct {
     bool is_active;
-    SDL_Surface* message_surface;
-    SDL_Texture* message;
+    struct GlyphAtlas glyph_atlas; // Created on first use
+    float draw_microseconds; // Moving average of the overlay cost per frame
   } disassembling;
 };
 
-// Misc
-uint32_t user_interface_color_lerp(const uint32_t start_color, const uint32_t end_color, const float t);
-
 // For emulator
 void emulator_user_interface_destroy(struct UserInterface *user_interface);
 void emulator_user_interface_clear_screen(struct UserInterface *user_interface);
 void emulator_user_interface_audio_callback(void *userdata, uint8_t *stream, int len);
+// Sets colors, scale and audio settings without touching SDL (for headless runs)
+void emulator_user_interface_configure_defaults(struct UserInterface *user_interface);
 bool emulator_user_interface_initialize(struct UserInterface *user_interface);
+// keys: 16 characters, the keys for CHIP8 keys 0 to F
+bool emulator_user_interface_set_keymap(struct UserInterface *user_interface, const char *keys);
 void emulator_user_interface_update(struct UserInterface *user_interface, struct EmulatedSystem *emulated_system);
@@ -0,0 +1,50 @@
+// Raw video output of every emulated frame (Y4M or RGBA), for headless recording
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include "emulated.h"
+#include "user_interface/phosphor.h"
+
+#define VIDEO_STREAM_WIDTH 64
+#define VIDEO_STREAM_HEIGHT 32
+#define VIDEO_STREAM_SLOTS 8 // Frames queued for the writer thread
+
+struct VideoStream {
+  FILE *output; // NULL when not recording
+  enum {
+    VIDEO_STREAM_Y4M, // YUV 4:4:4, readable by ffmpeg and most encoders
+    VIDEO_STREAM_RGBA, // Raw RGBA bytes, 64x32 per frame
+  } format;
+
+  uint32_t fg_color;
+  uint32_t bg_color;
+  float color_lerp_rate;
+  struct Phosphor phosphor; // Same fading as UserInterface->phosphor
+
+  // Ring of encoded frames, filled by the emulator and drained by the writer thread
+  uint8_t *slots;
+  size_t frame_size;
+  unsigned int head;
+  unsigned int tail;
+  unsigned int count;
+  bool is_closing;
+  pthread_t writer;
+  pthread_mutex_t lock;
+  pthread_cond_t not_empty;
+  pthread_cond_t not_full;
+};
+
+// filename "-" writes to stdout
+bool video_stream_open(struct VideoStream *video_stream, const char *filename, int format,
+                       uint32_t fg_color, uint32_t bg_color, float color_lerp_rate, unsigned int frames_per_second);
+
+// Encodes the current display into the next free slot, waits if the writer fell behind
+void video_stream_push_frame(struct VideoStream *video_stream, const struct EmulatedSystem *emulated_system);
+
+// Flushes queued frames and stops the writer
+void video_stream_close(struct VideoStream *video_stream);
@@ -0,0 +1,25 @@
+// COSMAC VIP timing: instructions are charged machine cycles instead of a flat count per frame
+
+#pragma once
+
+#include <stdint.h>
+
+#include "emulated.h"
+
+// 1.7609 MHz clock, 8 clock cycles per machine cycle, 60 display interrupts per second
+#define VIP_CYCLES_PER_FRAME 3668
+// Taken from every frame by the display interrupt: 128 lines of 8 bytes of DMA, plus the routine itself
+#define VIP_DISPLAY_CYCLES (1024 + 46)
+
+struct VipTiming {
+  uint64_t cycle_count; // Machine cycles since start
+  uint64_t next_interrupt; // Cycle count of the next display interrupt
+};
+
+// Approximate cost of an instruction in machine cycles, including fetch and dispatch
+uint32_t vip_timing_cycles(uint16_t encoded_instruction);
+
+// Runs the display interrupt (timers, DMA) and then instructions until the next one, returns how many ran.
+// DRAW waits for the next interrupt, as the VIP interpreter does.
+unsigned int vip_timing_run_frame(struct VipTiming *vip_timing, struct EmulatedSystem *emulated_system,
+                                  EmulatedSystemCore emulate_decoded_instruction);
@@ -0,0 +1,289 @@
+// Recursive descent disassembly and basic block recovery
+
+#include <string.h>
+
+#include "program_analysis.h"
+
+static inline bool program_analysis_in_rom(const struct ProgramAnalysis *analysis, uint32_t address) {
+    return address >= analysis->load_address
+        && address < analysis->rom_end
+        && address + 1 < PROGRAM_ANALYSIS_MEMORY_SIZE;
+}
+
+static inline bool program_analysis_is_skip(enum DecodedInstructionType type) {
+    return type == IF_EQUAL_THEN_SKIP
+        || type == IF_NOT_EQUAL_THEN_SKIP
+        || type == IF_PRESSED_THEN_SKIP
+        || type == IF_NOT_PRESSED_THEN_SKIP;
+}
+
+// Marks every instruction reachable from the entry point, along with block leaders
+static void program_analysis_trace_code(struct ProgramAnalysis *analysis) {
+    // Each instruction pushes at most one address, so this can't overflow
+    uint16_t pending[PROGRAM_ANALYSIS_MEMORY_SIZE + 1];
+    uint16_t pending_count = 0;
+
+    pending[pending_count++] = analysis->load_address;
+    analysis->flags[analysis->load_address] |= PROGRAM_ANALYSIS_BLOCK_START;
+
+    while (pending_count > 0) {
+        uint16_t address = pending[--pending_count];
+        bool keep_going = true;
+
+        while (keep_going && program_analysis_in_rom(analysis, address) && !program_analysis_is_code(analysis, address)) {
+            const struct DecodedInstruction decoded_instruction = decoded_instruction_from_encoded_instruction(
+                program_analysis_encoded_instruction_at(analysis, address)
+            );
+
+            analysis->flags[address] |= PROGRAM_ANALYSIS_CODE;
+            analysis->flags[address + 1] |= PROGRAM_ANALYSIS_OPERAND;
+
+            switch (decoded_instruction.type) {
+                case JUMP:
+                    analysis->flags[decoded_instruction.address] |= PROGRAM_ANALYSIS_BLOCK_START | PROGRAM_ANALYSIS_JUMP_TARGET;
+                    pending[pending_count++] = decoded_instruction.address;
+                    keep_going = false;
+                    break;
+                case SUBROUTINE:
+                    analysis->flags[decoded_instruction.address] |= PROGRAM_ANALYSIS_BLOCK_START | PROGRAM_ANALYSIS_SUBROUTINE_ENTRY;
+                    pending[pending_count++] = decoded_instruction.address;
+                    // Return site
+                    address += 2;
+                    analysis->flags[address % PROGRAM_ANALYSIS_MEMORY_SIZE] |= PROGRAM_ANALYSIS_BLOCK_START;
+                    break;
+                case IF_EQUAL_THEN_SKIP:
+                case IF_NOT_EQUAL_THEN_SKIP:
+                case IF_PRESSED_THEN_SKIP:
+                case IF_NOT_PRESSED_THEN_SKIP:
+                    if (address + 4 < PROGRAM_ANALYSIS_MEMORY_SIZE) {
+                        analysis->flags[address + 2] |= PROGRAM_ANALYSIS_BLOCK_START;
+                        analysis->flags[address + 4] |= PROGRAM_ANALYSIS_BLOCK_START;
+                        pending[pending_count++] = address + 4;
+                    }
+                    address += 2;
+                    break;
+                case RETURN:
+                case JUMP_WITH_OFFSET:
+                case INVALID:
+                    keep_going = false;
+                    break;
+                default:
+                    address += 2;
+                    break;
+            }
+        }
+    }
+}
+
+static enum ProgramAnalysisTerminator program_analysis_terminator_of(enum DecodedInstructionType type) {
+    switch (type) {
+        case JUMP: return TERMINATOR_JUMP;
+        case SUBROUTINE: return TERMINATOR_CALL;
+        case RETURN: return TERMINATOR_RETURN;
+        case JUMP_WITH_OFFSET: return TERMINATOR_INDIRECT;
+        case INVALID: return TERMINATOR_INVALID;
+        default:
+            return program_analysis_is_skip(type) ? TERMINATOR_SKIP : TERMINATOR_FALLTHROUGH;
+    }
+}
+
+// Splits traced code into basic blocks
+static void program_analysis_build_blocks(struct ProgramAnalysis *analysis) {
+    struct ProgramAnalysisBlock *block = NULL;
+
+    for (uint32_t address = analysis->load_address; address < analysis->rom_end; address++) {
+        if (!program_analysis_is_code(analysis, address)) continue;
+
+        if (block == NULL || (analysis->flags[address] & PROGRAM_ANALYSIS_BLOCK_START)) {
+            block = &analysis->blocks[analysis->block_count++];
+            *block = (struct ProgramAnalysisBlock){ .start = address, .terminator = TERMINATOR_FALLTHROUGH };
+        }
+
+        analysis->block_at[address] = analysis->block_count - 1;
+        analysis->block_at[address + 1] = analysis->block_count - 1;
+        block->end = address + 2;
+
+        const struct DecodedInstruction decoded_instruction = decoded_instruction_from_encoded_instruction(
+            program_analysis_encoded_instruction_at(analysis, address)
+        );
+        block->terminator = program_analysis_terminator_of(decoded_instruction.type);
+
+        switch (block->terminator) {
+            case TERMINATOR_JUMP:
+                block->successors[block->successor_count++] = decoded_instruction.address;
+                break;
+            case TERMINATOR_CALL:
+                block->successors[block->successor_count++] = decoded_instruction.address;
+                block->successors[block->successor_count++] = address + 2;
+                break;
+            case TERMINATOR_SKIP:
+                block->successors[block->successor_count++] = address + 2;
+                block->successors[block->successor_count++] = address + 4;
+                break;
+            case TERMINATOR_FALLTHROUGH: {
+                const uint32_t next = address + 2;
+                if (!program_analysis_is_code(analysis, next) || (analysis->flags[next] & PROGRAM_ANALYSIS_BLOCK_START)) {
+                    // Running into another block (or off the traced code)
+                    if (program_analysis_is_code(analysis, next))
+                        block->successors[block->successor_count++] = next;
+                    else
+                        block->terminator = TERMINATOR_INVALID;
+                    block = NULL;
+                }
+                // Instruction pair was consumed
+                address++;
+                continue;
+            }
+            case TERMINATOR_RETURN:
+            case TERMINATOR_INDIRECT:
+            case TERMINATOR_INVALID:
+                break;
+        }
+
+        block = NULL;
+        address++;
+    }
+}
+
+// Assigns each block to the first subroutine (or the main program) that reaches it
+// without crossing a call edge
+static void program_analysis_assign_subroutines(struct ProgramAnalysis *analysis) {
+    uint16_t queue[PROGRAM_ANALYSIS_MAX_BLOCKS];
+    bool visited[PROGRAM_ANALYSIS_MAX_BLOCKS] = {0};
+
+    // Program entry first, then subroutines in address order
+    analysis->subroutine_count = 0;
+    for (uint32_t address = analysis->load_address; address < analysis->rom_end; address++) {
+        if ((analysis->flags[address] & PROGRAM_ANALYSIS_SUBROUTINE_ENTRY) && program_analysis_is_code(analysis, address))
+            analysis->subroutines[analysis->subroutine_count++] = address;
+    }
+
+    for (int32_t i = -1; i < (int32_t)analysis->subroutine_count; i++) {
+        const uint16_t entry = (i < 0) ? analysis->load_address : analysis->subroutines[i];
+        if (!program_analysis_is_code(analysis, entry)) continue;
+
+        uint16_t queue_head = 0, queue_tail = 0;
+        const uint16_t entry_block = analysis->block_at[entry];
+        if (visited[entry_block]) continue;
+
+        visited[entry_block] = true;
+        queue[queue_tail++] = entry_block;
+
+        while (queue_head < queue_tail) {
+            struct ProgramAnalysisBlock *block = &analysis->blocks[queue[queue_head++]];
+            block->subroutine = entry;
+
+            for (uint8_t j = 0; j < block->successor_count; j++) {
+                // The callee belongs to itself, only the return site stays here
+                if (block->terminator == TERMINATOR_CALL && j == 0) continue;
+                if (!program_analysis_is_code(analysis, block->successors[j])) continue;
+
+                const uint16_t successor = analysis->block_at[block->successors[j]];
+                if (!visited[successor]) {
+                    visited[successor] = true;
+                    queue[queue_tail++] = successor;
+                }
+            }
+        }
+    }
+}
+
+void program_analysis_run(struct ProgramAnalysis *analysis, const uint8_t *rom, size_t rom_size, uint16_t load_address) {
+    memset(analysis, 0, sizeof(struct ProgramAnalysis));
+    memset(analysis->block_at, 0xFF, sizeof analysis->block_at);
+
+    if (load_address >= PROGRAM_ANALYSIS_MEMORY_SIZE) return;
+    if (rom_size > (size_t)(PROGRAM_ANALYSIS_MEMORY_SIZE - load_address))
+        rom_size = PROGRAM_ANALYSIS_MEMORY_SIZE - load_address;
+
+    memcpy(&analysis->memory[load_address], rom, rom_size);
+    analysis->load_address = load_address;
+    analysis->rom_end = load_address + rom_size;
+
+    program_analysis_trace_code(analysis);
+    program_analysis_build_blocks(analysis);
+    program_analysis_assign_subroutines(analysis);
+
+    for (uint32_t address = load_address; address < analysis->rom_end; address++) {
+        if (analysis->flags[address] & (PROGRAM_ANALYSIS_CODE | PROGRAM_ANALYSIS_OPERAND)) analysis->code_bytes++;
+        else analysis->data_bytes++;
+    }
+}
+
+const char *program_analysis_terminator_name(enum ProgramAnalysisTerminator terminator) {
+    switch (terminator) {
+        case TERMINATOR_FALLTHROUGH: return "fallthrough";
+        case TERMINATOR_JUMP: return "jump";
+        case TERMINATOR_CALL: return "call";
+        case TERMINATOR_SKIP: return "skip";
+        case TERMINATOR_RETURN: return "return";
+        case TERMINATOR_INDIRECT: return "indirect";
+        case TERMINATOR_INVALID:
+        default:
+            return "invalid";
+    }
+}
+
+void program_analysis_write_dot(const struct ProgramAnalysis *analysis, FILE *output) {
+    fprintf(output, "digraph rom {\n");
+    fprintf(output, "  node [shape=box fontname=\"monospace\"];\n");
+
+    for (uint16_t i = 0; i < analysis->subroutine_count + 1; i++) {
+        const uint16_t entry = (i == 0) ? analysis->load_address : analysis->subroutines[i - 1];
+
+        fprintf(output, "  subgraph \"cluster_0x%03x\" {\n", entry);
+        fprintf(output, "    label=\"%s 0x%03x\";\n", (i == 0) ? "main" : "sub", entry);
+
+        for (uint16_t j = 0; j < analysis->block_count; j++) {
+            const struct ProgramAnalysisBlock *block = &analysis->blocks[j];
+            if (block->subroutine != entry) continue;
+
+            fprintf(output, "    \"0x%03x\" [label=\"", block->start);
+            for (uint16_t address = block->start; address < block->end; address += 2)
+                fprintf(output, "0x%03x: %04x\\l", address, program_analysis_encoded_instruction_at(analysis, address));
+            fprintf(output, "\"];\n");
+        }
+        fprintf(output, "  }\n");
+    }
+
+    for (uint16_t i = 0; i < analysis->block_count; i++) {
+        const struct ProgramAnalysisBlock *block = &analysis->blocks[i];
+
+        for (uint8_t j = 0; j < block->successor_count; j++) {
+            const char *style = "";
+            if (block->terminator == TERMINATOR_CALL && j == 0) style = " [style=dashed label=\"call\"]";
+            else if (block->terminator == TERMINATOR_SKIP && j == 1) style = " [label=\"skip\"]";
+
+            fprintf(output, "  \"0x%03x\" -> \"0x%03x\"%s;\n", block->start, block->successors[j], style);
+        }
+    }
+
+    fprintf(output, "}\n");
+}
+
+void program_analysis_write_json(const struct ProgramAnalysis *analysis, FILE *output) {
+    fprintf(output, "{\n");
+    fprintf(output, "  \"entry\": %u,\n", analysis->load_address);
+    fprintf(output, "  \"rom_end\": %u,\n", analysis->rom_end);
+    fprintf(output, "  \"code_bytes\": %u,\n", analysis->code_bytes);
+    fprintf(output, "  \"data_bytes\": %u,\n", analysis->data_bytes);
+
+    fprintf(output, "  \"subroutines\": [");
+    for (uint16_t i = 0; i < analysis->subroutine_count; i++)
+        fprintf(output, "%s%u", (i == 0) ? "" : ", ", analysis->subroutines[i]);
+    fprintf(output, "],\n");
+
+    fprintf(output, "  \"blocks\": [\n");
+    for (uint16_t i = 0; i < analysis->block_count; i++) {
+        const struct ProgramAnalysisBlock *block = &analysis->blocks[i];
+
+        fprintf(output, "    {\"start\": %u, \"end\": %u, \"subroutine\": %u, \"terminator\": \"%s\", \"successors\": [",
+                block->start, block->end, block->subroutine, program_analysis_terminator_name(block->terminator));
+        for (uint8_t j = 0; j < block->successor_count; j++)
+            fprintf(output, "%s%u", (j == 0) ? "" : ", ", block->successors[j]);
+        fprintf(output, "]}%s\n", (i + 1 < analysis->block_count) ? "," : "");
+    }
+    fprintf(output, "  ]\n");
+
+    fprintf(output, "}\n");
+}
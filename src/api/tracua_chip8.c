@@ -0,0 +1,120 @@
+// Embedding API over struct EmulatedSystem
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "tracua_chip8.h"
+#include "emulated.h"
+#include "rom_profile.h"
+
+// The registers view points straight into struct EmulatedSystem
+#define TRACUA_CHIP8_SAME_OFFSET(field) \
+    _Static_assert(offsetof(struct EmulatedSystem, field) - offsetof(struct EmulatedSystem, stack) \
+                   == offsetof(struct TracuaChip8Registers, field), #field " moved in struct EmulatedSystem")
+
+TRACUA_CHIP8_SAME_OFFSET(stack);
+TRACUA_CHIP8_SAME_OFFSET(SP);
+TRACUA_CHIP8_SAME_OFFSET(V);
+TRACUA_CHIP8_SAME_OFFSET(I);
+TRACUA_CHIP8_SAME_OFFSET(PC);
+TRACUA_CHIP8_SAME_OFFSET(delay_timer);
+TRACUA_CHIP8_SAME_OFFSET(sound_timer);
+_Static_assert(sizeof ((struct EmulatedSystem *)0)->stack == sizeof ((struct TracuaChip8Registers *)0)->stack, "stack size changed");
+
+struct TracuaChip8 {
+    struct EmulatedSystem emulated_system;
+    EmulatedSystemCore emulate_decoded_instruction; // Picked once, the extension only changes at creation
+};
+
+uint32_t tracua_chip8_abi_version(void) {
+    return TRACUA_CHIP8_ABI_VERSION;
+}
+
+TracuaChip8 *tracua_chip8_create(const uint8_t *rom, size_t rom_size, int extension) {
+    if (rom_size == 0 || rom_size > sizeof ((struct EmulatedSystem *)0)->ram - emulated_system_entry_point) return NULL;
+
+    TracuaChip8 *chip8 = aligned_alloc(_Alignof(TracuaChip8), sizeof *chip8);
+    if (!chip8) return NULL;
+
+    emulated_system_initialize(&chip8->emulated_system);
+    memcpy(&chip8->emulated_system.ram[emulated_system_entry_point], rom, rom_size);
+
+    if (extension == TRACUA_CHIP8_EXTENSION_AUTO) {
+        // No profile cache, hosts may run many instances and expect no files to appear
+        struct RomProfile rom_profile;
+        if (!rom_profile_analyze(&rom_profile, rom, rom_size, emulated_system_entry_point)) {
+            free(chip8);
+            return NULL;
+        }
+        chip8->emulated_system.extension = rom_profile.extension;
+    }
+    else {
+        chip8->emulated_system.extension = extension;
+    }
+
+    chip8->emulate_decoded_instruction = emulated_system_core(&chip8->emulated_system);
+    return chip8;
+}
+
+void tracua_chip8_destroy(TracuaChip8 *chip8) {
+    free(chip8);
+}
+
+uint64_t tracua_chip8_step_instructions(TracuaChip8 *chip8, uint64_t count) {
+    struct EmulatedSystem *emulated_system = &chip8->emulated_system;
+    const EmulatedSystemCore emulate_decoded_instruction = chip8->emulate_decoded_instruction;
+    uint64_t executed = 0;
+
+    while (executed < count && emulated_system->state == RUNNING) {
+        if (!emulated_system_consume_instruction(emulated_system)) break;
+        emulate_decoded_instruction(emulated_system);
+        executed++;
+    }
+
+    return executed;
+}
+
+uint64_t tracua_chip8_step_frames(TracuaChip8 *chip8, uint64_t count) {
+    struct EmulatedSystem *emulated_system = &chip8->emulated_system;
+    uint64_t executed = 0;
+
+    for (uint64_t frame = 0; frame < count && emulated_system->state == RUNNING; frame++) {
+        executed += tracua_chip8_step_instructions(chip8, emulated_system->instructions_per_frame);
+
+        if (emulated_system->delay_timer > 0) emulated_system->delay_timer--;
+        if (emulated_system->sound_timer > 0) emulated_system->sound_timer--;
+    }
+
+    return executed;
+}
+
+bool tracua_chip8_is_running(const TracuaChip8 *chip8) {
+    return chip8->emulated_system.state == RUNNING;
+}
+
+void tracua_chip8_set_instructions_per_frame(TracuaChip8 *chip8, uint32_t instructions_per_frame) {
+    chip8->emulated_system.instructions_per_frame = instructions_per_frame;
+}
+
+void tracua_chip8_set_keypad(TracuaChip8 *chip8, uint16_t keypad) {
+    chip8->emulated_system.keypad = keypad;
+}
+
+void tracua_chip8_display(const TracuaChip8 *chip8, struct TracuaChip8Display *display) {
+    *display = (struct TracuaChip8Display){
+        .pixels = chip8->emulated_system.display,
+        .width = EMULATED_DISPLAY_WIDTH,
+        .height = EMULATED_DISPLAY_HEIGHT,
+        .row_stride = sizeof chip8->emulated_system.display[0],
+        .format = TRACUA_CHIP8_DISPLAY_ROWS_U64,
+    };
+}
+
+const uint8_t *tracua_chip8_ram(const TracuaChip8 *chip8) {
+    return chip8->emulated_system.ram;
+}
+
+const struct TracuaChip8Registers *tracua_chip8_registers(const TracuaChip8 *chip8) {
+    return (const struct TracuaChip8Registers *)chip8->emulated_system.stack;
+}
@@ -0,0 +1,240 @@
+// Two passes over the source: label addresses first, then bytes
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "assembler.h"
+#include "instruction.h"
+
+struct Assembler {
+    const char *source_name;
+    unsigned int line_number;
+    struct AssemblerLabel labels[ASSEMBLER_MAX_LABELS];
+    unsigned int label_count;
+};
+
+static inline bool assembler_is_identifier_start(char c) {
+    return isalpha((unsigned char)c) || c == '_';
+}
+
+static inline bool assembler_is_identifier(char c) {
+    return isalnum((unsigned char)c) || c == '_';
+}
+
+static void assembler_error(const struct Assembler *assembler, const char *message, const char *detail) {
+    fprintf(stderr, "%s:%u: %s%s\n", assembler->source_name, assembler->line_number, message, detail);
+}
+
+static const struct AssemblerLabel *assembler_find_label(const struct Assembler *assembler, const char *name, size_t length) {
+    for (unsigned int i = 0; i < assembler->label_count; i++) {
+        if (strlen(assembler->labels[i].name) == length && strncmp(assembler->labels[i].name, name, length) == 0)
+            return &assembler->labels[i];
+    }
+    return NULL;
+}
+
+// Registers and I read like identifiers, they are never labels
+static bool assembler_is_reserved(const char *token, size_t length) {
+    if (length == 1) return *token == 'I' || *token == 'i';
+    if (*token != 'V' && *token != 'v') return false;
+
+    if (length == 2) return isxdigit((unsigned char)token[1]);
+    for (size_t i = 1; i < length; i++) {
+        if (!isdigit((unsigned char)token[i])) return false;
+    }
+    return true;
+}
+
+// Copies the line with every label operand replaced by its address
+static bool assembler_resolve_labels(const struct Assembler *assembler, const char *line, char *resolved) {
+    size_t length = 0;
+
+    // Mnemonic
+    while (assembler_is_identifier(*line) && length < ASSEMBLER_LINE_SIZE - 8) resolved[length++] = *line++;
+
+    while (*line) {
+        if (!assembler_is_identifier(*line)) {
+            resolved[length++] = *line++;
+        }
+        else if (!assembler_is_identifier_start(*line) || length == 0 || assembler_is_identifier(resolved[length - 1])) {
+            // Numbers, and the rest of a word already being copied
+            resolved[length++] = *line++;
+        }
+        else {
+            const char *name = line;
+            while (assembler_is_identifier(*line)) line++;
+            const size_t name_length = line - name;
+
+            const struct AssemblerLabel *label = assembler_find_label(assembler, name, name_length);
+            if (assembler_is_reserved(name, name_length) && name_length < ASSEMBLER_LINE_SIZE - 8 - length) {
+                memcpy(&resolved[length], name, name_length);
+                length += name_length;
+            }
+            else if (label) {
+                length += snprintf(&resolved[length], 8, "0x%03x", label->address);
+            }
+            else {
+                char unknown[ASSEMBLER_LINE_SIZE];
+                snprintf(unknown, sizeof unknown, "%.*s", (int)name_length, name);
+                assembler_error(assembler, "Unknown label ", unknown);
+                return false;
+            }
+        }
+
+        if (length >= ASSEMBLER_LINE_SIZE - 8) {
+            assembler_error(assembler, "Line too long", "");
+            return false;
+        }
+    }
+
+    resolved[length] = '\0';
+    return true;
+}
+
+bool assembler_assemble(const char *source, size_t source_size, const char *source_name, uint16_t load_address,
+                        uint8_t *output, size_t capacity, size_t *output_size) {
+    struct Assembler assembler = { .source_name = source_name };
+
+    // Labels are known after the first pass, bytes are only written by the second
+    for (int pass = 0; pass < 2; pass++) {
+        const char *cursor = source;
+        const char *const end = source + source_size;
+        size_t size = 0;
+        assembler.line_number = 0;
+
+        while (cursor < end) {
+            const char *line_end = memchr(cursor, '\n', end - cursor);
+            if (!line_end) line_end = end;
+
+            char line[ASSEMBLER_LINE_SIZE];
+            const size_t line_length = line_end - cursor;
+            assembler.line_number++;
+
+            if (line_length >= sizeof line) {
+                assembler_error(&assembler, "Line too long", "");
+                return false;
+            }
+            memcpy(line, cursor, line_length);
+            line[line_length] = '\0';
+            cursor = line_end + 1;
+
+            char *comment = strchr(line, ';');
+            if (comment) *comment = '\0';
+
+            char *statement = line;
+            while (isspace((unsigned char)*statement)) statement++;
+
+            // Label
+            char *word_end = statement;
+            while (assembler_is_identifier(*word_end)) word_end++;
+            if (word_end != statement && assembler_is_identifier_start(*statement) && *word_end == ':') {
+                const size_t name_length = word_end - statement;
+
+                if (pass == 0) {
+                    if (name_length >= ASSEMBLER_LABEL_SIZE || assembler_is_reserved(statement, name_length)) {
+                        assembler_error(&assembler, "Invalid label name", "");
+                        return false;
+                    }
+                    else if (assembler_find_label(&assembler, statement, name_length)) {
+                        assembler_error(&assembler, "Label defined twice", "");
+                        return false;
+                    }
+                    else if (assembler.label_count == ASSEMBLER_MAX_LABELS) {
+                        assembler_error(&assembler, "Too many labels", "");
+                        return false;
+                    }
+
+                    struct AssemblerLabel *label = &assembler.labels[assembler.label_count++];
+                    memcpy(label->name, statement, name_length);
+                    label->name[name_length] = '\0';
+                    label->address = (uint16_t)(load_address + size);
+                }
+
+                statement = word_end + 1;
+                while (isspace((unsigned char)*statement)) statement++;
+            }
+
+            size_t statement_length = strlen(statement);
+            while (statement_length > 0 && isspace((unsigned char)statement[statement_length - 1])) statement[--statement_length] = '\0';
+            if (statement_length == 0) continue;
+
+            // Data
+            if (strncmp(statement, "db", 2) == 0 && (statement[2] == '\0' || isspace((unsigned char)statement[2]))) {
+                for (char *number = statement + 2; ; number++) {
+                    char *number_end;
+                    const unsigned long byte = strtoul(number, &number_end, 0);
+                    while (isspace((unsigned char)*number_end)) number_end++;
+
+                    if (number_end == number || byte > 0xFF || (*number_end != ',' && *number_end != '\0')) {
+                        assembler_error(&assembler, "Invalid byte in ", statement);
+                        return false;
+                    }
+                    else if (size >= capacity) {
+                        assembler_error(&assembler, "Program does not fit in memory", "");
+                        return false;
+                    }
+
+                    if (pass == 1) output[size] = (uint8_t)byte;
+                    size++;
+
+                    if (*number_end == '\0') break;
+                    number = number_end;
+                }
+                continue;
+            }
+
+            // Instruction
+            if (size + 2 > capacity) {
+                assembler_error(&assembler, "Program does not fit in memory", "");
+                return false;
+            }
+
+            if (pass == 1) {
+                char resolved[ASSEMBLER_LINE_SIZE];
+                if (!assembler_resolve_labels(&assembler, statement, resolved)) return false;
+
+                const struct DecodedInstruction decoded_instruction = decoded_instruction_from_string(resolved);
+                if (decoded_instruction.type == INVALID) {
+                    assembler_error(&assembler, "Can't assemble ", statement);
+                    return false;
+                }
+
+                const uint16_t encoded_instruction = encoded_instruction_from_decoded_instruction(decoded_instruction);
+                output[size] = encoded_instruction >> 8;
+                output[size + 1] = encoded_instruction & 0xFF;
+            }
+            size += 2;
+        }
+
+        *output_size = size;
+    }
+
+    return true;
+}
+
+bool assembler_assemble_file(const char *source_name, uint16_t load_address, uint8_t *output, size_t capacity, size_t *output_size) {
+    FILE *file = fopen(source_name, "rb");
+    if (!file) {
+        fprintf(stderr, "Source file %s is invalid or does not exist\n", source_name);
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    const long source_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char *source = (source_size > 0) ? malloc(source_size) : NULL;
+    if (!source || fread(source, 1, source_size, file) != (size_t)source_size) {
+        fprintf(stderr, "Could not read source file %s\n", source_name);
+        fclose(file);
+        free(source);
+        return false;
+    }
+    fclose(file);
+
+    const bool is_assembled = assembler_assemble(source, source_size, source_name, load_address, output, capacity, output_size);
+    free(source);
+    return is_assembled;
+}
@@ -3,7 +3,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 
-#include "instruction.h"
+#include "assembler.h"
 
 struct Assembler {
     const char *input_filename;
@@ -14,10 +14,10 @@ static const char *const usage = "Usage: tracuachip8-assembler --input <input_fi
 
 static bool consume_command_line_arguments(struct Assembler *assembler, int argc, char **argv) {
    for (int i = 1; i < argc; i++) {
-        if (strncmp(argv[i], "--output", strlen("--output")) == 0) {
+        if (strncmp(argv[i], "--output", strlen("--output")) == 0 && i + 1 < argc) {
             assembler->output_filename = argv[++i];
         }
-        else if (strncmp(argv[i], "--input", strlen("--input")) == 0) {
+        else if (strncmp(argv[i], "--input", strlen("--input")) == 0 && i + 1 < argc) {
             assembler->input_filename = argv[++i];
         }
     }
@@ -26,7 +26,7 @@ static bool consume_command_line_arguments(struct Assembler *assembler, int argc
         fprintf(stderr, "No input filename.\n");
         return false;
     }
-    else if (assembler->input_filename == NULL) {
+    else if (assembler->output_filename == NULL) {
         fprintf(stderr, "No output filename.\n");
         return false;
     }
@@ -38,28 +38,22 @@ int main(int argc, char **argv) {
     struct Assembler assembler = {0};
 
     if (!consume_command_line_arguments(&assembler, argc, argv)) {
-        fprintf(stderr, usage);
+        fputs(usage, stderr);
         return EXIT_FAILURE;
     }
 
-    char source_line[100] = {0};
+    // Loaded at 0x200, everything up to the end of RAM
+    uint8_t rom[4096 - 0x200];
+    size_t rom_size;
+    if (!assembler_assemble_file(assembler.input_filename, 0x200, rom, sizeof rom, &rom_size)) return EXIT_FAILURE;
 
-    FILE *input_file = fopen(assembler.input_filename, "rb");
-    if (!input_file) {
-        fprintf(stderr, "Source file %s is invalid or does not exist\n", assembler.input_filename);
+    FILE *output_file = fopen(assembler.output_filename, "wb");
+    if (!output_file || fwrite(rom, 1, rom_size, output_file) != rom_size) {
+        fprintf(stderr, "Could not write %s\n", assembler.output_filename);
+        if (output_file) fclose(output_file);
         return EXIT_FAILURE;
     }
-
-    while (fgets(source_line, sizeof(source_line), input_file) != NULL) {
-        struct DecodedInstruction decoded_instruction = decoded_instruction_from_string(source_line);
-
-        // TODO: translate labels as operands to memory adresses, constants, variables, etc.
-
-        printf("%s", source_line);
-
-        uint16_t encoded_instruction = encoded_instruction_from_decoded_instruction(decoded_instruction);
-        printf("%04x\n", encoded_instruction);
-    }
+    fclose(output_file);
 
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -0,0 +1,32 @@
+// Cost of the debug dispatch loop, breakpoints are placed where they never hit
+
+static void benchmark_breakpoints(const struct BenchmarkOptions *options) {
+    static struct EmulatedSystem emulated_system;
+    static struct Debugger debugger;
+
+    if (!benchmark_load(&emulated_system, options)) return;
+    const EmulatedSystemCore emulate_decoded_instruction = emulated_system_core(&emulated_system);
+
+    const double seconds = benchmark_run_core(&emulated_system, emulate_decoded_instruction, options->instructions);
+    benchmark_report("no debugger", options->instructions, seconds);
+
+    const unsigned int breakpoint_counts[] = {0, 1, 1000};
+
+    for (size_t i = 0; i < sizeof breakpoint_counts / sizeof breakpoint_counts[0]; i++) {
+        if (!benchmark_load(&emulated_system, options)) return;
+
+        debugger = (struct Debugger){ .is_active = true };
+        // Odd addresses, instructions are fetched from even ones
+        for (unsigned int j = 0; j < breakpoint_counts[i]; j++) debugger_add_breakpoint(&debugger, 0x201 + 2 * j, NULL);
+
+        const uint64_t start = benchmark_now_ns();
+        uint64_t executed = 0;
+        while (executed < options->instructions && emulated_system.state == RUNNING)
+            executed += debugger_run(&debugger, &emulated_system, emulate_decoded_instruction, 1000);
+        const double debug_seconds = (benchmark_now_ns() - start) / 1e9;
+
+        char name[64];
+        snprintf(name, sizeof name, "debug dispatch, %u breakpoints", breakpoint_counts[i]);
+        benchmark_report(name, executed, debug_seconds);
+    }
+}
@@ -0,0 +1,24 @@
+// Cost of runtime quirk checks, compared to the specialized cores
+
+static void benchmark_cores(const struct BenchmarkOptions *options) {
+    static struct EmulatedSystem emulated_system;
+
+    const struct {
+        const char *name;
+        int extension;
+        EmulatedSystemCore emulate_decoded_instruction;
+    } cores[] = {
+        {"generic (CHIP8)", CHIP8, emulated_system_generic_emulate_decoded_instruction},
+        {"specialized (CHIP8)", CHIP8, emulated_system_chip8_emulate_decoded_instruction},
+        {"generic (SUPERCHIP)", SUPERCHIP, emulated_system_generic_emulate_decoded_instruction},
+        {"specialized (SUPERCHIP)", SUPERCHIP, emulated_system_superchip_emulate_decoded_instruction},
+    };
+
+    for (size_t i = 0; i < sizeof cores / sizeof cores[0]; i++) {
+        if (!benchmark_load(&emulated_system, options)) return;
+        emulated_system.extension = cores[i].extension;
+
+        const double seconds = benchmark_run_core(&emulated_system, cores[i].emulate_decoded_instruction, options->instructions);
+        benchmark_report(cores[i].name, options->instructions, seconds);
+    }
+}
@@ -0,0 +1,48 @@
+// Cost of driving the core through the embedding API, one call per frame against one call for every frame
+
+// Best time of a few runs from a fresh instance, the first run pays for warming caches and branch predictors
+static double benchmark_embed_run(const uint8_t *rom, size_t rom_size, uint64_t frames, bool call_per_frame, uint64_t *executed) {
+    double best_seconds = 0;
+
+    for (int run = 0; run < 3; run++) {
+        TracuaChip8 *chip8 = tracua_chip8_create(rom, rom_size, TRACUA_CHIP8_EXTENSION_AUTO);
+        if (!chip8) return 0;
+
+        const uint64_t start = benchmark_now_ns();
+        if (call_per_frame) {
+            *executed = 0;
+            for (uint64_t frame = 0; frame < frames; frame++) {
+                tracua_chip8_set_keypad(chip8, (uint16_t)frame);
+                *executed += tracua_chip8_step_frames(chip8, 1);
+            }
+        }
+        else {
+            *executed = tracua_chip8_step_frames(chip8, frames);
+        }
+        const double seconds = (benchmark_now_ns() - start) / 1e9;
+
+        if (run == 0 || seconds < best_seconds) best_seconds = seconds;
+        tracua_chip8_destroy(chip8);
+    }
+
+    return best_seconds;
+}
+
+static void benchmark_embed(const struct BenchmarkOptions *options) {
+    static struct EmulatedSystem emulated_system;
+    if (!benchmark_load(&emulated_system, options)) return;
+
+    // The embedding API takes rom bytes, the loaded ram already has them
+    const uint8_t *rom = &emulated_system.ram[emulated_system_entry_point];
+    const size_t rom_size = sizeof emulated_system.ram - emulated_system_entry_point;
+    const uint64_t frames = options->instructions / emulated_system.instructions_per_frame;
+    uint64_t executed;
+
+    const double batched_seconds = benchmark_embed_run(rom, rom_size, frames, false, &executed);
+    benchmark_report("one call for every frame", executed, batched_seconds);
+
+    const double per_frame_seconds = benchmark_embed_run(rom, rom_size, frames, true, &executed);
+    benchmark_report("one call per frame, with keypad", executed, per_frame_seconds);
+
+    printf("  %-32s %8.2f ns/frame\n", "call overhead", (per_frame_seconds - batched_seconds) * 1e9 / frames);
+}
@@ -0,0 +1,97 @@
+// Disassembly text: the shared formatter into one buffer, written in blocks, against a printf for every field after
+// a scan of the mnemonic list, which is how listings were printed before. Every opcode is formatted, to /dev/null.
+
+#define BENCHMARK_FORMAT_PASSES 16 // Over all 65536 opcodes
+#define BENCHMARK_FORMAT_BLOCK (64 * 1024)
+
+static void benchmark_format_printf_line(FILE *output, uint16_t address, uint16_t encoded_instruction) {
+    const struct DecodedInstruction decoded_instruction = decoded_instruction_from_encoded_instruction(encoded_instruction);
+    fprintf(output, "0x%03x: %04x: ", address, encoded_instruction);
+
+    const char *name = NULL;
+    for (int i = 0; instruction_mnemonics[i].type != INVALID; i++) {
+        if (decoded_instruction.type == instruction_mnemonics[i].type) {
+            name = instruction_mnemonics[i].name;
+            break;
+        }
+    }
+
+    if (!name) {
+        fprintf(output, "Unknown\n");
+        return;
+    }
+
+    fprintf(output, "%s", name);
+    switch (decoded_instruction.operands_layout) {
+        case ADDRESS:
+            fprintf(output, " %s0x%03x\n", (decoded_instruction.type == ADDRESS_TO_REGISTER_I) ? "I, " : "", decoded_instruction.address);
+            break;
+        case REGISTER_AND_VALUE:
+            fprintf(output, " V%d, %d\n", decoded_instruction.register_index, decoded_instruction.value);
+            break;
+        case REGISTERS_AND_HALF_VALUE:
+            fprintf(output, " V%d, V%d, %d\n", decoded_instruction.register_indexes[0], decoded_instruction.register_indexes[1], decoded_instruction.half_value);
+            break;
+        default:
+            fprintf(output, "\n");
+            break;
+    }
+}
+
+static double benchmark_format_printf(FILE *output) {
+    const uint64_t start = benchmark_now_ns();
+    for (int pass = 0; pass < BENCHMARK_FORMAT_PASSES; pass++) {
+        for (uint32_t encoded_instruction = 0; encoded_instruction <= 0xFFFF; encoded_instruction++) {
+            benchmark_format_printf_line(output, 0x200 + (encoded_instruction & 0xDFF), (uint16_t)encoded_instruction);
+        }
+    }
+    fflush(output);
+    return (benchmark_now_ns() - start) / 1e9;
+}
+
+static double benchmark_format_buffered(FILE *output, enum InstructionSyntax syntax) {
+    static char text[BENCHMARK_FORMAT_BLOCK];
+    char *text_end = text;
+
+    const uint64_t start = benchmark_now_ns();
+    for (int pass = 0; pass < BENCHMARK_FORMAT_PASSES; pass++) {
+        for (uint32_t encoded_instruction = 0; encoded_instruction <= 0xFFFF; encoded_instruction++) {
+            if (text_end - text > BENCHMARK_FORMAT_BLOCK - 64) {
+                fwrite(text, 1, text_end - text, output);
+                text_end = text;
+            }
+
+            *text_end++ = '0';
+            *text_end++ = 'x';
+            text_end = instruction_format_hex(text_end, 0x200 + (encoded_instruction & 0xDFF), 3);
+            *text_end++ = ':';
+            *text_end++ = ' ';
+            text_end = instruction_format_hex(text_end, encoded_instruction, 4);
+            *text_end++ = ':';
+            *text_end++ = ' ';
+            text_end = instruction_format(text_end, decoded_instruction_from_encoded_instruction((uint16_t)encoded_instruction), syntax);
+            *text_end++ = '\n';
+        }
+    }
+    fwrite(text, 1, text_end - text, output);
+    fflush(output);
+    return (benchmark_now_ns() - start) / 1e9;
+}
+
+static void benchmark_format(const struct BenchmarkOptions *options) {
+    (void)options;
+
+    FILE *output = fopen("/dev/null", "w");
+    if (!output) {
+        fprintf(stderr, "Could not open /dev/null\n");
+        return;
+    }
+
+    const uint64_t lines = (uint64_t)BENCHMARK_FORMAT_PASSES * 0x10000;
+    printf("format (%llu lines, figures are lines rather than instructions)\n", (long long unsigned)lines);
+    benchmark_report("printf per field", lines, benchmark_format_printf(output));
+    benchmark_report("formatter, own syntax", lines, benchmark_format_buffered(output, INSTRUCTION_SYNTAX_OWN));
+    benchmark_report("formatter, Cowgod syntax", lines, benchmark_format_buffered(output, INSTRUCTION_SYNTAX_COWGOD));
+
+    fclose(output);
+}
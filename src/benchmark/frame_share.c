@@ -0,0 +1,107 @@
+// Frame time with every frame published to shared memory, while readers poll the segment every 100us, many times per
+// 60Hz frame, or spin on it as fast as they can
+
+#define BENCHMARK_FRAME_SHARE_MAX_READERS 4
+
+struct BenchmarkFrameShareReader {
+    pthread_t thread;
+    const char *name;
+    atomic_bool *is_stopping;
+    long poll_interval_ns; // 0 spins
+    uint64_t read_count;
+    uint64_t torn_read_count;
+};
+
+// Each reader maps the segment on its own, like a separate process would
+static void *benchmark_frame_share_reader(void *userdata) {
+    struct BenchmarkFrameShareReader *benchmark_reader = userdata;
+    struct FrameShareReader reader;
+    struct FrameShareFrame frame;
+
+    if (!frame_share_reader_open(&reader, benchmark_reader->name)) return NULL;
+
+    while (!atomic_load_explicit(benchmark_reader->is_stopping, memory_order_relaxed)) {
+        if (frame_share_read(&reader, &frame)) benchmark_reader->read_count++;
+        if (benchmark_reader->poll_interval_ns) nanosleep(&(struct timespec){ .tv_nsec = benchmark_reader->poll_interval_ns }, NULL);
+    }
+
+    benchmark_reader->torn_read_count = reader.torn_read_count;
+    frame_share_reader_close(&reader);
+    return NULL;
+}
+
+// Emulates frames, publishing each one when frame_share is given, returns ns per frame
+static double benchmark_frame_share_run(struct EmulatedSystem *emulated_system, struct FrameShare *frame_share, uint64_t frames) {
+    const EmulatedSystemCore emulate_decoded_instruction = emulated_system_core(emulated_system);
+    const uint64_t start = benchmark_now_ns();
+
+    for (uint64_t frame = 1; frame <= frames; frame++) {
+        for (unsigned int i = 0; i < emulated_system->instructions_per_frame && emulated_system->state == RUNNING; i++) {
+            emulated_system_consume_instruction(emulated_system);
+            emulate_decoded_instruction(emulated_system);
+        }
+
+        if (frame_share) frame_share_publish(frame_share, emulated_system, frame);
+    }
+
+    return (double)(benchmark_now_ns() - start) / frames;
+}
+
+static void benchmark_frame_share(const struct BenchmarkOptions *options) {
+    static struct EmulatedSystem emulated_system;
+    if (!benchmark_load(&emulated_system, options)) return;
+
+    const uint64_t frames = options->instructions / emulated_system.instructions_per_frame + 1;
+    char name[FRAME_SHARE_NAME_SIZE];
+    snprintf(name, sizeof name, "tracua-chip8-benchmark-%d", (int)getpid());
+
+    printf("  %-32s %8.2f ns/frame\n", "not shared", benchmark_frame_share_run(&emulated_system, NULL, frames));
+
+    struct FrameShare frame_share;
+    if (!frame_share_open(&frame_share, name)) return;
+
+    const struct {
+        unsigned int reader_count;
+        long poll_interval_ns;
+    } configurations[] = {
+        {0, 0},
+        {1, 100000},
+        {BENCHMARK_FRAME_SHARE_MAX_READERS, 100000},
+        {1, 0},
+        {BENCHMARK_FRAME_SHARE_MAX_READERS, 0},
+    };
+
+    for (size_t i = 0; i < sizeof configurations / sizeof configurations[0]; i++) {
+        struct BenchmarkFrameShareReader readers[BENCHMARK_FRAME_SHARE_MAX_READERS] = {0};
+        atomic_bool is_stopping = false;
+        unsigned int started = 0;
+
+        for (; started < configurations[i].reader_count; started++) {
+            readers[started] = (struct BenchmarkFrameShareReader){
+                .name = name,
+                .is_stopping = &is_stopping,
+                .poll_interval_ns = configurations[i].poll_interval_ns,
+            };
+            if (pthread_create(&readers[started].thread, NULL, benchmark_frame_share_reader, &readers[started]) != 0) break;
+        }
+
+        const double frame_ns = benchmark_frame_share_run(&emulated_system, &frame_share, frames);
+
+        atomic_store_explicit(&is_stopping, true, memory_order_relaxed);
+        uint64_t read_count = 0, torn_read_count = 0;
+        for (unsigned int j = 0; j < started; j++) {
+            pthread_join(readers[j].thread, NULL);
+            read_count += readers[j].read_count;
+            torn_read_count += readers[j].torn_read_count;
+        }
+
+        char label[64];
+        if (!started) snprintf(label, sizeof label, "shared, no readers");
+        else snprintf(label, sizeof label, "shared, %u readers %s", started, configurations[i].poll_interval_ns ? "polling" : "spinning");
+        printf("  %-32s %8.2f ns/frame", label, frame_ns);
+        if (started) printf(" %12llu frames read %12llu torn reads", (long long unsigned)read_count, (long long unsigned)torn_read_count);
+        printf("\n");
+    }
+
+    frame_share_close(&frame_share);
+}
@@ -0,0 +1,173 @@
+// Predecoded, fused dispatch against fetching and decoding every instruction, checked to end in the same state.
+// Also lists the adjacent instruction pairs that ran most often without being fused, candidates for new fusions.
+
+#define BENCHMARK_FUSION_PAIR_SLOTS 4096
+
+struct BenchmarkFusionPair {
+    uint32_t key; // Pattern of the first instruction in the high half, of the second in the low half
+    uint64_t count;
+};
+
+// Instructions told apart by their fixed bits, such as 8XY4 or FX65
+static uint16_t benchmark_fusion_pattern(uint16_t encoded_instruction) {
+    switch (encoded_instruction >> 12) {
+        case 0x0: case 0xE: case 0xF: return encoded_instruction & 0xF0FF;
+        case 0x8: return encoded_instruction & 0xF00F;
+        default: return encoded_instruction & 0xF000;
+    }
+}
+
+static void benchmark_fusion_pattern_name(uint16_t pattern, char name[5]) {
+    static const char *const operands[16] = {"", "NNN", "NNN", "XKK", "XKK", "XY0", "XKK", "XKK", "XY", "XY0", "NNN", "NNN", "XKK", "XYN", "X", "X"};
+    const unsigned int opcode = pattern >> 12;
+
+    if (opcode == 0x0) snprintf(name, 5, "%04X", pattern);
+    else if (opcode == 0x8) snprintf(name, 5, "8XY%X", pattern & 0xF);
+    else if (opcode == 0xE || opcode == 0xF) snprintf(name, 5, "%XX%02X", opcode, pattern & 0xFF);
+    else snprintf(name, 5, "%X%s", opcode, operands[opcode]);
+}
+
+static void benchmark_fusion_count_pair(struct BenchmarkFusionPair *pairs, uint32_t key) {
+    for (uint32_t slot = (key * 2654435761u) % BENCHMARK_FUSION_PAIR_SLOTS;; slot = (slot + 1) % BENCHMARK_FUSION_PAIR_SLOTS) {
+        if (pairs[slot].count == 0 || pairs[slot].key == key) {
+            pairs[slot].key = key;
+            pairs[slot].count++;
+            return;
+        }
+    }
+}
+
+// The unfused run, counting adjacent pairs the predecoded run would have dispatched separately
+static double benchmark_fusion_run_unfused(struct EmulatedSystem *emulated_system, uint64_t frames, uint64_t *executed, struct BenchmarkFusionPair *pairs) {
+    const EmulatedSystemCore emulate_decoded_instruction = emulated_system_core(emulated_system);
+    uint16_t previous = 0;
+    *executed = 0;
+
+    const uint64_t start = benchmark_now_ns();
+    for (uint64_t frame = 0; frame < frames && emulated_system->state == RUNNING; frame++) {
+        for (unsigned int i = 0; i < emulated_system->instructions_per_frame && emulated_system->state == RUNNING; i++) {
+            if (!emulated_system_consume_instruction(emulated_system)) break;
+            emulate_decoded_instruction(emulated_system);
+            (*executed)++;
+
+            if (pairs) {
+                const uint16_t pattern = benchmark_fusion_pattern(emulated_system->encoded_instruction);
+                if (*executed > 1) benchmark_fusion_count_pair(pairs, (uint32_t)previous << 16 | pattern);
+                previous = pattern;
+            }
+        }
+
+        if (emulated_system->delay_timer > 0) emulated_system->delay_timer--;
+        if (emulated_system->sound_timer > 0) emulated_system->sound_timer--;
+    }
+    return (benchmark_now_ns() - start) / 1e9;
+}
+
+static double benchmark_fusion_run_fused(struct EmulatedSystem *emulated_system, struct Predecode *predecode, uint64_t frames, uint64_t *executed) {
+    const EmulatedSystemCore emulate_decoded_instruction = emulated_system_core(emulated_system);
+    *executed = 0;
+
+    const uint64_t start = benchmark_now_ns();
+    for (uint64_t frame = 0; frame < frames && emulated_system->state == RUNNING; frame++) {
+        *executed += predecode_run(predecode, emulated_system, emulate_decoded_instruction, emulated_system->instructions_per_frame);
+
+        if (emulated_system->delay_timer > 0) emulated_system->delay_timer--;
+        if (emulated_system->sound_timer > 0) emulated_system->sound_timer--;
+    }
+    return (benchmark_now_ns() - start) / 1e9;
+}
+
+static bool benchmark_fusion_same_state(const struct EmulatedSystem *a, const struct EmulatedSystem *b) {
+    return a->state == b->state && a->PC == b->PC && a->I == b->I && a->SP == b->SP
+        && a->delay_timer == b->delay_timer && a->sound_timer == b->sound_timer
+        && a->draw_count == b->draw_count && a->delay_timer_read_count == b->delay_timer_read_count
+        && memcmp(a->V, b->V, sizeof a->V) == 0 && memcmp(a->stack, b->stack, sizeof a->stack) == 0
+        && memcmp(a->ram, b->ram, sizeof a->ram) == 0 && memcmp(a->display, b->display, sizeof a->display) == 0;
+}
+
+static void benchmark_fusion_rom(const char *rom_name, uint64_t instructions, bool is_detailed) {
+    static struct EmulatedSystem unfused, fused;
+    static struct Predecode predecode;
+    static struct BenchmarkFusionPair pairs[BENCHMARK_FUSION_PAIR_SLOTS];
+    const struct BenchmarkOptions options = { .rom_name = rom_name };
+
+    if (!benchmark_load(&unfused, &options)) return;
+    fused = unfused;
+    memset(&predecode, 0, sizeof predecode);
+    memset(pairs, 0, sizeof pairs);
+
+    const uint64_t frames = instructions / unfused.instructions_per_frame + 1;
+    uint64_t unfused_executed, fused_executed;
+
+    // Same rand() sequence for both, CXKK draws from it
+    srand(1);
+    const double unfused_seconds = benchmark_fusion_run_unfused(&unfused, frames, &unfused_executed, is_detailed ? pairs : NULL);
+    srand(1);
+    const double fused_seconds = benchmark_fusion_run_fused(&fused, &predecode, frames, &fused_executed);
+
+    const bool matches = unfused_executed == fused_executed && benchmark_fusion_same_state(&unfused, &fused);
+    const struct PredecodeStatistics *statistics = &predecode.statistics;
+
+    if (!is_detailed) {
+        printf("  %-40s %8.1f %8.1f %6.1f%% %6.2fx%s\n", rom_name ? rom_name : "built-in",
+               (double)statistics->instructions / frames, (double)statistics->dispatches / frames,
+               statistics->instructions ? 100.0 * (statistics->instructions - statistics->dispatches) / statistics->instructions : 0.0,
+               unfused_seconds / fused_seconds, matches ? "" : "  STATE DIFFERS");
+        return;
+    }
+
+    benchmark_report("fetch and decode every time", unfused_executed, unfused_seconds);
+    benchmark_report("predecoded and fused", fused_executed, fused_seconds);
+    printf("  %-32s %s\n", "", matches ? "same final state" : "FINAL STATE DIFFERS");
+    predecode_report(&predecode, stdout, rom_name ? rom_name : "built-in", frames);
+
+    printf("  Most frequent adjacent pairs:\n");
+    for (int rank = 0; rank < 5; rank++) {
+        struct BenchmarkFusionPair *best = NULL;
+        for (size_t slot = 0; slot < BENCHMARK_FUSION_PAIR_SLOTS; slot++) {
+            if (pairs[slot].count && (!best || pairs[slot].count > best->count)) best = &pairs[slot];
+        }
+        if (!best) break;
+
+        char first[5], second[5];
+        benchmark_fusion_pattern_name(best->key >> 16, first);
+        benchmark_fusion_pattern_name(best->key & 0xFFFF, second);
+        printf("    %s; %-6s %6.2f%% of instructions\n", first, second, 100.0 * best->count / unfused_executed);
+        best->count = 0;
+    }
+}
+
+static void benchmark_fusion_directory(const char *directory_name, uint64_t instructions) {
+    DIR *directory = opendir(directory_name);
+    if (!directory) {
+        fprintf(stderr, "Could not open directory %s\n", directory_name);
+        return;
+    }
+
+    struct dirent *directory_entry;
+    char path[4096];
+
+    while ((directory_entry = readdir(directory)) != NULL) {
+        if (strcmp(directory_entry->d_name, ".") == 0 || strcmp(directory_entry->d_name, "..") == 0) continue;
+        snprintf(path, sizeof path, "%s/%s", directory_name, directory_entry->d_name);
+
+        struct stat file_status;
+        if (stat(path, &file_status) != 0) continue;
+
+        if (S_ISDIR(file_status.st_mode)) benchmark_fusion_directory(path, instructions);
+        else if (S_ISREG(file_status.st_mode)) benchmark_fusion_rom(path, instructions, false);
+    }
+
+    closedir(directory);
+}
+
+static void benchmark_fusion(const struct BenchmarkOptions *options) {
+    if (!options->corpus_directory) {
+        benchmark_fusion_rom(options->rom_name, options->instructions, true);
+        return;
+    }
+
+    // Each rom gets a short run, a corpus may hold thousands
+    printf("  %-40s %8s %8s %7s %7s\n", "rom", "instr/f", "disp/f", "fewer", "speed");
+    benchmark_fusion_directory(options->corpus_directory, 600 * 10);
+}
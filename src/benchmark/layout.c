@@ -0,0 +1,73 @@
+// Dense hosting: memory per instance, and many instances each running a frame in turn, as a host would
+
+#define BENCHMARK_LAYOUT_INSTANCES 16384
+
+// Hardware cache miss counter for this thread, -1 when perf events are not available
+static int benchmark_layout_open_cache_misses(void) {
+    struct perf_event_attr attributes = {
+        .type = PERF_TYPE_HARDWARE,
+        .size = sizeof attributes,
+        .config = PERF_COUNT_HW_CACHE_MISSES,
+        .disabled = 1,
+        .exclude_kernel = 1,
+        .exclude_hv = 1,
+    };
+    return (int)syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+}
+
+static void benchmark_layout_run(const char *name, struct EmulatedSystem *instances, const struct BenchmarkOptions *options) {
+    const unsigned int instructions_per_frame = instances[0].instructions_per_frame;
+    const EmulatedSystemCore emulate_decoded_instruction = emulated_system_core(&instances[0]);
+    const uint64_t rounds = options->instructions / BENCHMARK_LAYOUT_INSTANCES / instructions_per_frame + 1;
+    uint64_t executed = 0;
+
+    const int cache_misses = benchmark_layout_open_cache_misses();
+    if (cache_misses >= 0) ioctl(cache_misses, PERF_EVENT_IOC_ENABLE, 0);
+    const uint64_t start = benchmark_now_ns();
+
+    for (uint64_t round = 0; round < rounds; round++) {
+        for (size_t i = 0; i < BENCHMARK_LAYOUT_INSTANCES; i++) {
+            struct EmulatedSystem *emulated_system = &instances[i];
+
+            for (unsigned int j = 0; j < instructions_per_frame && emulated_system->state == RUNNING; j++) {
+                emulated_system_consume_instruction(emulated_system);
+                emulate_decoded_instruction(emulated_system);
+                executed++;
+            }
+        }
+    }
+
+    const double seconds = (benchmark_now_ns() - start) / 1e9;
+    benchmark_report(name, executed, seconds);
+
+    uint64_t misses = 0;
+    if (cache_misses >= 0 && read(cache_misses, &misses, sizeof misses) == sizeof misses) {
+        printf("  %-32s %8.4f cache misses/instruction\n", "", (double)misses / executed);
+    }
+    if (cache_misses >= 0) close(cache_misses);
+}
+
+static void benchmark_layout(const struct BenchmarkOptions *options) {
+    static struct EmulatedSystem loaded;
+    if (!benchmark_load(&loaded, options)) return;
+
+    printf("  %-32s %8zu bytes, %zu per GB\n", "instance", sizeof loaded, ((size_t)1 << 30) / sizeof loaded);
+
+    const uint8_t *rom = &loaded.ram[emulated_system_entry_point];
+    const size_t rom_size = sizeof loaded.ram - emulated_system_entry_point;
+
+    for (int flags = 0; flags <= INSTANCE_ARENA_HUGEPAGES; flags += INSTANCE_ARENA_HUGEPAGES) {
+        struct InstanceArena arena;
+        if (!instance_arena_create(&arena, BENCHMARK_LAYOUT_INSTANCES, flags)) return;
+        if (!instance_arena_set_rom(&arena, rom, rom_size)) {
+            instance_arena_destroy(&arena);
+            return;
+        }
+
+        // Handed out in order, so the slots are the contiguous instances array
+        for (size_t i = 0; i < BENCHMARK_LAYOUT_INSTANCES; i++) instance_arena_allocate(&arena);
+
+        benchmark_layout_run(!flags ? "arena" : arena.has_hugepages ? "arena (hugepages)" : "arena (transparent hugepages)", arena.instances, options);
+        instance_arena_destroy(&arena);
+    }
+}
@@ -0,0 +1,100 @@
+// Many instances of one rom, one at a time against lockstep lanes, each instance holding different keys
+
+#define BENCHMARK_LOCKSTEP_INSTANCES 1024
+
+static void benchmark_lockstep_keys(struct EmulatedSystem *instances) {
+    for (size_t i = 0; i < BENCHMARK_LOCKSTEP_INSTANCES; i++) instances[i].keypad = (i % 3 == 0) ? (uint16_t)(1u << (i % 16)) : 0;
+}
+
+// Instances whose state differs from the reference, registers included
+static size_t benchmark_lockstep_mismatches(const struct EmulatedSystem *instances, const struct EmulatedSystem *reference) {
+    size_t mismatches = 0;
+
+    for (size_t i = 0; i < BENCHMARK_LOCKSTEP_INSTANCES; i++) {
+        const struct EmulatedSystem *a = &instances[i], *b = &reference[i];
+        const bool matches = a->state == b->state && a->PC == b->PC && a->I == b->I && a->SP == b->SP
+            && a->delay_timer == b->delay_timer && a->sound_timer == b->sound_timer
+            && a->keypad_observed == b->keypad_observed && a->draw_count == b->draw_count
+            && a->delay_timer_read_count == b->delay_timer_read_count
+            && memcmp(a->V, b->V, sizeof a->V) == 0 && memcmp(a->stack, b->stack, sizeof a->stack) == 0
+            && memcmp(a->ram, b->ram, sizeof a->ram) == 0 && memcmp(a->display, b->display, sizeof a->display) == 0;
+        mismatches += !matches;
+    }
+
+    return mismatches;
+}
+
+static void benchmark_lockstep_report(const char *name, uint64_t frames, uint64_t instructions, double seconds) {
+    benchmark_report(name, instructions, seconds);
+    printf("  %-32s %8.2f M instance-frames/s\n", "", BENCHMARK_LOCKSTEP_INSTANCES * frames / seconds / 1e6);
+}
+
+static void benchmark_lockstep(const struct BenchmarkOptions *options) {
+    struct EmulatedSystem *initial = aligned_alloc(_Alignof(struct EmulatedSystem), sizeof(struct EmulatedSystem) * BENCHMARK_LOCKSTEP_INSTANCES);
+    struct EmulatedSystem *reference = aligned_alloc(_Alignof(struct EmulatedSystem), sizeof(struct EmulatedSystem) * BENCHMARK_LOCKSTEP_INSTANCES);
+    struct EmulatedSystem *instances = aligned_alloc(_Alignof(struct EmulatedSystem), sizeof(struct EmulatedSystem) * BENCHMARK_LOCKSTEP_INSTANCES);
+
+    if (!initial || !reference || !instances || !benchmark_load(&initial[0], options)) {
+        free(initial);
+        free(reference);
+        free(instances);
+        return;
+    }
+
+    for (size_t i = 1; i < BENCHMARK_LOCKSTEP_INSTANCES; i++) initial[i] = initial[0];
+    benchmark_lockstep_keys(initial);
+
+    const unsigned int instructions_per_frame = initial[0].instructions_per_frame;
+    const uint64_t frames = options->instructions / BENCHMARK_LOCKSTEP_INSTANCES / instructions_per_frame + 1;
+    const EmulatedSystemCore emulate_decoded_instruction = emulated_system_core(&initial[0]);
+
+    // Scalar reference, the frame loop of the embedding API
+    memcpy(reference, initial, sizeof(struct EmulatedSystem) * BENCHMARK_LOCKSTEP_INSTANCES);
+    srand(1);
+    uint64_t executed = 0;
+    uint64_t start = benchmark_now_ns();
+
+    for (size_t i = 0; i < BENCHMARK_LOCKSTEP_INSTANCES; i++) {
+        struct EmulatedSystem *emulated_system = &reference[i];
+
+        for (uint64_t frame = 0; frame < frames && emulated_system->state == RUNNING; frame++) {
+            for (unsigned int j = 0; j < instructions_per_frame && emulated_system->state == RUNNING; j++) {
+                if (!emulated_system_consume_instruction(emulated_system)) break;
+                emulate_decoded_instruction(emulated_system);
+                executed++;
+            }
+
+            if (emulated_system->delay_timer > 0) emulated_system->delay_timer--;
+            if (emulated_system->sound_timer > 0) emulated_system->sound_timer--;
+        }
+    }
+    benchmark_lockstep_report("one instance at a time", frames, executed, (benchmark_now_ns() - start) / 1e9);
+
+    for (int use_avx2 = 0; use_avx2 <= 1; use_avx2++) {
+        memcpy(instances, initial, sizeof(struct EmulatedSystem) * BENCHMARK_LOCKSTEP_INSTANCES);
+
+        struct Lockstep lockstep;
+        if (!lockstep_create(&lockstep, instances, BENCHMARK_LOCKSTEP_INSTANCES)) break;
+        if (use_avx2 && !lockstep.use_avx2) {
+            printf("  %-32s no AVX2 on this CPU\n", "lockstep (AVX2)");
+            lockstep_destroy(&lockstep);
+            break;
+        }
+        lockstep.use_avx2 = use_avx2;
+
+        srand(1);
+        start = benchmark_now_ns();
+        executed = lockstep_run_frames(&lockstep, frames);
+        const double seconds = (benchmark_now_ns() - start) / 1e9;
+        lockstep_sync(&lockstep);
+
+        benchmark_lockstep_report(use_avx2 ? "lockstep (AVX2)" : "lockstep (portable)", frames, executed, seconds);
+        printf("  %-32s %7.1f%% lanes busy, %zu instances differ from the reference (CXKK draws rand() in another order)\n", "",
+               100.0 * lockstep.lane_steps / (lockstep.steps * LOCKSTEP_LANES), benchmark_lockstep_mismatches(instances, reference));
+        lockstep_destroy(&lockstep);
+    }
+
+    free(initial);
+    free(reference);
+    free(instances);
+}
@@ -0,0 +1,191 @@
+// Headless benchmarks for the emulation core
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "emulated.h"
+#include "debugger.h"
+#include "trace.h"
+#include "vip_timing.h"
+#include "tracua_chip8.h"
+#include "lockstep.h"
+#include "instance_arena.h"
+#include "predecode.h"
+#include "user_interface/phosphor.h"
+#include "user_interface/frame_share.h"
+#include "user_interface/instruction_print.h"
+
+struct BenchmarkOptions {
+    const char *rom_name; // Built-in program when NULL
+    uint64_t instructions; // Instructions executed per measurement
+    const char *corpus_directory; // Every rom under it, for benchmarks comparing roms
+};
+
+struct Benchmark {
+    const char *name;
+    const char *description;
+    void (*run)(const struct BenchmarkOptions *options);
+};
+
+// ALU heavy loop, goes through every quirk dependent instruction
+static const uint8_t benchmark_builtin_rom[] = {
+    0x60, 0x01, // 0x200: ld V0, 1
+    0x61, 0x03, // 0x202: ld V1, 3
+    0x80, 0x11, // 0x204: or V0, V1
+    0x80, 0x12, // 0x206: and V0, V1
+    0x80, 0x13, // 0x208: xor V0, V1
+    0x80, 0x16, // 0x20a: shr V0, V1
+    0x80, 0x1E, // 0x20c: shl V0, V1
+    0x70, 0x01, // 0x20e: add V0, 1
+    0xA3, 0x00, // 0x210: ld I, 0x300
+    0xF3, 0x65, // 0x212: ld V3, [I]
+    0x12, 0x04, // 0x214: jp 0x204
+};
+
+static uint64_t benchmark_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+// Resets emulated_system and loads the benchmark rom into it
+static bool benchmark_load(struct EmulatedSystem *emulated_system, const struct BenchmarkOptions *options) {
+    emulated_system_initialize(emulated_system);
+
+    if (!options->rom_name) {
+        memcpy(&emulated_system->ram[emulated_system_entry_point], benchmark_builtin_rom, sizeof benchmark_builtin_rom);
+        return true;
+    }
+
+    FILE *rom = fopen(options->rom_name, "rb");
+    if (!rom) {
+        fprintf(stderr, "Rom file %s is invalid or does not exist\n", options->rom_name);
+        return false;
+    }
+
+    const size_t max_size = sizeof emulated_system->ram - emulated_system_entry_point;
+    const size_t rom_size = fread(&emulated_system->ram[emulated_system_entry_point], 1, max_size, rom);
+    fclose(rom);
+
+    return rom_size > 0;
+}
+
+// Runs instructions through a core, returns elapsed seconds
+static double benchmark_run_core(struct EmulatedSystem *emulated_system, EmulatedSystemCore emulate_decoded_instruction, uint64_t instructions) {
+    const uint64_t start = benchmark_now_ns();
+
+    for (uint64_t i = 0; i < instructions && emulated_system->state != QUIT; i++) {
+        emulated_system_consume_instruction(emulated_system);
+        emulate_decoded_instruction(emulated_system);
+    }
+
+    return (benchmark_now_ns() - start) / 1e9;
+}
+
+static void benchmark_report(const char *name, uint64_t instructions, double seconds) {
+    printf("  %-32s %8.2f MIPS %8.2f ns/instruction\n", name, instructions / seconds / 1e6, seconds * 1e9 / instructions);
+}
+
+// cores.c
+static void benchmark_cores(const struct BenchmarkOptions *options);
+
+// breakpoints.c
+static void benchmark_breakpoints(const struct BenchmarkOptions *options);
+
+// trace.c
+static void benchmark_trace(const struct BenchmarkOptions *options);
+
+// phosphor.c
+static void benchmark_phosphor(const struct BenchmarkOptions *options);
+
+// timing.c
+static void benchmark_timing(const struct BenchmarkOptions *options);
+
+// embed.c
+static void benchmark_embed(const struct BenchmarkOptions *options);
+
+// lockstep.c
+static void benchmark_lockstep(const struct BenchmarkOptions *options);
+
+// layout.c
+static void benchmark_layout(const struct BenchmarkOptions *options);
+
+// fusion.c
+static void benchmark_fusion(const struct BenchmarkOptions *options);
+
+// frame_share.c
+static void benchmark_frame_share(const struct BenchmarkOptions *options);
+
+// format.c
+static void benchmark_format(const struct BenchmarkOptions *options);
+
+#include "cores.c"
+#include "breakpoints.c"
+#include "trace.c"
+#include "phosphor.c"
+#include "timing.c"
+#include "embed.c"
+#include "lockstep.c"
+#include "layout.c"
+#include "fusion.c"
+#include "frame_share.c"
+#include "format.c"
+
+static const struct Benchmark benchmarks[] = {
+    {"cores", "Specialized cores against runtime quirk checks", benchmark_cores},
+    {"breakpoints", "Debug dispatch with 0, 1 and 1000 breakpoints set", benchmark_breakpoints},
+    {"trace", "Execution trace of every instruction", benchmark_trace},
+    {"phosphor", "Phosphor fade of the whole display", benchmark_phosphor},
+    {"timing", "Guest speed with flat instructions per frame against COSMAC VIP cycles", benchmark_timing},
+    {"embed", "Embedding API call overhead per frame", benchmark_embed},
+    {"lockstep", "Many instances of one rom, one at a time against lockstep lanes", benchmark_lockstep},
+    {"layout", "Memory per instance and many instances each running a frame in turn", benchmark_layout},
+    {"fusion", "Predecoded instructions with fused sequences against fetching and decoding each one", benchmark_fusion},
+    {"frame_share", "Frame time publishing every frame to shared memory, with readers polling it", benchmark_frame_share},
+    {"format", "Disassembly text through the shared formatter against printf per field", benchmark_format},
+};
+
+static const char *const usage = "Usage: tracua-chip8-benchmark [--rom <rom_name>] [--corpus <directory>] [--instructions <count>] [benchmark...]\n";
+
+int main(int argc, char **argv) {
+    struct BenchmarkOptions options = { .instructions = 50000000 };
+    bool selected[sizeof benchmarks / sizeof benchmarks[0]] = {0};
+    bool any_selected = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rom") == 0 && i + 1 < argc) options.rom_name = argv[++i];
+        else if (strcmp(argv[i], "--corpus") == 0 && i + 1 < argc) options.corpus_directory = argv[++i];
+        else if (strcmp(argv[i], "--instructions") == 0 && i + 1 < argc) options.instructions = strtoull(argv[++i], NULL, 10);
+        else {
+            bool found = false;
+            for (size_t j = 0; j < sizeof benchmarks / sizeof benchmarks[0]; j++) {
+                if (strcmp(argv[i], benchmarks[j].name) == 0) selected[j] = found = any_selected = true;
+            }
+
+            if (!found) {
+                fputs(usage, stderr);
+                for (size_t j = 0; j < sizeof benchmarks / sizeof benchmarks[0]; j++)
+                    fprintf(stderr, "  %-12s %s\n", benchmarks[j].name, benchmarks[j].description);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < sizeof benchmarks / sizeof benchmarks[0]; i++) {
+        if (any_selected && !selected[i]) continue;
+
+        printf("%s: %s\n", benchmarks[i].name, benchmarks[i].description);
+        benchmarks[i].run(&options);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,25 @@
+// Cost of the phosphor fade per frame, with pixels in transition and once settled
+
+static void benchmark_phosphor(const struct BenchmarkOptions *options) {
+    static struct Phosphor phosphor;
+    static uint64_t display[PHOSPHOR_ROWS];
+    const uint64_t frames = options->instructions / 1000 + 1;
+
+    phosphor_reset(&phosphor, 0x000000FF);
+
+    uint64_t start = benchmark_now_ns();
+    for (uint64_t frame = 0; frame < frames; frame++) {
+        // A few pixels flip every frame, like a moving sprite
+        for (uint32_t i = 0; i < 16; i++) {
+            const uint64_t pixel = (frame * 97 + i * 131) % PHOSPHOR_PIXELS;
+            display[pixel / 64] ^= 1ull << (63 - pixel % 64);
+        }
+        phosphor_update(&phosphor, display, 0xFFFFFFFF, 0x000000FF, 0.7f);
+    }
+    printf("  %-32s %8.2f ns/frame\n", "fading", (double)(benchmark_now_ns() - start) / frames);
+
+    start = benchmark_now_ns();
+    for (uint64_t frame = 0; frame < frames; frame++)
+        phosphor_update(&phosphor, display, 0xFFFFFFFF, 0x000000FF, 0.7f);
+    printf("  %-32s %8.2f ns/frame\n", "settled", (double)(benchmark_now_ns() - start) / frames);
+}
@@ -0,0 +1,103 @@
+// Guest speed under the flat instructions per frame model and the COSMAC VIP cycle model.
+// Measured in emulated time, so the numbers say how fast the rom runs for the player, not for the host.
+
+#include <dirent.h>
+#include <math.h>
+#include <sys/stat.h>
+
+#define BENCHMARK_TIMING_FRAMES 600 // 10 emulated seconds per rom and model
+
+struct BenchmarkTimingTotals {
+    unsigned int rom_count;
+    double log_ratio_sum; // For the geometric mean of vip/fast speed
+};
+
+// Instructions and draws per emulated second, false if the rom stopped (invalid instruction or PC out of range)
+static bool benchmark_timing_run(struct EmulatedSystem *emulated_system, bool is_vip, double *instructions_per_second, double *draws_per_second) {
+    struct VipTiming vip_timing = {0};
+    const EmulatedSystemCore emulate_decoded_instruction = emulated_system_core(emulated_system);
+    uint64_t instructions = 0, draws = 0;
+
+    for (unsigned int frame = 0; frame < BENCHMARK_TIMING_FRAMES && emulated_system->state == RUNNING; frame++) {
+        if (is_vip) {
+            const unsigned int executed = vip_timing_run_frame(&vip_timing, emulated_system, emulate_decoded_instruction);
+            instructions += executed;
+            // The frame ends right after a draw
+            draws += executed > 0 && (emulated_system->encoded_instruction >> 12) == 0xD;
+        }
+        else {
+            for (unsigned int i = 0; i < emulated_system->instructions_per_frame && emulated_system->state == RUNNING; i++) {
+                if (!emulated_system_consume_instruction(emulated_system)) break;
+                emulate_decoded_instruction(emulated_system);
+                draws += emulated_system->decoded_instruction.type == DRAW;
+            }
+            instructions += emulated_system->instructions_per_frame;
+
+            if (emulated_system->delay_timer > 0) emulated_system->delay_timer--;
+            if (emulated_system->sound_timer > 0) emulated_system->sound_timer--;
+        }
+    }
+
+    *instructions_per_second = instructions * 60.0 / BENCHMARK_TIMING_FRAMES;
+    *draws_per_second = draws * 60.0 / BENCHMARK_TIMING_FRAMES;
+    return emulated_system->state == RUNNING;
+}
+
+static void benchmark_timing_rom(const char *rom_name, struct BenchmarkTimingTotals *totals) {
+    static struct EmulatedSystem emulated_system;
+    const struct BenchmarkOptions options = { .rom_name = rom_name };
+    double fast_speed, fast_draws, vip_speed, vip_draws;
+
+    if (!benchmark_load(&emulated_system, &options)) return;
+    const bool fast_ran = benchmark_timing_run(&emulated_system, false, &fast_speed, &fast_draws);
+
+    if (!benchmark_load(&emulated_system, &options)) return;
+    const bool vip_ran = benchmark_timing_run(&emulated_system, true, &vip_speed, &vip_draws);
+
+    if (!fast_ran || !vip_ran || vip_speed == 0) {
+        printf("  %-40s stopped\n", rom_name ? rom_name : "built-in");
+        return;
+    }
+
+    printf("  %-40s %8.0f %8.0f %6.2fx %8.1f %8.1f\n", rom_name ? rom_name : "built-in",
+           fast_speed, vip_speed, vip_speed / fast_speed, fast_draws, vip_draws);
+    totals->rom_count++;
+    totals->log_ratio_sum += log(vip_speed / fast_speed);
+}
+
+static void benchmark_timing_directory(const char *directory_name, struct BenchmarkTimingTotals *totals) {
+    DIR *directory = opendir(directory_name);
+    if (!directory) {
+        fprintf(stderr, "Could not open directory %s\n", directory_name);
+        return;
+    }
+
+    struct dirent *directory_entry;
+    char path[4096];
+
+    while ((directory_entry = readdir(directory)) != NULL) {
+        if (strcmp(directory_entry->d_name, ".") == 0 || strcmp(directory_entry->d_name, "..") == 0) continue;
+
+        snprintf(path, sizeof path, "%s/%s", directory_name, directory_entry->d_name);
+
+        struct stat file_status;
+        if (stat(path, &file_status) != 0) continue;
+
+        if (S_ISDIR(file_status.st_mode)) benchmark_timing_directory(path, totals);
+        else if (S_ISREG(file_status.st_mode)) benchmark_timing_rom(path, totals);
+    }
+
+    closedir(directory);
+}
+
+static void benchmark_timing(const struct BenchmarkOptions *options) {
+    struct BenchmarkTimingTotals totals = {0};
+
+    printf("  %-40s %8s %8s %7s %8s %8s\n", "rom", "fast i/s", "vip i/s", "vip/fast", "fast d/s", "vip d/s");
+
+    if (options->corpus_directory) benchmark_timing_directory(options->corpus_directory, &totals);
+    else benchmark_timing_rom(options->rom_name, &totals);
+
+    if (totals.rom_count > 0)
+        printf("  %u roms, geometric mean vip/fast speed %.2fx\n", totals.rom_count, exp(totals.log_ratio_sum / totals.rom_count));
+}
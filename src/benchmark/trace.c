@@ -0,0 +1,25 @@
+// Cost of tracing every instruction, records are written to /dev/null
+
+static void benchmark_trace(const struct BenchmarkOptions *options) {
+    static struct EmulatedSystem emulated_system;
+    static struct Trace trace;
+
+    if (!benchmark_load(&emulated_system, options)) return;
+    const EmulatedSystemCore emulate_decoded_instruction = emulated_system_core(&emulated_system);
+
+    const double seconds = benchmark_run_core(&emulated_system, emulate_decoded_instruction, options->instructions);
+    benchmark_report("no trace", options->instructions, seconds);
+
+    if (!benchmark_load(&emulated_system, options)) return;
+    if (!trace_open(&trace, "/dev/null", emulated_system_entry_point)) return;
+
+    const uint64_t start = benchmark_now_ns();
+    uint64_t executed = 0;
+    while (executed < options->instructions && emulated_system.state == RUNNING)
+        executed += trace_run(&trace, &emulated_system, emulate_decoded_instruction, 1000);
+    const double trace_seconds = (benchmark_now_ns() - start) / 1e9;
+
+    benchmark_report("trace", executed, trace_seconds);
+    printf("  %-32s %8llu\n", "writer stalls", (long long unsigned)trace.stalls);
+    trace_close(&trace);
+}
@@ -0,0 +1,65 @@
+// Golden hashes for the conformance programs, from tracua-chip8-conformance --print-golden
+
+static const struct ConformanceGolden conformance_golden[] = {
+    {"alu", CHIP8, {
+        {0xd80ac658736bb725ull, 0xf58a4d61f09ff122ull, 0x76fdec38ee947507ull},
+        {0xd80ac658736bb725ull, 0x23ed25b83f4f8a7cull, 0x617d8420f4af211full},
+        {0xd80ac658736bb725ull, 0x057b403b13fe9155ull, 0x799aea5a2fdff2f7ull},
+        {0xd80ac658736bb725ull, 0x22982e65d4c6a14eull, 0xc8ee121bcc85e73aull},
+    }},
+    {"alu", SUPERCHIP, {
+        {0xd80ac658736bb725ull, 0xe8139d6279ff8eaaull, 0x76fdec38ee947507ull},
+        {0xd80ac658736bb725ull, 0x23ed21b83f4f83b0ull, 0x617d8420f4af211full},
+        {0xd80ac658736bb725ull, 0x3d4f083bc49bce15ull, 0x799aea5a2fdff2f7ull},
+        {0xd80ac658736bb725ull, 0x22983265d4c6a81aull, 0xc8ee121bcc85e73aull},
+    }},
+    {"draw", CHIP8, {
+        {0xfa0c270f3f4f7ba1ull, 0x715d280a0c9c6e57ull, 0x8bb7a866dc2c795full},
+        {0x8125efec488dd926ull, 0x566a66dadf7356a5ull, 0x8bb7a866dc2c795full},
+        {0x8125efec488dd926ull, 0x566a66dadf7356a5ull, 0x8bb7a866dc2c795full},
+        {0x8125efec488dd926ull, 0x566a66dadf7356a5ull, 0x8bb7a866dc2c795full},
+    }},
+    {"draw", SUPERCHIP, {
+        {0xfa0c270f3f4f7ba1ull, 0x715d280a0c9c6e57ull, 0x8bb7a866dc2c795full},
+        {0x8125efec488dd926ull, 0x566a66dadf7356a5ull, 0x8bb7a866dc2c795full},
+        {0x8125efec488dd926ull, 0x566a66dadf7356a5ull, 0x8bb7a866dc2c795full},
+        {0x8125efec488dd926ull, 0x566a66dadf7356a5ull, 0x8bb7a866dc2c795full},
+    }},
+    {"input", CHIP8, {
+        {0xd80ac658736bb725ull, 0x0fd0d4f049fa40efull, 0x53b339e3e3330174ull},
+        {0xd80ac658736bb725ull, 0xa30c572dafd37234ull, 0x53b339e3e3330174ull},
+        {0xd80ac658736bb725ull, 0xe6311bce5e7700f7ull, 0x5e62913f9b15780aull},
+        {0xd80ac658736bb725ull, 0xc81bafcdb9c38d75ull, 0x5e62913f9b15780aull},
+    }},
+    {"input", SUPERCHIP, {
+        {0xd80ac658736bb725ull, 0x0fd0d4f049fa40efull, 0x53b339e3e3330174ull},
+        {0xd80ac658736bb725ull, 0xa30c572dafd37234ull, 0x53b339e3e3330174ull},
+        {0xd80ac658736bb725ull, 0xe6311bce5e7700f7ull, 0x5e62913f9b15780aull},
+        {0xd80ac658736bb725ull, 0xc81bafcdb9c38d75ull, 0x5e62913f9b15780aull},
+    }},
+    {"control", CHIP8, {
+        {0xd80ac658736bb725ull, 0xd8e41a0770d87ec4ull, 0x66a856da70ae52cbull},
+        {0xd80ac658736bb725ull, 0x657fa89d2914c286ull, 0x66a856da70ae52cbull},
+        {0xd80ac658736bb725ull, 0x5b6ab7214696134aull, 0x66a856da70ae52cbull},
+        {0xd80ac658736bb725ull, 0x6a4ae8bce76d573cull, 0x66a856da70ae52cbull},
+    }},
+    {"control", SUPERCHIP, {
+        {0xd80ac658736bb725ull, 0xd8e41a0770d87ec4ull, 0x66a856da70ae52cbull},
+        {0xd80ac658736bb725ull, 0x657fa89d2914c286ull, 0x66a856da70ae52cbull},
+        {0xd80ac658736bb725ull, 0x5b6ab7214696134aull, 0x66a856da70ae52cbull},
+        {0xd80ac658736bb725ull, 0x6a4ae8bce76d573cull, 0x66a856da70ae52cbull},
+    }},
+    {"fusion", CHIP8, {
+        {0x5cf8d2e9efe1e63bull, 0x082e8bc804dec55bull, 0xbbd3ab26e0cc0f94ull},
+        {0x5cf8d2e9efe1e63bull, 0x082e8bc804dec55bull, 0xbbd3ab26e0cc0f94ull},
+        {0x5cf8d2e9efe1e63bull, 0x082e8bc804dec55bull, 0xbbd3ab26e0cc0f94ull},
+        {0x5cf8d2e9efe1e63bull, 0x082e8bc804dec55bull, 0xbbd3ab26e0cc0f94ull},
+    }},
+    {"fusion", SUPERCHIP, {
+        {0x5cf8d2e9efe1e63bull, 0x082e8bc804dec55bull, 0xbbd3ab26e0cc0f94ull},
+        {0x5cf8d2e9efe1e63bull, 0x082e8bc804dec55bull, 0xbbd3ab26e0cc0f94ull},
+        {0x5cf8d2e9efe1e63bull, 0x082e8bc804dec55bull, 0xbbd3ab26e0cc0f94ull},
+        {0x5cf8d2e9efe1e63bull, 0x082e8bc804dec55bull, 0xbbd3ab26e0cc0f94ull},
+    }},
+    {0},
+};
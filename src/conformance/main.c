@@ -0,0 +1,353 @@
+// Runs the conformance programs through every execution backend and quirk set, hashing the display,
+// registers and RAM at checkpoints against golden hashes. Exits with failure on any difference.
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "emulated.h"
+#include "predecode.h"
+#include "lockstep.h"
+#include "tracua_chip8.h"
+#include "rom_hash.h"
+
+#define CONFORMANCE_CHECKPOINTS 4 // Evenly spaced, the last one after the final frame
+#define CONFORMANCE_MAX_ROM_SIZE (4096 - 0x200)
+
+#ifndef CONFORMANCE_ROM_DIRECTORY
+#define CONFORMANCE_ROM_DIRECTORY "." // Set by the build to where it assembles the programs
+#endif
+
+struct ConformanceInput {
+    uint32_t frame; // Keys held from the start of this frame on
+    uint16_t keypad;
+};
+
+struct ConformanceProgram {
+    const char *name; // The rom is <name>.ch8
+    uint8_t rom[CONFORMANCE_MAX_ROM_SIZE]; // Read by conformance_read_programs
+    size_t rom_size;
+    uint32_t frames;
+    const struct ConformanceInput *inputs; // By frame
+    size_t input_count;
+};
+
+struct ConformanceHashes {
+    uint64_t display;
+    uint64_t registers; // V and I
+    uint64_t ram;
+};
+
+struct ConformanceGolden {
+    const char *program;
+    int extension; // A value of EmulatedSystem.extension
+    struct ConformanceHashes checkpoints[CONFORMANCE_CHECKPOINTS];
+};
+
+// Runs a program with the given quirks, filling the hashes at each checkpoint.
+// Returns false when the backend can't run here.
+typedef bool (*ConformanceBackendRun)(const struct ConformanceProgram *program, int extension,
+                                      struct ConformanceHashes checkpoints[CONFORMANCE_CHECKPOINTS]);
+
+struct ConformanceBackend {
+    const char *name;
+    ConformanceBackendRun run;
+};
+
+#include "programs.c" // conformance_programs
+#include "golden.c" // conformance_golden
+
+static const char *const conformance_extension_names[] = {"chip8", "superchip"};
+
+static bool conformance_read_programs(const char *directory) {
+    for (size_t i = 0; i < sizeof conformance_programs / sizeof conformance_programs[0]; i++) {
+        struct ConformanceProgram *program = &conformance_programs[i];
+        char path[4096];
+        snprintf(path, sizeof path, "%s/%s.ch8", directory, program->name);
+
+        FILE *rom = fopen(path, "rb");
+        if (!rom) {
+            fprintf(stderr, "Could not open %s, the conformance programs are assembled by the build\n", path);
+            return false;
+        }
+        program->rom_size = fread(program->rom, 1, sizeof program->rom, rom);
+        fclose(rom);
+
+        if (program->rom_size == 0) {
+            fprintf(stderr, "Rom file %s is empty\n", path);
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint16_t conformance_keypad_at(const struct ConformanceProgram *program, uint32_t frame) {
+    uint16_t keypad = 0;
+    for (size_t i = 0; i < program->input_count && program->inputs[i].frame <= frame; i++) keypad = program->inputs[i].keypad;
+    return keypad;
+}
+
+// Index of the checkpoint taken after frame, -1 when none is
+static int conformance_checkpoint_after(const struct ConformanceProgram *program, uint32_t frame) {
+    const uint32_t interval = program->frames / CONFORMANCE_CHECKPOINTS;
+    return ((frame + 1) % interval == 0) ? (int)((frame + 1) / interval) - 1 : -1;
+}
+
+// Rows are hashed most significant byte first, so the hashes don't depend on the host's byte order
+static void conformance_hash(struct ConformanceHashes *hashes, const uint64_t *display, const uint8_t *V, uint16_t I, const uint8_t *ram) {
+    uint8_t rows[EMULATED_DISPLAY_HEIGHT * sizeof(uint64_t)];
+    for (int y = 0; y < EMULATED_DISPLAY_HEIGHT; y++) {
+        for (int byte = 0; byte < 8; byte++) rows[y * 8 + byte] = (uint8_t)(display[y] >> (56 - byte * 8));
+    }
+
+    uint8_t registers[18];
+    memcpy(registers, V, 16);
+    registers[16] = I >> 8;
+    registers[17] = I & 0xFF;
+
+    hashes->display = rom_hash(rows, sizeof rows);
+    hashes->registers = rom_hash(registers, sizeof registers);
+    hashes->ram = rom_hash(ram, 4096);
+}
+
+static void conformance_load(struct EmulatedSystem *emulated_system, const struct ConformanceProgram *program, int extension) {
+    emulated_system_initialize(emulated_system);
+    emulated_system->extension = extension;
+    memcpy(&emulated_system->ram[emulated_system_entry_point], program->rom, program->rom_size);
+}
+
+static void conformance_tick_timers(struct EmulatedSystem *emulated_system) {
+    if (emulated_system->delay_timer > 0) emulated_system->delay_timer--;
+    if (emulated_system->sound_timer > 0) emulated_system->sound_timer--;
+}
+
+// Interpreter frame loop with the given core
+static void conformance_run_core(const struct ConformanceProgram *program, int extension, EmulatedSystemCore core,
+                                 struct ConformanceHashes checkpoints[CONFORMANCE_CHECKPOINTS]) {
+    static struct EmulatedSystem emulated_system;
+    conformance_load(&emulated_system, program, extension);
+    if (!core) core = emulated_system_core(&emulated_system);
+
+    for (uint32_t frame = 0; frame < program->frames; frame++) {
+        emulated_system.keypad = conformance_keypad_at(program, frame);
+
+        for (unsigned int i = 0; i < emulated_system.instructions_per_frame && emulated_system.state == RUNNING; i++) {
+            if (!emulated_system_consume_instruction(&emulated_system)) break;
+            core(&emulated_system);
+        }
+        conformance_tick_timers(&emulated_system);
+
+        const int checkpoint = conformance_checkpoint_after(program, frame);
+        if (checkpoint >= 0) conformance_hash(&checkpoints[checkpoint], emulated_system.display, emulated_system.V, emulated_system.I, emulated_system.ram);
+    }
+}
+
+static bool conformance_backend_specialized(const struct ConformanceProgram *program, int extension, struct ConformanceHashes checkpoints[CONFORMANCE_CHECKPOINTS]) {
+    conformance_run_core(program, extension, NULL, checkpoints);
+    return true;
+}
+
+static bool conformance_backend_generic(const struct ConformanceProgram *program, int extension, struct ConformanceHashes checkpoints[CONFORMANCE_CHECKPOINTS]) {
+    conformance_run_core(program, extension, emulated_system_generic_emulate_decoded_instruction, checkpoints);
+    return true;
+}
+
+static bool conformance_backend_fused(const struct ConformanceProgram *program, int extension, struct ConformanceHashes checkpoints[CONFORMANCE_CHECKPOINTS]) {
+    static struct EmulatedSystem emulated_system;
+    static struct Predecode predecode;
+
+    conformance_load(&emulated_system, program, extension);
+    memset(&predecode, 0, sizeof predecode);
+    const EmulatedSystemCore core = emulated_system_core(&emulated_system);
+
+    for (uint32_t frame = 0; frame < program->frames; frame++) {
+        emulated_system.keypad = conformance_keypad_at(program, frame);
+        predecode_run(&predecode, &emulated_system, core, emulated_system.instructions_per_frame);
+        conformance_tick_timers(&emulated_system);
+
+        const int checkpoint = conformance_checkpoint_after(program, frame);
+        if (checkpoint >= 0) conformance_hash(&checkpoints[checkpoint], emulated_system.display, emulated_system.V, emulated_system.I, emulated_system.ram);
+    }
+    return true;
+}
+
+static bool conformance_run_lockstep(const struct ConformanceProgram *program, int extension, bool use_avx2, struct ConformanceHashes checkpoints[CONFORMANCE_CHECKPOINTS]) {
+    static struct EmulatedSystem emulated_system;
+    struct Lockstep lockstep;
+
+    conformance_load(&emulated_system, program, extension);
+    if (!lockstep_create(&lockstep, &emulated_system, 1)) return false;
+    if (use_avx2 && !lockstep.use_avx2) {
+        lockstep_destroy(&lockstep);
+        return false;
+    }
+    lockstep.use_avx2 = use_avx2;
+
+    for (uint32_t frame = 0; frame < program->frames; frame++) {
+        lockstep_set_keypad(&lockstep, 0, conformance_keypad_at(program, frame));
+        lockstep_run_frames(&lockstep, 1);
+
+        const int checkpoint = conformance_checkpoint_after(program, frame);
+        if (checkpoint >= 0) {
+            lockstep_sync(&lockstep);
+            conformance_hash(&checkpoints[checkpoint], emulated_system.display, emulated_system.V, emulated_system.I, emulated_system.ram);
+        }
+    }
+
+    lockstep_destroy(&lockstep);
+    return true;
+}
+
+static bool conformance_backend_lockstep(const struct ConformanceProgram *program, int extension, struct ConformanceHashes checkpoints[CONFORMANCE_CHECKPOINTS]) {
+    return conformance_run_lockstep(program, extension, false, checkpoints);
+}
+
+static bool conformance_backend_lockstep_avx2(const struct ConformanceProgram *program, int extension, struct ConformanceHashes checkpoints[CONFORMANCE_CHECKPOINTS]) {
+    return conformance_run_lockstep(program, extension, true, checkpoints);
+}
+
+static bool conformance_backend_api(const struct ConformanceProgram *program, int extension, struct ConformanceHashes checkpoints[CONFORMANCE_CHECKPOINTS]) {
+    TracuaChip8 *chip8 = tracua_chip8_create(program->rom, program->rom_size, extension);
+    if (!chip8) return false;
+
+    for (uint32_t frame = 0; frame < program->frames; frame++) {
+        tracua_chip8_set_keypad(chip8, conformance_keypad_at(program, frame));
+        tracua_chip8_step_frames(chip8, 1);
+
+        const int checkpoint = conformance_checkpoint_after(program, frame);
+        if (checkpoint >= 0) {
+            struct TracuaChip8Display display;
+            tracua_chip8_display(chip8, &display);
+            const struct TracuaChip8Registers *registers = tracua_chip8_registers(chip8);
+            conformance_hash(&checkpoints[checkpoint], (const uint64_t *)display.pixels, registers->V, registers->I, tracua_chip8_ram(chip8));
+        }
+    }
+
+    tracua_chip8_destroy(chip8);
+    return true;
+}
+
+// The first one is the reference golden hashes are taken from
+static const struct ConformanceBackend conformance_backends[] = {
+    {"generic", conformance_backend_generic},
+    {"specialized", conformance_backend_specialized},
+    {"fused", conformance_backend_fused},
+    {"lockstep", conformance_backend_lockstep},
+    {"lockstep-avx2", conformance_backend_lockstep_avx2},
+    {"api", conformance_backend_api},
+};
+
+static const struct ConformanceGolden *conformance_find_golden(const char *program, int extension) {
+    for (size_t i = 0; conformance_golden[i].program; i++) {
+        if (strcmp(conformance_golden[i].program, program) == 0 && conformance_golden[i].extension == extension) return &conformance_golden[i];
+    }
+    return NULL;
+}
+
+// Golden table from the reference backend, to be saved as golden.c after an intended behaviour change
+static void conformance_print_golden(void) {
+    printf("// Golden hashes for the conformance programs, from tracua-chip8-conformance --print-golden\n\n");
+    printf("static const struct ConformanceGolden conformance_golden[] = {\n");
+
+    for (size_t i = 0; i < sizeof conformance_programs / sizeof conformance_programs[0]; i++) {
+        for (int extension = CHIP8; extension <= SUPERCHIP; extension++) {
+            struct ConformanceHashes checkpoints[CONFORMANCE_CHECKPOINTS];
+            conformance_backends[0].run(&conformance_programs[i], extension, checkpoints);
+
+            printf("    {\"%s\", %s, {\n", conformance_programs[i].name, (extension == CHIP8) ? "CHIP8" : "SUPERCHIP");
+            for (int j = 0; j < CONFORMANCE_CHECKPOINTS; j++) {
+                printf("        {0x%016llxull, 0x%016llxull, 0x%016llxull},\n", (unsigned long long)checkpoints[j].display,
+                       (unsigned long long)checkpoints[j].registers, (unsigned long long)checkpoints[j].ram);
+            }
+            printf("    }},\n");
+        }
+    }
+
+    printf("    {0},\n};\n");
+}
+
+static const char *const usage = "Usage: tracua-chip8-conformance [--roms <directory>] [--print-golden] [backend...]\n";
+
+int main(int argc, char **argv) {
+    bool selected[sizeof conformance_backends / sizeof conformance_backends[0]] = {0};
+    bool any_selected = false;
+    bool should_print_golden = false;
+    const char *rom_directory = CONFORMANCE_ROM_DIRECTORY;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--print-golden") == 0) {
+            should_print_golden = true;
+            continue;
+        }
+        else if (strcmp(argv[i], "--roms") == 0 && i + 1 < argc) {
+            rom_directory = argv[++i];
+            continue;
+        }
+
+        bool found = false;
+        for (size_t j = 0; j < sizeof conformance_backends / sizeof conformance_backends[0]; j++) {
+            if (strcmp(argv[i], conformance_backends[j].name) == 0) selected[j] = found = any_selected = true;
+        }
+
+        if (!found) {
+            fputs(usage, stderr);
+            for (size_t j = 0; j < sizeof conformance_backends / sizeof conformance_backends[0]; j++) fprintf(stderr, "  %s\n", conformance_backends[j].name);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!conformance_read_programs(rom_directory)) return EXIT_FAILURE;
+    else if (should_print_golden) {
+        conformance_print_golden();
+        return EXIT_SUCCESS;
+    }
+
+    unsigned int failures = 0;
+
+    for (size_t i = 0; i < sizeof conformance_programs / sizeof conformance_programs[0]; i++) {
+        const struct ConformanceProgram *program = &conformance_programs[i];
+
+        for (int extension = CHIP8; extension <= SUPERCHIP; extension++) {
+            const struct ConformanceGolden *golden = conformance_find_golden(program->name, extension);
+
+            for (size_t j = 0; j < sizeof conformance_backends / sizeof conformance_backends[0]; j++) {
+                if (any_selected && !selected[j]) continue;
+
+                printf("%-8s %-10s %-14s ", program->name, conformance_extension_names[extension], conformance_backends[j].name);
+
+                struct ConformanceHashes checkpoints[CONFORMANCE_CHECKPOINTS];
+                if (!golden) {
+                    printf("FAIL no golden hashes\n");
+                    failures++;
+                    continue;
+                }
+                else if (!conformance_backends[j].run(program, extension, checkpoints)) {
+                    printf("skipped, not available here\n");
+                    continue;
+                }
+
+                int first_difference = -1;
+                for (int k = 0; k < CONFORMANCE_CHECKPOINTS && first_difference < 0; k++) {
+                    if (memcmp(&checkpoints[k], &golden->checkpoints[k], sizeof checkpoints[k]) != 0) first_difference = k;
+                }
+
+                if (first_difference < 0) {
+                    printf("ok\n");
+                    continue;
+                }
+
+                const struct ConformanceHashes *got = &checkpoints[first_difference], *expected = &golden->checkpoints[first_difference];
+                printf("FAIL after frame %u:%s%s%s\n",
+                       (first_difference + 1) * (program->frames / CONFORMANCE_CHECKPOINTS),
+                       (got->display != expected->display) ? " display" : "",
+                       (got->registers != expected->registers) ? " registers" : "",
+                       (got->ram != expected->ram) ? " ram" : "");
+                failures++;
+            }
+        }
+    }
+
+    printf("%u failures\n", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,25 @@
+// Conformance programs, each written to reach a group of fast paths, with the keys held while they run.
+// Sources are programs/<name>.asm, assembled by tracua-chip8-assembler at build time and loaded from
+// CONFORMANCE_ROM_DIRECTORY (or --roms) on start.
+// Cxkk is left out: rand() differs between C libraries and the golden hashes would too.
+
+// Keys for programs/input.asm, its FX0A waits on them
+static const struct ConformanceInput conformance_input_script[] = {
+    {10, 0x0020},
+    {30, 0x0021},
+    {60, 0x0000},
+    {100, 0x8000},
+    {150, 0x0000},
+    {250, 0x0004},
+    {300, 0x0000},
+    {380, 0x1000},
+};
+
+static struct ConformanceProgram conformance_programs[] = {
+    { .name = "alu", .frames = 120 },
+    { .name = "draw", .frames = 120 },
+    { .name = "input", .frames = 400,
+      .inputs = conformance_input_script, .input_count = sizeof conformance_input_script / sizeof conformance_input_script[0] },
+    { .name = "control", .frames = 240 },
+    { .name = "fusion", .frames = 240 },
+};
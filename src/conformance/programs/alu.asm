@@ -0,0 +1,28 @@
+; Every 8XYN with VF as operand and destination, FX33, FX55, FX65, FX1E and FX29 (quirk dependent ones included)
+
+    ld VA, 0
+loop:
+    ld V0, 0x37
+    ld V1, 0xC9
+    sum V0, V1
+    ld V2, V0
+    sub V2, V1
+    subn V3, V1
+    shr V4, V0
+    shl V5, V0
+    or V6, V1
+    and V7, V1
+    xor V8, V1
+    sum VF, V0
+    shr VF, V1
+    ld I, 0x300
+    misc VA, 0x1E ; add I, VA
+    misc V0, 0x33 ; ld B, V0
+    misc V8, 0x55 ; ld [I], V8
+    misc VA, 0x29 ; ld F, VA
+    misc V3, 0x65 ; ld V3, [I]
+    add VA, 1
+    se VA, 0x40
+    jp loop
+end:
+    jp end
@@ -0,0 +1,33 @@
+; Delay timer spin, nested calls, BNNN, the sound timer and a subroutine rewriting itself with FX55
+
+start:
+    ld V0, 5
+    misc V0, 0x15 ; ld DT, V0
+spin:
+    misc V1, 0x07 ; ld V1, DT
+    se V1, 0
+    jp spin
+    call increment
+    ld V0, 2
+    jp V0, skipped ; V0 skips over the loop
+skipped:
+    jp skipped
+    ld V3, 8
+    misc V3, 0x18 ; ld ST, V3
+    ld V0, 3
+    ld I, 0x231 ; Operand of add V4, 1 at increment
+    misc V0, 0x55 ; ld [I], V0
+    call nested
+    add V6, 1
+    se V6, 0x20
+    jp start
+end:
+    jp end
+
+    db 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+increment: ; 0x230
+    add V4, 1 ; Its operand becomes 3
+    ret
+nested:
+    call increment
+    ret
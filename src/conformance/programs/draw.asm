@@ -0,0 +1,25 @@
+; Sprites wrapping around both edges, collisions feeding back into positions, then a 15 row sprite
+
+    cls
+    ld I, sprite
+    ld V0, 58
+    ld V1, 28
+    ld V2, 0
+loop:
+    drw V0, V1, 8
+    ld V3, VF
+    add V0, 7
+    add V1, 5
+    sum V0, V3
+    add V2, 1
+    se V2, 0x40
+    jp loop
+    cls
+    drw V0, V1, 15
+end:
+    jp end
+
+    db 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+sprite: ; 0x230
+    db 0xF0, 0x90, 0xF0, 0x90, 0xFF, 0x81, 0x81, 0xFF
+    db 0x3C, 0x42, 0x81, 0xA5, 0x81, 0x42, 0x3C
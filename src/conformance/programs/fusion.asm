@@ -0,0 +1,36 @@
+; The sequences the predecoded stream fuses, with FX55 rewriting the ANNN of a fused ANNN; DXYN
+
+    ld V0, 0
+count:
+    add V0, 1
+    se V0, 0x20
+    jp count
+    ld V1, 0
+    ld V2, 0
+draw:
+    ld I, first_sprite
+    drw V1, V2, 5
+    add V1, 9
+    add V2, 3
+    ld I, second_sprite
+    misc V0, 0x65 ; ld V0, [I]
+    ld V0, 0x45
+    ld I, 0x20d ; Address operand of ld I, first_sprite at draw
+    misc V0, 0x55 ; ld [I], V0
+    ld V4, 3
+    misc V4, 0x15 ; ld DT, V4
+wait:
+    misc V5, 0x07 ; ld V5, DT
+    se V5, 0
+    jp wait
+    add V6, 1
+    se V6, 12
+    jp draw
+end:
+    jp end
+
+    db 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+first_sprite: ; 0x240
+    db 0xF0, 0x88, 0x88, 0x88, 0xF0
+second_sprite: ; 0x245
+    db 0x03, 0x81, 0x42, 0x24, 0x18
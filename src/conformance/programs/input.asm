@@ -0,0 +1,22 @@
+; EX9E and EXA1 over every key, then FX0A waiting on the script (conformance_input_script)
+
+start:
+    ld V0, 0
+    ld V1, 0
+loop:
+    skp V0
+    jp not_pressed
+    add V1, 1
+not_pressed:
+    sknp V0
+    add V2, 1
+    add V0, 1
+    sne V0, 16
+    ld V0, 0
+    add V3, 1
+    se V3, 0
+    jp loop
+    misc V4, 0x0A ; ld V4, K
+    ld I, 0x300
+    misc V4, 0x55 ; ld [I], V4
+    jp start
@@ -0,0 +1,257 @@
+// Corpus mode: catalogue every rom under a directory
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "rom_hash.h"
+
+#define CORPUS_HISTOGRAM_SIZE (MISC + 1) // One bin per enum DecodedInstructionType
+#define CORPUS_BATCH_SIZE 64 // Roms taken from the queue at once by each worker
+
+struct CorpusEntry {
+    char *path;
+    uint64_t hash;
+    uint32_t size;
+    uint16_t code_bytes;
+    uint16_t data_bytes;
+    uint32_t histogram[CORPUS_HISTOGRAM_SIZE];
+    bool is_valid;
+};
+
+struct Corpus {
+    struct CorpusEntry *entries;
+    size_t entry_count;
+    size_t entry_capacity;
+
+    size_t next_entry; // Work queue position, guarded by lock
+    pthread_mutex_t lock;
+};
+
+static bool corpus_add_file(struct Corpus *corpus, const char *path) {
+    if (corpus->entry_count == corpus->entry_capacity) {
+        const size_t capacity = corpus->entry_capacity ? corpus->entry_capacity * 2 : 1024;
+        struct CorpusEntry *entries = realloc(corpus->entries, capacity * sizeof(struct CorpusEntry));
+        if (!entries) {
+            fprintf(stderr, "Out of memory\n");
+            return false;
+        }
+
+        corpus->entries = entries;
+        corpus->entry_capacity = capacity;
+    }
+
+    char *path_copy = strdup(path);
+    if (!path_copy) {
+        fprintf(stderr, "Out of memory\n");
+        return false;
+    }
+
+    corpus->entries[corpus->entry_count++] = (struct CorpusEntry){ .path = path_copy };
+    return true;
+}
+
+// Recursively collects regular files. Links to files are collected, links to directories are not
+// followed, since one pointing back up would never end.
+static bool corpus_collect(struct Corpus *corpus, const char *directory_name) {
+    DIR *directory = opendir(directory_name);
+    if (!directory) {
+        fprintf(stderr, "Could not open directory %s\n", directory_name);
+        return false;
+    }
+
+    struct dirent *directory_entry;
+    char path[4096];
+
+    while ((directory_entry = readdir(directory)) != NULL) {
+        if (strcmp(directory_entry->d_name, ".") == 0 || strcmp(directory_entry->d_name, "..") == 0) continue;
+
+        snprintf(path, sizeof path, "%s/%s", directory_name, directory_entry->d_name);
+
+        bool is_directory = directory_entry->d_type == DT_DIR;
+        bool is_file = directory_entry->d_type == DT_REG;
+
+        if (directory_entry->d_type == DT_UNKNOWN || directory_entry->d_type == DT_LNK) {
+            struct stat file_status;
+            if (lstat(path, &file_status) != 0) continue;
+
+            const bool is_link = S_ISLNK(file_status.st_mode);
+            if (is_link && stat(path, &file_status) != 0) continue;
+
+            is_directory = !is_link && S_ISDIR(file_status.st_mode);
+            is_file = S_ISREG(file_status.st_mode);
+        }
+
+        // A subdirectory that could not be read fails the whole catalogue, rather than leaving its roms out unnoticed
+        if ((is_directory && !corpus_collect(corpus, path)) || (is_file && !corpus_add_file(corpus, path))) {
+            closedir(directory);
+            return false;
+        }
+    }
+
+    closedir(directory);
+    return true;
+}
+
+static void corpus_process_entry(struct CorpusEntry *entry, struct ProgramAnalysis *analysis) {
+    const int file = open(entry->path, O_RDONLY);
+    if (file < 0) return;
+
+    struct stat file_status;
+    if (fstat(file, &file_status) != 0
+        || file_status.st_size == 0
+        || file_status.st_size > PROGRAM_ANALYSIS_MEMORY_SIZE - rom_load_address) {
+        close(file);
+        return;
+    }
+
+    const uint8_t *rom = mmap(NULL, file_status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (rom == MAP_FAILED) return;
+
+    entry->size = file_status.st_size;
+    entry->hash = rom_hash(rom, entry->size);
+
+    program_analysis_run(analysis, rom, entry->size, rom_load_address);
+    munmap((void *)rom, file_status.st_size);
+
+    for (uint32_t address = analysis->load_address; address < analysis->rom_end; address++) {
+        if (!program_analysis_is_code(analysis, address)) continue;
+
+        const struct DecodedInstruction decoded_instruction = decoded_instruction_from_encoded_instruction(
+            program_analysis_encoded_instruction_at(analysis, address)
+        );
+        entry->histogram[decoded_instruction.type]++;
+    }
+
+    entry->code_bytes = analysis->code_bytes;
+    entry->data_bytes = analysis->data_bytes;
+    entry->is_valid = true;
+}
+
+static void *corpus_worker(void *userdata) {
+    struct Corpus *corpus = userdata;
+
+    struct ProgramAnalysis *analysis = malloc(sizeof(struct ProgramAnalysis));
+    if (!analysis) return NULL;
+
+    while (true) {
+        pthread_mutex_lock(&corpus->lock);
+        const size_t first = corpus->next_entry;
+        corpus->next_entry += CORPUS_BATCH_SIZE;
+        pthread_mutex_unlock(&corpus->lock);
+
+        if (first >= corpus->entry_count) break;
+
+        const size_t last = (first + CORPUS_BATCH_SIZE < corpus->entry_count) ? first + CORPUS_BATCH_SIZE : corpus->entry_count;
+        for (size_t i = first; i < last; i++) corpus_process_entry(&corpus->entries[i], analysis);
+    }
+
+    free(analysis);
+    return NULL;
+}
+
+static int corpus_compare_entries(const void *a, const void *b) {
+    const struct CorpusEntry *entry_a = a, *entry_b = b;
+
+    // Invalid entries go last
+    if (entry_a->is_valid != entry_b->is_valid) return entry_a->is_valid ? -1 : 1;
+    if (entry_a->hash != entry_b->hash) return (entry_a->hash < entry_b->hash) ? -1 : 1;
+    return strcmp(entry_a->path, entry_b->path);
+}
+
+// Writes the index sorted by hash, one line per unique rom
+static bool corpus_write_index(struct Corpus *corpus, FILE *output, size_t *unique_count) {
+    // Every line fits in this, paths included
+    const size_t line_capacity = 32 + CORPUS_HISTOGRAM_SIZE * 11 + 4096;
+    char *buffer = malloc(corpus->entry_count * 256 + line_capacity);
+    if (!buffer) return false;
+
+    size_t length = (size_t)sprintf(buffer, "# hash\tsize\tcode_ratio\thistogram\tpath\n");
+    *unique_count = 0;
+
+    for (size_t i = 0; i < corpus->entry_count; i++) {
+        const struct CorpusEntry *entry = &corpus->entries[i];
+        if (!entry->is_valid) break;
+        if (i > 0 && entry->hash == corpus->entries[i - 1].hash) continue;
+
+        length += sprintf(&buffer[length], "%016llx\t%u\t%.3f\t",
+                          (long long unsigned)entry->hash, entry->size, (double)entry->code_bytes / entry->size);
+        for (uint32_t j = 0; j < CORPUS_HISTOGRAM_SIZE; j++)
+            length += sprintf(&buffer[length], "%s%u", (j == 0) ? "" : ",", entry->histogram[j]);
+        // A path too long for the line is cut, the newline with it
+        const int path_length = snprintf(&buffer[length], 4096, "\t%s\n", entry->path);
+        length += (path_length < 4096) ? (size_t)path_length : 4095;
+
+        (*unique_count)++;
+
+        // Flush before the next line could overflow
+        if (length + line_capacity > corpus->entry_count * 256) {
+            if (fwrite(buffer, 1, length, output) != length) {
+                free(buffer);
+                return false;
+            }
+            length = 0;
+        }
+    }
+
+    const bool written = fwrite(buffer, 1, length, output) == length;
+    free(buffer);
+    return written;
+}
+
+static bool disassembler_run_corpus(struct Disassembler *disassembler) {
+    struct Corpus corpus = {0};
+    pthread_mutex_init(&corpus.lock, NULL);
+
+    if (!corpus_collect(&corpus, disassembler->corpus_directory)) {
+        for (size_t i = 0; i < corpus.entry_count; i++) free(corpus.entries[i].path);
+        free(corpus.entries);
+        pthread_mutex_destroy(&corpus.lock);
+        return false;
+    }
+
+    long thread_count = disassembler->thread_count ? (long)disassembler->thread_count : sysconf(_SC_NPROCESSORS_ONLN);
+    if (thread_count < 1) thread_count = 1;
+
+    pthread_t *threads = malloc(thread_count * sizeof(pthread_t));
+    if (!threads) return false;
+
+    // Only the threads that started are joined, the queue is drained here when none did
+    long started_count = 0;
+    while (started_count < thread_count && pthread_create(&threads[started_count], NULL, corpus_worker, &corpus) == 0) started_count++;
+    if (started_count < thread_count) fprintf(stderr, "Could only start %ld of %ld threads\n", started_count, thread_count);
+
+    if (started_count == 0) {
+        corpus_worker(&corpus);
+        started_count = 1;
+    }
+    else {
+        for (long i = 0; i < started_count; i++) pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    thread_count = started_count;
+
+    if (corpus.entry_count) qsort(corpus.entries, corpus.entry_count, sizeof(struct CorpusEntry), corpus_compare_entries);
+
+    FILE *output = disassembler->output_filename ? fopen(disassembler->output_filename, "wb") : stdout;
+    if (!output) {
+        fprintf(stderr, "Could not open output file %s\n", disassembler->output_filename);
+        return false;
+    }
+
+    size_t unique_count = 0;
+    const bool written = corpus_write_index(&corpus, output, &unique_count);
+    if (output != stdout) fclose(output);
+
+    fprintf(stderr, "Files: %zu, unique roms: %zu, threads: %ld\n", corpus.entry_count, unique_count, thread_count);
+
+    for (size_t i = 0; i < corpus.entry_count; i++) free(corpus.entries[i].path);
+    free(corpus.entries);
+    pthread_mutex_destroy(&corpus.lock);
+
+    return written;
+}
@@ -4,36 +4,140 @@
 #include <stdbool.h>
 
 #include "instruction.h"
+#include "program_analysis.h"
 #include "user_interface/instruction_print.h"
 
+static const uint16_t rom_load_address = 0x200; // CHIP8 roms are loaded to 0x200
+
 struct Disassembler {
     const char *input_filename;
     const char *output_filename;
+    const char *corpus_directory; // Catalogue a whole directory instead of a single file
+    unsigned int thread_count; // For corpus mode, 0 means one per processor
+    enum {
+        LISTING, // Recursive descent, code and data apart
+        LINEAR, // Every byte pair decoded as an instruction
+        DOT,
+        JSON,
+    } output_format;
+    enum InstructionSyntax syntax;
 };
 
+static const char *const usage =
+    "Usage: tracua-chip8-disassembler [--linear | --dot | --json] [--cowgod] [--output <output_filename>] <input_filename>\n"
+    "       tracua-chip8-disassembler --corpus <directory> [--threads <count>] [--output <index_filename>]\n";
+
 static bool consume_command_line_arguments(struct Disassembler *disassembler, int argc, char **argv) {
-    if (argc < 2) {
-        fprintf(stderr, "Usage: %s <input_filename>\n", argv[0]);
+    for (int i = 1; i < argc; i++) {
+         if (strncmp(argv[i], "--output", strlen("--output")) == 0 && i + 1 < argc) {
+             disassembler->output_filename = argv[++i];
+         }
+         else if (strcmp(argv[i], "--corpus") == 0 && i + 1 < argc) {
+             disassembler->corpus_directory = argv[++i];
+         }
+         else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+             disassembler->thread_count = (unsigned int)strtol(argv[++i], NULL, 10);
+         }
+         else if (strcmp(argv[i], "--linear") == 0) disassembler->output_format = LINEAR;
+         else if (strcmp(argv[i], "--dot") == 0) disassembler->output_format = DOT;
+         else if (strcmp(argv[i], "--json") == 0) disassembler->output_format = JSON;
+         else if (strcmp(argv[i], "--cowgod") == 0) disassembler->syntax = INSTRUCTION_SYNTAX_COWGOD;
+         else disassembler->input_filename = argv[i];
+    }
+
+    if (!disassembler->input_filename && !disassembler->corpus_directory) {
+        fputs(usage, stderr);
         return false;
     }
 
-    disassembler->input_filename = argv[argc-1];
-    printf("Opening: %s\n", disassembler->input_filename);
+    return true;
+}
 
-    for (int i = 1; i < argc; i++) {
-         if (strncmp(argv[i], "--output", strlen("--output")) == 0) {
-             disassembler->output_filename = argv[i++];
-         }
+// corpus.c
+static bool disassembler_run_corpus(struct Disassembler *disassembler);
+
+#include "corpus.c"
+
+// Listings are built in memory and written with a single fwrite, a line never takes more than this
+#define DISASSEMBLER_LINE_SIZE 64
+
+static char disassembler_text[(PROGRAM_ANALYSIS_MEMORY_SIZE / 2) * DISASSEMBLER_LINE_SIZE];
+
+static inline char *disassembler_format_address(char *text, uint32_t address) {
+    *text++ = '0';
+    *text++ = 'x';
+    return instruction_format_hex(text, address, 3);
+}
+
+static char *disassembler_format_instruction(char *text, uint16_t address, uint16_t encoded_instruction, enum InstructionSyntax syntax) {
+    text = disassembler_format_address(text, address);
+    *text++ = ':';
+    *text++ = ' ';
+    text = instruction_format_hex(text, encoded_instruction, 4);
+    *text++ = ':';
+    *text++ = ' ';
+    text = instruction_format(text, decoded_instruction_from_encoded_instruction(encoded_instruction), syntax);
+    *text++ = '\n';
+    return text;
+}
+
+static char *disassembler_format_label(char *text, const char *prefix, uint32_t address) {
+    *text++ = '\n';
+    while (*prefix) *text++ = *prefix++;
+    text = disassembler_format_address(text, address);
+    *text++ = ':';
+    *text++ = '\n';
+    return text;
+}
+
+static void disassembler_print_linear(const uint8_t *rom, size_t rom_size, enum InstructionSyntax syntax) {
+    char *text = disassembler_text;
+    for (size_t offset = 0; offset + 1 < rom_size; offset += 2) {
+        text = disassembler_format_instruction(text, rom_load_address + offset, (rom[offset] << 8) | rom[offset+1], syntax);
+    }
+    fwrite(disassembler_text, 1, text - disassembler_text, stdout);
+}
+
+static void disassembler_print_listing(const struct ProgramAnalysis *analysis, enum InstructionSyntax syntax) {
+    uint32_t address = analysis->load_address;
+    char *text = disassembler_text;
+
+    while (address < analysis->rom_end) {
+        if (program_analysis_is_code(analysis, address)) {
+            if (analysis->flags[address] & PROGRAM_ANALYSIS_SUBROUTINE_ENTRY) text = disassembler_format_label(text, "sub_", address);
+            else if (analysis->flags[address] & PROGRAM_ANALYSIS_BLOCK_START) text = disassembler_format_label(text, "block_", address);
+
+            text = disassembler_format_instruction(text, address, program_analysis_encoded_instruction_at(analysis, address), syntax);
+            address += 2;
+        }
+        else {
+            // Group unreached bytes, 8 per line
+            text = disassembler_format_address(text, address);
+            memcpy(text, ": db", 4);
+            text += 4;
+            for (uint8_t i = 0; i < 8 && address < analysis->rom_end && !program_analysis_is_code(analysis, address); i++) {
+                memcpy(text, " 0x", 3);
+                text = instruction_format_hex(text + 3, analysis->memory[address], 2);
+                address++;
+            }
+            *text++ = '\n';
+        }
     }
+    fwrite(disassembler_text, 1, text - disassembler_text, stdout);
 
-    return true;
+    fprintf(stderr, "Blocks: %u, subroutines: %u, code bytes: %u, data bytes: %u\n",
+            analysis->block_count, analysis->subroutine_count, analysis->code_bytes, analysis->data_bytes);
 }
 
 int main(int argc, char **argv) {
     struct Disassembler disassembler = {0};
 
     if (!consume_command_line_arguments(&disassembler, argc, argv)) return EXIT_FAILURE;
+    else if (disassembler.corpus_directory) return disassembler_run_corpus(&disassembler) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    fprintf(stderr, "Opening: %s\n", disassembler.input_filename);
 
+    const size_t max_size = PROGRAM_ANALYSIS_MEMORY_SIZE - rom_load_address;
     uint8_t instruction_buffer[4096] = {0};
 
     FILE *input_file = fopen(disassembler.input_filename, "rb");
@@ -46,36 +150,46 @@ int main(int argc, char **argv) {
     const size_t input_file_size = ftell(input_file);
     rewind(input_file);
 
-    printf("File size: %ld\n", input_file_size);
+    fprintf(stderr, "File size: %lu\n", (long unsigned)input_file_size);
 
-    if (input_file_size > 4096) {
-        fprintf(stderr, "Rom file %s is too big! Rom size: %llu, Max size allowed: %d\n", 
-                disassembler.input_filename, (long long unsigned)input_file_size, 4096);
+    if (input_file_size > max_size) {
+        fprintf(stderr, "Rom file %s is too big! Rom size: %llu, Max size allowed: %llu\n",
+                disassembler.input_filename, (long long unsigned)input_file_size, (long long unsigned)max_size);
         fclose(input_file);
-        return false;
+        return EXIT_FAILURE;
     }
     // Load ROM
-    else if (fread(&instruction_buffer, input_file_size, 1, input_file) != 1) {
-        fprintf(stderr, "Could not read Rom file %s into buffer\n", 
+    else if (input_file_size > 0 && fread(&instruction_buffer, input_file_size, 1, input_file) != 1) {
+        fprintf(stderr, "Could not read Rom file %s into buffer\n",
                 disassembler.input_filename);
         fclose(input_file);
-        return false;
+        return EXIT_FAILURE;
     }
 
-    bool keep_reading = true;
-    long unsigned int I = 0;
-    while (keep_reading) {
-        const uint16_t current_instruction = (instruction_buffer[I] << 8) | instruction_buffer[I+1];
-        if (I >= input_file_size) keep_reading = false;
-        else {
-            I += 2;
-            printf("%lu: %04x: ", I, current_instruction);
-            struct DecodedInstruction decoded_intruction = decoded_instruction_from_encoded_instruction(current_instruction);
-            instruction_decoded_print(decoded_intruction);
-        }
+    fclose(input_file);
+
+    if (disassembler.output_filename && !freopen(disassembler.output_filename, "w", stdout)) {
+        fprintf(stderr, "Could not open output file %s\n", disassembler.output_filename);
+        return EXIT_FAILURE;
     }
 
-    fclose(input_file);
+    if (disassembler.output_format == LINEAR) {
+        disassembler_print_linear(instruction_buffer, input_file_size, disassembler.syntax);
+        return EXIT_SUCCESS;
+    }
+
+    static struct ProgramAnalysis analysis;
+    program_analysis_run(&analysis, instruction_buffer, input_file_size, rom_load_address);
+
+    switch (disassembler.output_format) {
+        case DOT: program_analysis_write_dot(&analysis, stdout); break;
+        case JSON: program_analysis_write_json(&analysis, stdout); break;
+        case LISTING:
+        case LINEAR:
+        default:
+            disassembler_print_listing(&analysis, disassembler.syntax);
+            break;
+    }
 
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -0,0 +1,59 @@
+// Runs a rom for a few seconds through the embedding API, holding a key, and prints the screen
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "tracua_chip8.h"
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <rom_name> [key 0-F to hold]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (tracua_chip8_abi_version() != TRACUA_CHIP8_ABI_VERSION) {
+        fprintf(stderr, "Built against ABI %d, library has %u\n", TRACUA_CHIP8_ABI_VERSION, tracua_chip8_abi_version());
+        return EXIT_FAILURE;
+    }
+
+    FILE *file = fopen(argv[1], "rb");
+    if (!file) {
+        fprintf(stderr, "Rom file %s is invalid or does not exist\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    uint8_t rom[4096];
+    const size_t rom_size = fread(rom, 1, sizeof rom, file);
+    fclose(file);
+
+    TracuaChip8 *chip8 = tracua_chip8_create(rom, rom_size, TRACUA_CHIP8_EXTENSION_AUTO);
+    if (!chip8) {
+        fprintf(stderr, "Rom file %s does not fit in memory\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    if (argc > 2) tracua_chip8_set_keypad(chip8, 1u << (strtoul(argv[2], NULL, 16) & 0xF));
+
+    const uint64_t executed = tracua_chip8_step_frames(chip8, 3 * 60);
+
+    const struct TracuaChip8Registers *registers = tracua_chip8_registers(chip8);
+    printf("%llu instructions, PC %03x, I %03x, V0 %02x%s\n", (long long unsigned)executed,
+           registers->PC, registers->I, registers->V[0], tracua_chip8_is_running(chip8) ? "" : ", stopped");
+
+    struct TracuaChip8Display display;
+    tracua_chip8_display(chip8, &display);
+
+    for (uint32_t y = 0; y < display.height; y++) {
+        const uint8_t *row = (const uint8_t *)display.pixels + y * display.row_stride;
+
+        for (uint32_t x = 0; x < display.width; x++) {
+            bool is_on;
+            if (display.format == TRACUA_CHIP8_DISPLAY_ROWS_U64) is_on = (*(const uint64_t *)row >> (63 - x)) & 1;
+            else is_on = row[x];
+            putchar(is_on ? '#' : '.');
+        }
+        putchar('\n');
+    }
+
+    tracua_chip8_destroy(chip8);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,82 @@
+// Auto-tuner decisions, once per window:
+//  - guest spinning on Fx07 means it paces itself with the delay timer and the budget is more than it needs
+//  - without delay timer reads, the draw rate is the only hint, kept between 1 and 4 per frame
+//  - the budget only grows while the host has headroom, and shrinks when it has almost none
+
+#include <stdio.h>
+
+#include "autotune.h"
+
+#define AUTOTUNE_SPINNING_READS_PER_FRAME 2.0
+#define AUTOTUNE_MINIMUM_DRAWS_PER_FRAME 1.0
+#define AUTOTUNE_MAXIMUM_DRAWS_PER_FRAME 4.0
+#define AUTOTUNE_GROWTH_HEADROOM 0.25 // Fraction of the frame that must be left to grow
+#define AUTOTUNE_SHRINK_HEADROOM 0.10
+
+// The budget has to start inside the limits
+static void autotune_clamp(const struct Autotune *autotune, struct EmulatedSystem *emulated_system) {
+    if (emulated_system->instructions_per_frame < autotune->minimum) emulated_system->instructions_per_frame = autotune->minimum;
+    if (emulated_system->instructions_per_frame > autotune->maximum) emulated_system->instructions_per_frame = autotune->maximum;
+}
+
+void autotune_begin(struct Autotune *autotune, const struct RomProfile *rom_profile, struct EmulatedSystem *emulated_system) {
+    *autotune = (struct Autotune){
+        .is_enabled = true,
+        .minimum = rom_profile->instructions_per_frame_minimum ? rom_profile->instructions_per_frame_minimum : ROM_PROFILE_DEFAULT_MINIMUM_INSTRUCTIONS_PER_FRAME,
+        .maximum = rom_profile->instructions_per_frame_maximum ? rom_profile->instructions_per_frame_maximum : ROM_PROFILE_DEFAULT_MAXIMUM_INSTRUCTIONS_PER_FRAME,
+        .draw_count = emulated_system->draw_count,
+        .delay_timer_read_count = emulated_system->delay_timer_read_count,
+    };
+
+    autotune_clamp(autotune, emulated_system);
+}
+
+// -1 to shrink, 1 to grow, 0 to keep the budget
+static int autotune_decide(const struct Autotune *autotune, double draws_per_frame, double reads_per_frame) {
+    const double headroom = 1.0 - (double)autotune->busy_ns / autotune->frame_ns;
+
+    if (headroom < AUTOTUNE_SHRINK_HEADROOM) return -1;
+    if (draws_per_frame == 0 && reads_per_frame == 0) return 0; // Waiting for a key or halted, nothing to learn
+
+    if (reads_per_frame >= AUTOTUNE_SPINNING_READS_PER_FRAME) return -1;
+    if (reads_per_frame > 0) return 0;
+
+    if (draws_per_frame > AUTOTUNE_MAXIMUM_DRAWS_PER_FRAME) return -1;
+    if (draws_per_frame < AUTOTUNE_MINIMUM_DRAWS_PER_FRAME && headroom > AUTOTUNE_GROWTH_HEADROOM) return 1;
+    return 0;
+}
+
+bool autotune_frame(struct Autotune *autotune, struct EmulatedSystem *emulated_system, uint64_t busy_ns, uint64_t frame_ns) {
+    if (!autotune->is_enabled || autotune->is_settled) return false;
+
+    autotune->busy_ns += busy_ns;
+    autotune->frame_ns += frame_ns;
+    if (++autotune->frame_count < AUTOTUNE_WINDOW_FRAMES) return false;
+
+    // Counters wrap, differences are still right
+    const double draws_per_frame = (double)(emulated_system->draw_count - autotune->draw_count) / autotune->frame_count;
+    const double reads_per_frame = (double)(emulated_system->delay_timer_read_count - autotune->delay_timer_read_count) / autotune->frame_count;
+    const int decision = autotune_decide(autotune, draws_per_frame, reads_per_frame);
+
+    const unsigned int budget = emulated_system->instructions_per_frame;
+    const unsigned int step = (budget / 8 > 0) ? budget / 8 : 1;
+    unsigned int new_budget = budget;
+
+    if (decision > 0) new_budget = (budget + step < autotune->maximum) ? budget + step : autotune->maximum;
+    else if (decision < 0) new_budget = (budget > autotune->minimum + step) ? budget - step : autotune->minimum;
+
+    emulated_system->instructions_per_frame = new_budget;
+    autotune->stable_windows = (new_budget == budget) ? autotune->stable_windows + 1 : 0;
+
+    autotune->frame_count = 0;
+    autotune->busy_ns = 0;
+    autotune->frame_ns = 0;
+    autotune->draw_count = emulated_system->draw_count;
+    autotune->delay_timer_read_count = emulated_system->delay_timer_read_count;
+
+    if (autotune->stable_windows < AUTOTUNE_STABLE_WINDOWS) return false;
+
+    autotune->is_settled = true;
+    fprintf(stderr, "Settled on %u instructions per frame\n", new_budget);
+    return true;
+}
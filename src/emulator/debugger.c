@@ -0,0 +1,317 @@
+// Debug dispatch loop, breakpoints, watchpoints and breakpoint conditions
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "debugger.h"
+
+static inline bool debugger_has_breakpoint(const struct Debugger *debugger, uint16_t address) {
+    return (debugger->breakpoints[(address >> 6) & 63] >> (address & 63)) & 1;
+}
+
+bool debugger_add_breakpoint(struct Debugger *debugger, uint16_t address, const char *condition) {
+    address &= 0x0FFF;
+
+    if (condition) {
+        if (debugger->condition_count == DEBUGGER_MAX_CONDITIONS) {
+            fprintf(stderr, "Too many breakpoint conditions\n");
+            return false;
+        }
+
+        struct DebuggerCondition *compiled = &debugger->conditions[debugger->condition_count];
+        compiled->address = address;
+        if (!debugger_compile_condition(condition, compiled->code, sizeof compiled->code)) {
+            fprintf(stderr, "Invalid breakpoint condition: %s\n", condition);
+            return false;
+        }
+        debugger->condition_count++;
+    }
+
+    debugger->breakpoints[address >> 6] |= 1ull << (address & 63);
+    debugger->is_active = true;
+    return true;
+}
+
+bool debugger_add_watchpoint(struct Debugger *debugger, uint16_t first, uint16_t last, int access) {
+    if (debugger->watchpoint_count == DEBUGGER_MAX_WATCHPOINTS) {
+        fprintf(stderr, "Too many watchpoints\n");
+        return false;
+    }
+
+    debugger->watchpoints[debugger->watchpoint_count++] = (struct DebuggerWatchpoint){
+        .first = first,
+        .last = (last < first) ? first : last,
+        .access = access,
+    };
+    debugger->is_active = true;
+    return true;
+}
+
+void debugger_watch_I(struct Debugger *debugger) {
+    debugger->watch_I = true;
+    debugger->is_active = true;
+}
+
+// Condition compiler: recursive descent straight into bytecode
+//
+//   or         := and ('||' and)*
+//   and        := comparison ('&&' comparison)*
+//   comparison := unary (('==' | '!=' | '<' | '<=' | '>' | '>=') unary)?
+//   unary      := '!' unary | '(' or ')' | V0-VF | I | PC | DT | ST | number
+
+struct DebuggerConditionCompiler {
+    const char *text;
+    uint8_t *code;
+    size_t code_size;
+    size_t length;
+    bool has_failed;
+};
+
+static void debugger_condition_skip_spaces(struct DebuggerConditionCompiler *compiler) {
+    while (isspace((unsigned char)*compiler->text)) compiler->text++;
+}
+
+static bool debugger_condition_accept(struct DebuggerConditionCompiler *compiler, const char *token) {
+    debugger_condition_skip_spaces(compiler);
+
+    if (strncmp(compiler->text, token, strlen(token)) != 0) return false;
+    compiler->text += strlen(token);
+    return true;
+}
+
+static void debugger_condition_emit(struct DebuggerConditionCompiler *compiler, uint8_t byte) {
+    // Room is always kept for CONDITION_END
+    if (compiler->length + 1 >= compiler->code_size) compiler->has_failed = true;
+    else compiler->code[compiler->length++] = byte;
+}
+
+static void debugger_condition_or(struct DebuggerConditionCompiler *compiler);
+
+static void debugger_condition_unary(struct DebuggerConditionCompiler *compiler) {
+    debugger_condition_skip_spaces(compiler);
+    const char *text = compiler->text;
+
+    if (debugger_condition_accept(compiler, "!")) {
+        debugger_condition_unary(compiler);
+        debugger_condition_emit(compiler, CONDITION_NOT);
+    }
+    else if (debugger_condition_accept(compiler, "(")) {
+        debugger_condition_or(compiler);
+        if (!debugger_condition_accept(compiler, ")")) compiler->has_failed = true;
+    }
+    else if ((text[0] == 'V' || text[0] == 'v') && isxdigit((unsigned char)text[1]) && !isalnum((unsigned char)text[2])) {
+        const char digit[2] = {text[1], '\0'};
+        debugger_condition_emit(compiler, CONDITION_PUSH_REGISTER);
+        debugger_condition_emit(compiler, (uint8_t)strtol(digit, NULL, 16));
+        compiler->text += 2;
+    }
+    else if (debugger_condition_accept(compiler, "PC")) debugger_condition_emit(compiler, CONDITION_PUSH_PC);
+    else if (debugger_condition_accept(compiler, "DT")) debugger_condition_emit(compiler, CONDITION_PUSH_DELAY_TIMER);
+    else if (debugger_condition_accept(compiler, "ST")) debugger_condition_emit(compiler, CONDITION_PUSH_SOUND_TIMER);
+    else if (debugger_condition_accept(compiler, "I")) debugger_condition_emit(compiler, CONDITION_PUSH_I);
+    else if (isdigit((unsigned char)text[0])) {
+        char *end;
+        const unsigned long value = strtoul(text, &end, 0);
+        if (value > 0xFFFF) compiler->has_failed = true;
+
+        debugger_condition_emit(compiler, CONDITION_PUSH_CONSTANT);
+        debugger_condition_emit(compiler, (value >> 8) & 0xFF);
+        debugger_condition_emit(compiler, value & 0xFF);
+        compiler->text = end;
+    }
+    else compiler->has_failed = true;
+}
+
+static void debugger_condition_comparison(struct DebuggerConditionCompiler *compiler) {
+    // Longest tokens first
+    static const struct { const char *token; uint8_t opcode; } comparisons[] = {
+        {"==", CONDITION_EQUAL},
+        {"!=", CONDITION_NOT_EQUAL},
+        {"<=", CONDITION_LESS_EQUAL},
+        {">=", CONDITION_GREATER_EQUAL},
+        {"<", CONDITION_LESS},
+        {">", CONDITION_GREATER},
+    };
+
+    debugger_condition_unary(compiler);
+
+    for (size_t i = 0; i < sizeof comparisons / sizeof comparisons[0]; i++) {
+        if (debugger_condition_accept(compiler, comparisons[i].token)) {
+            debugger_condition_unary(compiler);
+            debugger_condition_emit(compiler, comparisons[i].opcode);
+            return;
+        }
+    }
+}
+
+static void debugger_condition_and(struct DebuggerConditionCompiler *compiler) {
+    debugger_condition_comparison(compiler);
+
+    while (!compiler->has_failed && debugger_condition_accept(compiler, "&&")) {
+        debugger_condition_comparison(compiler);
+        debugger_condition_emit(compiler, CONDITION_AND);
+    }
+}
+
+static void debugger_condition_or(struct DebuggerConditionCompiler *compiler) {
+    debugger_condition_and(compiler);
+
+    while (!compiler->has_failed && debugger_condition_accept(compiler, "||")) {
+        debugger_condition_and(compiler);
+        debugger_condition_emit(compiler, CONDITION_OR);
+    }
+}
+
+bool debugger_compile_condition(const char *text, uint8_t *code, size_t code_size) {
+    struct DebuggerConditionCompiler compiler = {
+        .text = text,
+        .code = code,
+        .code_size = code_size,
+    };
+
+    debugger_condition_or(&compiler);
+    debugger_condition_skip_spaces(&compiler);
+    if (*compiler.text != '\0') compiler.has_failed = true;
+
+    code[compiler.length] = CONDITION_END;
+    return !compiler.has_failed;
+}
+
+uint16_t debugger_evaluate_condition(const uint8_t *code, const struct EmulatedSystem *emulated_system) {
+    uint16_t stack[DEBUGGER_CONDITION_STACK_SIZE];
+    uint8_t top = 0; // Number of values in the stack
+
+    for (const uint8_t *opcode = code; *opcode != CONDITION_END; opcode++) {
+        // Binary operators pop 2 values and push 1, pushes grow the stack
+        if (*opcode >= CONDITION_EQUAL && *opcode <= CONDITION_OR && top < 2) return 0;
+        if (*opcode <= CONDITION_PUSH_SOUND_TIMER && top == DEBUGGER_CONDITION_STACK_SIZE) return 0;
+
+        const uint16_t a = (top >= 2) ? stack[top - 2] : 0;
+        const uint16_t b = (top >= 1) ? stack[top - 1] : 0;
+
+        switch (*opcode) {
+            case CONDITION_PUSH_CONSTANT:
+                stack[top++] = (opcode[1] << 8) | opcode[2];
+                opcode += 2;
+                break;
+            case CONDITION_PUSH_REGISTER:
+                stack[top++] = emulated_system->V[opcode[1] & 0x0F];
+                opcode++;
+                break;
+            case CONDITION_PUSH_I: stack[top++] = emulated_system->I; break;
+            case CONDITION_PUSH_PC: stack[top++] = emulated_system->PC; break;
+            case CONDITION_PUSH_DELAY_TIMER: stack[top++] = emulated_system->delay_timer; break;
+            case CONDITION_PUSH_SOUND_TIMER: stack[top++] = emulated_system->sound_timer; break;
+            case CONDITION_EQUAL: stack[--top - 1] = a == b; break;
+            case CONDITION_NOT_EQUAL: stack[--top - 1] = a != b; break;
+            case CONDITION_LESS: stack[--top - 1] = a < b; break;
+            case CONDITION_LESS_EQUAL: stack[--top - 1] = a <= b; break;
+            case CONDITION_GREATER: stack[--top - 1] = a > b; break;
+            case CONDITION_GREATER_EQUAL: stack[--top - 1] = a >= b; break;
+            case CONDITION_AND: stack[--top - 1] = a && b; break;
+            case CONDITION_OR: stack[--top - 1] = a || b; break;
+            case CONDITION_NOT:
+                if (top == 0) return 0;
+                stack[top - 1] = !b;
+                break;
+            default:
+                return 0;
+        }
+    }
+
+    return (top > 0) ? stack[top - 1] : 0;
+}
+
+// True when no condition is attached to the breakpoint or any of them holds
+static bool debugger_breakpoint_condition_holds(const struct Debugger *debugger, const struct EmulatedSystem *emulated_system) {
+    bool has_condition = false;
+
+    for (uint8_t i = 0; i < debugger->condition_count; i++) {
+        if (debugger->conditions[i].address != emulated_system->PC) continue;
+
+        has_condition = true;
+        if (debugger_evaluate_condition(debugger->conditions[i].code, emulated_system)) return true;
+    }
+
+    return !has_condition;
+}
+
+// Memory the decoded instruction is about to touch, false if none
+static bool debugger_memory_access(const struct EmulatedSystem *emulated_system, uint16_t *first, uint16_t *last, int *access) {
+    const struct DecodedInstruction *decoded_instruction = &emulated_system->decoded_instruction;
+
+    if (decoded_instruction->type == DRAW) {
+        if (decoded_instruction->half_value == 0) return false;
+        *first = emulated_system->I;
+        *last = emulated_system->I + decoded_instruction->half_value - 1;
+        *access = WATCH_READ;
+        return true;
+    }
+    else if (decoded_instruction->type == MISC) {
+        *first = emulated_system->I;
+        switch (decoded_instruction->value) {
+            case 0x33: *last = emulated_system->I + 2; *access = WATCH_WRITE; return true;
+            case 0x55: *last = emulated_system->I + decoded_instruction->register_index; *access = WATCH_WRITE; return true;
+            case 0x65: *last = emulated_system->I + decoded_instruction->register_index; *access = WATCH_READ; return true;
+        }
+    }
+
+    return false;
+}
+
+static void debugger_stop(struct Debugger *debugger, struct EmulatedSystem *emulated_system, uint16_t address) {
+    debugger->is_stopped = true;
+    debugger->stopped_at = address;
+    emulated_system->state = PAUSE;
+}
+
+unsigned int debugger_run(struct Debugger *debugger, struct EmulatedSystem *emulated_system,
+                          EmulatedSystemCore emulate_decoded_instruction, unsigned int count) {
+    unsigned int executed = 0;
+
+    while (executed < count && emulated_system->state == RUNNING) {
+        const uint16_t PC = emulated_system->PC;
+
+        if (debugger_has_breakpoint(debugger, PC)
+            && !(debugger->is_stopped && debugger->stopped_at == PC)
+            && debugger_breakpoint_condition_holds(debugger, emulated_system)) {
+            fprintf(stderr, "Breakpoint at 0x%03x\n", PC);
+            debugger_stop(debugger, emulated_system, PC);
+            break;
+        }
+        debugger->is_stopped = false;
+
+        if (!emulated_system_consume_instruction(emulated_system)) break;
+
+        const uint16_t I = emulated_system->I;
+        uint16_t first, last;
+        int access;
+        const bool touches_memory = debugger->watchpoint_count > 0 && debugger_memory_access(emulated_system, &first, &last, &access);
+
+        emulate_decoded_instruction(emulated_system);
+        executed++;
+
+        if (touches_memory) {
+            for (uint8_t i = 0; i < debugger->watchpoint_count; i++) {
+                const struct DebuggerWatchpoint *watchpoint = &debugger->watchpoints[i];
+
+                if ((watchpoint->access & access) && first <= watchpoint->last && last >= watchpoint->first) {
+                    fprintf(stderr, "Watchpoint 0x%03x-0x%03x: %s 0x%03x-0x%03x at 0x%03x\n",
+                            watchpoint->first, watchpoint->last, (access == WATCH_READ) ? "read" : "write", first, last, PC);
+                    debugger_stop(debugger, emulated_system, emulated_system->PC);
+                    return executed;
+                }
+            }
+        }
+
+        if (debugger->watch_I && emulated_system->I != I) {
+            fprintf(stderr, "I changed at 0x%03x: 0x%03x -> 0x%03x\n", PC, I, emulated_system->I);
+            debugger_stop(debugger, emulated_system, emulated_system->PC);
+            break;
+        }
+    }
+
+    return executed;
+}
@@ -0,0 +1,141 @@
+// Interpreter core, included by emulated.c once per quirk set.
+//
+// Expects defined before inclusion:
+//   EMULATED_CORE_NAME(name): gives each function in here a name unique to the quirk set
+//   EMULATED_CORE_QUIRK_VF_RESET: 8XY1/8XY2/8XY3 reset VF
+//   EMULATED_CORE_QUIRK_SHIFT_VY: 8XY6/8XYE shift VY into VX instead of shifting VX in place
+//   EMULATED_CORE_QUIRK_LOAD_INCREMENTS_I: FX65 leaves I incremented
+// Quirks are constants for the specialized cores, so their branches fold away.
+
+void EMULATED_CORE_NAME(emulate_decoded_instruction)(struct EmulatedSystem *emulated_system) {
+    struct DecodedInstruction *decoded_instruction = &emulated_system->decoded_instruction;
+
+
+    // Maybe transform register indexes into pointers to the registers
+    uint8_t *register_pointers[2];
+    uint8_t *register_pointer;
+
+    switch (decoded_instruction->operands_layout) {
+        case REGISTER_AND_VALUE:
+            register_pointer = &emulated_system->V[decoded_instruction->register_index];
+            break;
+        case REGISTERS_AND_HALF_VALUE:
+            register_pointers[0] = &emulated_system->V[decoded_instruction->register_indexes[0]];
+            register_pointers[1] = &emulated_system->V[decoded_instruction->register_indexes[1]];
+            break;
+        default:
+        case ADDRESS:
+        case NONE:
+            break;
+    }
+
+    uint8_t *carry = &emulated_system->V[0xF];
+
+    switch (decoded_instruction->type) {
+        case CLEAR:
+            memset(emulated_system->display, false, sizeof(emulated_system->display));
+            break;
+        case JUMP:
+            emulated_system->PC = decoded_instruction->address;
+            break;
+        case RETURN:
+            emulated_system->PC = emulated_system->stack[--emulated_system->SP];
+            break;
+
+        case SUBROUTINE:
+            emulated_system->stack[emulated_system->SP++] = emulated_system->PC;  
+            emulated_system->PC = decoded_instruction->address;
+            break;
+        case IF_EQUAL_THEN_SKIP:
+        case IF_NOT_EQUAL_THEN_SKIP:
+            if (emulated_system_should_skip_by_value(emulated_system)) emulated_system->PC += 2;
+            break;
+        case VALUE_TO_REGISTER:
+            *register_pointer = decoded_instruction->value;
+            break;
+        case SUM_REGISTER:
+            *register_pointer += decoded_instruction->value;
+            break;
+        case REGISTER_TO_REGISTER:
+            *register_pointers[0] = *register_pointers[1];
+            break;
+        case OR_REGISTERS:
+            *register_pointers[0] |= *register_pointers[1];
+            if (EMULATED_CORE_QUIRK_VF_RESET) *carry = 0;
+            break;
+        case AND_REGISTERS:
+            *register_pointers[0] &= *register_pointers[1];
+            if (EMULATED_CORE_QUIRK_VF_RESET) *carry = 0;
+            break;
+        case XOR_REGISTERS:
+            *register_pointers[0] ^= *register_pointers[1];
+            if (EMULATED_CORE_QUIRK_VF_RESET) *carry = 0;
+            break;
+        case SUM_REGISTERS: {
+            uint16_t result = *register_pointers[0] + *register_pointers[1]; // Fixed typo
+            uint8_t flag = (result > 255);
+            *register_pointers[0] = result & 0xFF;
+            *carry = flag;
+            break;
+        }
+        case SUBTRACT_REGISTERS: {
+            uint8_t flag = (*register_pointers[0] >= *register_pointers[1]);
+            uint8_t result = *register_pointers[0] - *register_pointers[1];
+            *register_pointers[0] = result;
+            *carry = flag; // Set flag after register mutation
+            break;
+        }
+        case SHIFT_RIGHT_REGISTER:
+            if (EMULATED_CORE_QUIRK_SHIFT_VY) {
+                *carry = *register_pointers[1] & 1; // Use VY
+                *register_pointers[0] = *register_pointers[1] >> 1; // Set VX = VY result
+            } else {
+                *carry = *register_pointers[0] & 1;    // Use VX
+                *register_pointers[0] >>= 1;          // Use VX
+            }
+            break;
+        case INVERT_SUBTRACT_REGISTERS: {
+            uint8_t flag = (*register_pointers[1] >= *register_pointers[0]);
+            uint8_t result = *register_pointers[1] - *register_pointers[0];
+            *register_pointers[0] = result;
+            *carry = flag;
+            break;
+        }
+        case SHIFT_LEFT_REGISTER:
+            if (EMULATED_CORE_QUIRK_SHIFT_VY) { 
+                *carry = (*register_pointers[1] & 0x80) >> 7; // Use VY
+                *register_pointers[0] = *register_pointers[1] << 1; // Set VX = VY result
+            } else {
+                *carry = (*register_pointers[0] & 0x80) >> 7; // VX
+                *register_pointers[0] <<= 1; // Use VX
+            }
+            break;
+        case ADDRESS_TO_REGISTER_I:
+            emulated_system->I = decoded_instruction->address;
+            break;
+        case JUMP_WITH_OFFSET:
+            emulated_system->PC = emulated_system->V[0] + decoded_instruction->address;
+            break;
+        case RANDOM_NUMBER_TO_REGISTER:
+            emulated_system->V[decoded_instruction->register_index] = (rand() % 256) & decoded_instruction->value;
+            break;
+        case DRAW:
+            emulated_system->draw_count++;
+            emulated_system_emulate_draw(emulated_system);
+            break;
+        case IF_PRESSED_THEN_SKIP:
+            if (emulated_system_should_skip_by_key_pressed(emulated_system)) emulated_system->PC += 2;
+            break;
+        case IF_NOT_PRESSED_THEN_SKIP:
+            if (!emulated_system_should_skip_by_key_pressed(emulated_system)) emulated_system->PC += 2;
+            break;
+        case MISC:
+            EMULATED_CORE_NAME(emulate_misc)(emulated_system);
+            break;
+        case INVALID:
+        default:
+            emulated_system->state = QUIT;
+            fprintf(stderr, "Instrução inválida: %04X\n", emulated_system->encoded_instruction);
+            return;
+    }
+}
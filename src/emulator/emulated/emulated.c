@@ -3,21 +3,20 @@
 #include <string.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <stddef.h>
 
 #include "emulated.h"
 
+_Static_assert(offsetof(struct EmulatedSystem, draw_count) + sizeof(uint32_t) <= 64, "registers no longer fit in the first cache line");
+
 // draw.c
 static void emulated_system_emulate_draw(struct EmulatedSystem *emulated_system);
 
-// misc.c
-static void emulated_system_emulate_misc(struct EmulatedSystem *emulated_system);
-
 // should_skip.c
 static inline bool emulated_system_should_skip_by_key_pressed(struct EmulatedSystem *emulated_system);
 static bool emulated_system_should_skip_by_value(struct EmulatedSystem *emulated_system);
 
 #include "draw.c"
-#include "misc.c"
 #include "should_skip.c"
 
 const uint32_t emulated_system_entry_point = 0x200; // CHIP8 Roms will be loaded to 0x200
@@ -75,134 +74,54 @@ bool emulated_system_consume_instruction(struct EmulatedSystem *emulated_system)
     return true;
 }
 
-void emulated_system_emulate_decoded_instruction(struct EmulatedSystem *emulated_system) {
-    struct DecodedInstruction *decoded_instruction = &emulated_system->decoded_instruction;
-
-
-    // Maybe transform register indexes into pointers to the registers
-    uint8_t *register_pointers[2];
-    uint8_t *register_pointer;
-
-    switch (decoded_instruction->operands_layout) {
-        case REGISTER_AND_VALUE:
-            register_pointer = &emulated_system->V[decoded_instruction->register_index];
-            break;
-        case REGISTERS_AND_HALF_VALUE:
-            register_pointers[0] = &emulated_system->V[decoded_instruction->register_indexes[0]];
-            register_pointers[1] = &emulated_system->V[decoded_instruction->register_indexes[1]];
-            break;
-        default:
-        case ADDRESS:
-        case NONE:
-            break;
-    }
 
-    uint8_t *carry = &emulated_system->V[0xF];
-
-    switch (decoded_instruction->type) {
-        case CLEAR:
-            memset(emulated_system->display, false, sizeof(emulated_system->display));
-            break;
-        case JUMP:
-            emulated_system->PC = decoded_instruction->address;
-            break;
-        case RETURN:
-            emulated_system->PC = emulated_system->stack[--emulated_system->SP];
-            break;
-
-        case SUBROUTINE:
-            emulated_system->stack[emulated_system->SP++] = emulated_system->PC;  
-            emulated_system->PC = decoded_instruction->address;
-            break;
-        case IF_EQUAL_THEN_SKIP:
-        case IF_NOT_EQUAL_THEN_SKIP:
-            if (emulated_system_should_skip_by_value(emulated_system)) emulated_system->PC += 2;
-            break;
-        case VALUE_TO_REGISTER:
-            *register_pointer = decoded_instruction->value;
-            break;
-        case SUM_REGISTER:
-            *register_pointer += decoded_instruction->value;
-            break;
-        case REGISTER_TO_REGISTER:
-            *register_pointers[0] = *register_pointers[1];
-            break;
-        case OR_REGISTERS:
-            *register_pointers[0] |= *register_pointers[1];
-            if (emulated_system->extension == CHIP8) *carry = 0;
-            break;
-        case AND_REGISTERS:
-            *register_pointers[0] &= *register_pointers[1];
-            if (emulated_system->extension == CHIP8) *carry = 0;
-            break;
-        case XOR_REGISTERS:
-            *register_pointers[0] ^= *register_pointers[1];
-            if (emulated_system->extension == CHIP8) *carry = 0;
-            break;
-        case SUM_REGISTERS: {
-            uint16_t result = *register_pointers[0] + *register_pointers[1]; // Fixed typo
-            uint8_t flag = (result > 255);
-            *register_pointers[0] = result & 0xFF;
-            *carry = flag;
-            break;
-        }
-        case SUBTRACT_REGISTERS: {
-            uint8_t flag = (*register_pointers[0] >= *register_pointers[1]);
-            uint8_t result = *register_pointers[0] - *register_pointers[1];
-            *register_pointers[0] = result;
-            *carry = flag; // Set flag after register mutation
-            break;
-        }
-        case SHIFT_RIGHT_REGISTER:
-            if (emulated_system->extension == CHIP8) {
-                *carry = *register_pointers[1] & 1; // Use VY
-                *register_pointers[0] = *register_pointers[1] >> 1; // Set VX = VY result
-            } else {
-                *carry = *register_pointers[0] & 1;    // Use VX
-                *register_pointers[0] >>= 1;          // Use VX
-            }
-            break;
-        case INVERT_SUBTRACT_REGISTERS: {
-            uint8_t flag = (*register_pointers[1] >= *register_pointers[0]);
-            uint8_t result = *register_pointers[1] - *register_pointers[0];
-            *register_pointers[0] = result;
-            *carry = flag;
-            break;
-        }
-        case SHIFT_LEFT_REGISTER:
-            if (emulated_system->extension == CHIP8) { 
-                *carry = (*register_pointers[1] & 0x80) >> 7; // Use VY
-                *register_pointers[0] = *register_pointers[1] << 1; // Set VX = VY result
-            } else {
-                *carry = (*register_pointers[0] & 0x80) >> 7; // VX
-                *register_pointers[0] <<= 1; // Use VX
-            }
-            break;
-        case ADDRESS_TO_REGISTER_I:
-            emulated_system->I = decoded_instruction->address;
-            break;
-        case JUMP_WITH_OFFSET:
-            emulated_system->PC = emulated_system->V[0] + decoded_instruction->address;
-            break;
-        case RANDOM_NUMBER_TO_REGISTER:
-            emulated_system->V[decoded_instruction->register_index] = (rand() % 256) & decoded_instruction->value;
-            break;
-        case DRAW:
-            emulated_system_emulate_draw(emulated_system);
-            break;
-        case IF_PRESSED_THEN_SKIP:
-            if (emulated_system_should_skip_by_key_pressed(emulated_system)) emulated_system->PC += 2;
-            break;
-        case IF_NOT_PRESSED_THEN_SKIP:
-            if (!emulated_system_should_skip_by_key_pressed(emulated_system)) emulated_system->PC += 2;
-            break;
-        case MISC:
-            emulated_system_emulate_misc(emulated_system);
-            break;
-        case INVALID:
-        default:
-            emulated_system->state = QUIT;
-            fprintf(stderr, "Instrução inválida: %04X\n", emulated_system->encoded_instruction);
-            return;
+// Interpreter cores (misc.c and core.c), one per quirk set
+
+// Original COSMAC VIP behaviour
+#define EMULATED_CORE_NAME(name) emulated_system_chip8_##name
+#define EMULATED_CORE_QUIRK_VF_RESET true
+#define EMULATED_CORE_QUIRK_SHIFT_VY true
+#define EMULATED_CORE_QUIRK_LOAD_INCREMENTS_I true
+#include "misc.c"
+#include "core.c"
+#undef EMULATED_CORE_NAME
+#undef EMULATED_CORE_QUIRK_VF_RESET
+#undef EMULATED_CORE_QUIRK_SHIFT_VY
+#undef EMULATED_CORE_QUIRK_LOAD_INCREMENTS_I
+
+// SUPER-CHIP behaviour, also used for XO-CHIP for now
+#define EMULATED_CORE_NAME(name) emulated_system_superchip_##name
+#define EMULATED_CORE_QUIRK_VF_RESET false
+#define EMULATED_CORE_QUIRK_SHIFT_VY false
+#define EMULATED_CORE_QUIRK_LOAD_INCREMENTS_I false
+#include "misc.c"
+#include "core.c"
+#undef EMULATED_CORE_NAME
+#undef EMULATED_CORE_QUIRK_VF_RESET
+#undef EMULATED_CORE_QUIRK_SHIFT_VY
+#undef EMULATED_CORE_QUIRK_LOAD_INCREMENTS_I
+
+// Quirks checked at runtime, kept as a baseline for benchmarks
+#define EMULATED_CORE_NAME(name) emulated_system_generic_##name
+#define EMULATED_CORE_QUIRK_VF_RESET (emulated_system->extension == CHIP8)
+#define EMULATED_CORE_QUIRK_SHIFT_VY (emulated_system->extension == CHIP8)
+#define EMULATED_CORE_QUIRK_LOAD_INCREMENTS_I (emulated_system->extension == CHIP8)
+#include "misc.c"
+#include "core.c"
+#undef EMULATED_CORE_NAME
+#undef EMULATED_CORE_QUIRK_VF_RESET
+#undef EMULATED_CORE_QUIRK_SHIFT_VY
+#undef EMULATED_CORE_QUIRK_LOAD_INCREMENTS_I
+
+EmulatedSystemCore emulated_system_core(const struct EmulatedSystem *emulated_system) {
+    switch (emulated_system->extension) {
+        case CHIP8: return emulated_system_chip8_emulate_decoded_instruction;
+        case SUPERCHIP:
+        case XOCHIP: return emulated_system_superchip_emulate_decoded_instruction;
+        default: return emulated_system_generic_emulate_decoded_instruction;
     }
 }
+
+void emulated_system_emulate_decoded_instruction(struct EmulatedSystem *emulated_system) {
+    emulated_system_core(emulated_system)(emulated_system);
+}
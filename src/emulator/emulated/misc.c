@@ -1,11 +1,12 @@
-static void emulated_system_emulate_misc(struct EmulatedSystem *emulated_system) {
+static void EMULATED_CORE_NAME(emulate_misc)(struct EmulatedSystem *emulated_system) {
     switch (emulated_system->decoded_instruction.value) {
         case 0x0A: {
             // 0xFX0A: Wait for a key press, store the value of the key in VX.
             bool any_key_pressed = false;
-            
-            for (uint8_t i = 0; i < sizeof(emulated_system->keypad); i++) {
-                if (emulated_system->keypad[i]) {
+            emulated_system->keypad_observed = 0xFFFF; // Every key is checked
+
+            for (uint8_t i = 0; i < 16; i++) {
+                if (emulated_system->keypad & (1u << i)) {
                     emulated_system->V[emulated_system->decoded_instruction.register_index] = i;
                     any_key_pressed = true;
                     break;
@@ -28,6 +29,7 @@ static void emulated_system_emulate_misc(struct EmulatedSystem *emulated_system)
 
         case 0x07:
             // 0xFX07: VX = delay timer
+            emulated_system->delay_timer_read_count++;
             emulated_system->V[emulated_system->decoded_instruction.register_index] = emulated_system->delay_timer;
             break;
 
@@ -47,12 +49,13 @@ static void emulated_system_emulate_misc(struct EmulatedSystem *emulated_system)
             break;
 
         case 0x33: {
+            // RAM is the last member, addresses wrap at 4 KB instead of reaching past the instance
             uint8_t bcd = emulated_system->V[emulated_system->decoded_instruction.register_index]; 
-            emulated_system->ram[emulated_system->I+2] = bcd % 10;
+            emulated_system->ram[(emulated_system->I+2) & 0xFFF] = bcd % 10;
             bcd /= 10;
-            emulated_system->ram[emulated_system->I+1] = bcd % 10;
+            emulated_system->ram[(emulated_system->I+1) & 0xFFF] = bcd % 10;
             bcd /= 10;
-            emulated_system->ram[emulated_system->I] = bcd;
+            emulated_system->ram[emulated_system->I & 0xFFF] = bcd;
             break;
         }
 
@@ -66,10 +69,10 @@ static void emulated_system_emulate_misc(struct EmulatedSystem *emulated_system)
         case 0x65:
             // 0xFX65: Register load V0-VX inclusive from memory offset from I;
             for (uint8_t i = 0; i <= emulated_system->decoded_instruction.register_index; i++) {
-                if (emulated_system->extension == CHIP8) 
-                    emulated_system->V[i] = emulated_system->ram[emulated_system->I++]; // Incremento de reg I
+                if (EMULATED_CORE_QUIRK_LOAD_INCREMENTS_I)
+                    emulated_system->V[i] = emulated_system->ram[emulated_system->I++ & 0xFFF]; // Incremento de reg I
                 else
-                    emulated_system->V[i] = emulated_system->ram[emulated_system->I + i];
+                    emulated_system->V[i] = emulated_system->ram[(emulated_system->I + i) & 0xFFF];
             }
             break;
 
@@ -4,6 +4,7 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <sys/stat.h>
 
 bool emulated_state_save(struct EmulatedSystem *emulated_system, const char *filename) {
     FILE *file = fopen(filename, "wb");
@@ -25,6 +26,14 @@ bool emulated_state_load(struct EmulatedSystem *emulated_system, const char *fil
       fprintf(stderr, "Não foi possível encontrar o save %s\n", filename);
       return false;
     }
+
+    // A save from a build with another layout of the system would be read into the wrong fields
+    struct stat file_status;
+    if (fstat(fileno(file), &file_status) != 0 || file_status.st_size != sizeof(struct EmulatedSystem)) {
+        fprintf(stderr, "O save %s não é desta versão do emulador\n", filename);
+        fclose(file);
+        return false;
+    }
     else if (fread(emulated_system, sizeof(struct EmulatedSystem), 1, file) != 1) {
         fprintf(stderr, "Não foi possível ler o save %s\n", filename);
         fclose(file);
@@ -1,82 +1,285 @@
 // Emulator
 
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
 #include "emulator.h"
 
+static uint64_t emulator_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+bool emulator_load_rom_from_memory(struct Emulator *emulator, const char *rom_name, const uint8_t *rom, size_t rom_size) {
+    const size_t max_size = sizeof emulator->emulated_system.ram - emulated_system_entry_point;
+
+    if (rom_size == 0 || rom_size > max_size) {
+        fprintf(stderr, "Rom %s has an invalid size! Rom size: %llu, Max size allowed: %llu\n",
+                rom_name, (long long unsigned)rom_size, (long long unsigned)max_size);
+        return false;
+    }
+
+    // Nothing of a rom that ran before is kept, its bytes included
+    emulated_system_initialize(&emulator->emulated_system);
+    emulator->scheduler = (struct Scheduler){0};
+    emulator->vip_timing = (struct VipTiming){0};
+
+    memcpy(&emulator->emulated_system.ram[emulated_system_entry_point], rom, rom_size);
+    emulator->rom_name = rom_name;
+
+    if (!rom_profile_get(&emulator->rom_profile, &emulator->emulated_system.ram[emulated_system_entry_point], rom_size, emulated_system_entry_point)) {
+        fprintf(stderr, "Could not analyse rom %s\n", rom_name);
+        return false;
+    }
+    emulator->emulated_system.extension = emulator->rom_profile.extension;
+    if (emulator->rom_profile.instructions_per_frame)
+        emulator->emulated_system.instructions_per_frame = emulator->rom_profile.instructions_per_frame;
+
+    // Tuned again for this rom, within its own limits
+    if (emulator->autotune.is_enabled) autotune_begin(&emulator->autotune, &emulator->rom_profile, &emulator->emulated_system);
+    return true;
+}
+
 bool emulator_load_rom(struct Emulator *emulator, const char* rom_name) {
     // Open ROM file
-    FILE *rom = fopen(rom_name, "rb");
-    if (!rom) {
+    const int rom = open(rom_name, O_RDONLY);
+    struct stat rom_status;
+
+    if (rom < 0 || fstat(rom, &rom_status) != 0) {
         fprintf(stderr, "Rom file %s is invalid or does not exist\n", rom_name);
+        if (rom >= 0) close(rom);
+        return false;
+    }
+    else if (rom_status.st_size == 0) {
+        fprintf(stderr, "Rom file %s is empty\n", rom_name);
+        close(rom);
         return false;
     }
 
-    // Get/check rom size
-    fseek(rom, 0, SEEK_END);
-    const size_t rom_size = ftell(rom);
-    const size_t max_size = sizeof emulator->emulated_system.ram - emulated_system_entry_point;
-    rewind(rom);
+    // Mapped, so the only copy is the one into ram
+    const uint8_t *rom_data = mmap(NULL, rom_status.st_size, PROT_READ, MAP_PRIVATE, rom, 0);
+    close(rom);
 
-    if (rom_size > max_size) {
-        fprintf(stderr, "Rom file %s is too big! Rom size: %llu, Max size allowed: %llu\n", 
-                rom_name, (long long unsigned)rom_size, (long long unsigned)max_size);
-        fclose(rom);
+    if (rom_data == MAP_FAILED) {
+        fprintf(stderr, "Could not read Rom file %s into CHIP8 memory\n", rom_name);
         return false;
     }
-    // Load ROM
-    else if (fread(&emulator->emulated_system.ram[emulated_system_entry_point], rom_size, 1, rom) != 1) {
-        fprintf(stderr, "Could not read Rom file %s into CHIP8 memory\n", 
-                rom_name);
-        fclose(rom);
+
+    const bool is_loaded = emulator_load_rom_from_memory(emulator, rom_name, rom_data, rom_status.st_size);
+    munmap((void *)rom_data, rom_status.st_size);
+    return is_loaded;
+}
+
+bool emulator_load_rom_from_library(struct Emulator *emulator, const char *key) {
+    const uint8_t *rom;
+    size_t rom_size;
+
+    if (!rom_library_find(&emulator->rom_library, key, &rom, &rom_size)) {
+        fprintf(stderr, "Rom %s is not in the library\n", key);
         return false;
     }
-    else {
-        emulator->rom_name = rom_name;
-        fclose(rom);
-        return true;
-    }
-    return false;
+
+    return emulator_load_rom_from_memory(emulator, key, rom, rom_size);
+}
+
+// Reads the rom named by emulator->rom_name, from the library when it is open
+static bool emulator_load_named_rom(struct Emulator *emulator) {
+    const bool is_loaded = emulator->rom_library.data
+        ? emulator_load_rom_from_library(emulator, emulator->rom_name)
+        : emulator_load_rom(emulator, emulator->rom_name);
+
+    startup_trace_mark(&emulator->startup_trace, "rom loaded and profiled");
+    return is_loaded;
 }
 
-// Cleans emulator, loads font, sets default state
+static void *emulator_load_named_rom_thread(void *argument) {
+    struct Emulator *emulator = argument;
+    return emulator_load_named_rom(emulator) ? emulator : NULL;
+}
+
+// Loads the rom, which also sets the default state.
+// The rom is read and profiled while the window opens, they touch separate parts of the emulator.
 bool emulator_initialize(struct Emulator *emulator) {
-    emulated_system_initialize(&emulator->emulated_system);
+    if (emulator->is_headless) {
+        emulator_user_interface_configure_defaults(&emulator->user_interface);
+        return emulator_load_named_rom(emulator);
+    }
 
-    emulator_user_interface_initialize(&emulator->user_interface);
-    emulator_user_interface_clear_screen(&emulator->user_interface);
+    pthread_t loader;
+    const bool is_loading = pthread_create(&loader, NULL, emulator_load_named_rom_thread, emulator) == 0;
 
-    return true;
+    const bool is_user_interface_ready = emulator_user_interface_initialize(&emulator->user_interface);
+    if (is_user_interface_ready) {
+        emulator_user_interface_clear_screen(&emulator->user_interface);
+        startup_trace_mark(&emulator->startup_trace, "window and renderer");
+    }
+
+    void *loaded = NULL;
+    if (is_loading) pthread_join(loader, &loaded);
+    else loaded = emulator_load_named_rom(emulator) ? emulator : NULL;
+
+    return is_user_interface_ready && loaded;
+}
+
+// Runs up to count instructions through whichever loop is active, returns how many ran
+static unsigned int emulator_run_instructions(struct Emulator *emulator, EmulatedSystemCore emulate_decoded_instruction, unsigned int count) {
+    if (emulator->debugger.is_active) {
+        // Separate loop, so breakpoints cost nothing until one is set
+        return debugger_run(&emulator->debugger, &emulator->emulated_system, emulate_decoded_instruction, count);
+    }
+    else if (emulator->trace.is_open) {
+        return trace_run(&emulator->trace, &emulator->emulated_system, emulate_decoded_instruction, count);
+    }
+    else if (emulator->autotune.is_enabled && !emulator->autotune.is_settled) {
+        unsigned int executed = 0;
+        for (; executed < count && emulator->emulated_system.state == RUNNING; executed++) {
+            if (!emulated_system_consume_instruction(&emulator->emulated_system)) break;
+            emulate_decoded_instruction(&emulator->emulated_system);
+        }
+        return executed;
+    }
+
+    // Predecoded once per address, common sequences in a single dispatch
+    return predecode_run(&emulator->predecode, &emulator->emulated_system, emulate_decoded_instruction, count);
+}
+
+// Runs instructions and due events until the next vblank, or until execution stops
+static void emulator_run_frame(struct Emulator *emulator, EmulatedSystemCore emulate_decoded_instruction) {
+    struct Scheduler *scheduler = &emulator->scheduler;
+    struct EmulatedSystem *emulated_system = &emulator->emulated_system;
+    const uint64_t start = emulator_now_ns();
+
+    // Periods are taken when each event is posted again, so a new instructions_per_frame applies from the next one
+    if (scheduler->event_count == 0) {
+        scheduler_post(scheduler, scheduler->now + emulated_system->instructions_per_frame, SCHEDULER_TIMER_TICK);
+        scheduler_post(scheduler, scheduler->now + emulated_system->instructions_per_frame, SCHEDULER_VBLANK);
+    }
+
+    for (;;) {
+        const uint64_t until_next = scheduler_until_next(scheduler);
+        if (until_next > 0) {
+            const unsigned int count = (until_next > UINT16_MAX) ? UINT16_MAX : (unsigned int)until_next;
+            const unsigned int executed = emulator_run_instructions(emulator, emulate_decoded_instruction, count);
+            scheduler_advance(scheduler, executed);
+
+            // Stopped by the debugger or the rom, guest time stands still until it resumes
+            if (executed < count || emulated_system->state != RUNNING) return;
+            continue;
+        }
+
+        struct SchedulerEvent event;
+        while (scheduler_take_due(scheduler, &event)) {
+            switch (event.type) {
+                case SCHEDULER_TIMER_TICK: {
+                    // The tone covers the tick that takes the sound timer to 0
+                    const bool is_sounding = emulated_system->sound_timer > 0;
+
+                    if (emulated_system->delay_timer > 0) emulated_system->delay_timer--;
+                    if (emulated_system->sound_timer > 0) emulated_system->sound_timer--;
+
+                    if (is_sounding != emulator->user_interface.should_play_sound) scheduler_post(scheduler, event.time, SCHEDULER_AUDIO);
+                    scheduler_post(scheduler, event.time + emulated_system->instructions_per_frame, SCHEDULER_TIMER_TICK);
+                    break;
+                }
+                case SCHEDULER_AUDIO:
+                    emulator->user_interface.should_play_sound = !emulator->user_interface.should_play_sound;
+                    break;
+                case SCHEDULER_VBLANK:
+                    scheduler_post(scheduler, event.time + emulated_system->instructions_per_frame, SCHEDULER_VBLANK);
+
+                    if (emulator->autotune.is_enabled && !emulator->autotune.is_settled
+                        && autotune_frame(&emulator->autotune, emulated_system, emulator_now_ns() - start, 1e9 / emulated_system->frames_per_second)) {
+                        emulator->rom_profile.instructions_per_frame = emulated_system->instructions_per_frame;
+                        rom_profile_save(&emulator->rom_profile);
+                    }
+                    return;
+            }
+        }
+    }
 }
 
 void emulator_update(struct Emulator *emulator) {
+    // Also while paused, so an edit can be made before stepping into it
+    if (emulator->live_patch.is_watching) live_patch_poll(&emulator->live_patch, &emulator->emulated_system);
+
     if (emulator->emulated_system.state != PAUSE) {
         const float frame_duration = 1000.0f / emulator->emulated_system.frames_per_second;
-        unsigned int remaining_instructions = emulator->emulated_system.instructions_per_frame;
 
-        emulator->user_interface.expected_moment_to_draw = SDL_GetTicks64() + frame_duration;
+        // Picked once per frame, a loaded state may have switched extensions
+        const EmulatedSystemCore emulate_decoded_instruction = emulated_system_core(&emulator->emulated_system);
 
-        // Instruction cycle (many of these occur each second)
-        while (remaining_instructions > 0) {
-            remaining_instructions--;
-            emulated_system_consume_instruction(&emulator->emulated_system);// Determine type of instruction and layout based on first 4 bits.
-            emulated_system_emulate_decoded_instruction(&emulator->emulated_system);
-        }
+        // Host pacing only, guest time is counted in instructions by the scheduler. The first frame is shown right away.
+        if (!emulator->is_headless && emulator->frame_count > 0)
+            emulator->user_interface.expected_moment_to_draw = SDL_GetTicks64() + frame_duration;
 
-        // Update timers
-        if (emulator->emulated_system.delay_timer > 0) emulator->emulated_system.delay_timer--;
-
-        if (emulator->emulated_system.sound_timer > 0) {
-            emulator->emulated_system.sound_timer--;
-            emulator->user_interface.should_play_sound = true;
+        // Instruction cycle (many of these occur each second)
+        if (emulator->timing == EMULATOR_TIMING_VIP) {
+            // Separate loop, so the default timing never looks at cycles. Timers are run by its display interrupt.
+            vip_timing_run_frame(&emulator->vip_timing, &emulator->emulated_system, emulate_decoded_instruction);
+            emulator->user_interface.should_play_sound = emulator->emulated_system.sound_timer > 0;
         }
         else {
-            emulator->user_interface.should_play_sound = false;
+            emulator_run_frame(emulator, emulate_decoded_instruction);
         }
     }
 
+    if (emulator->video_stream.output && emulator->emulated_system.state != PAUSE)
+        video_stream_push_frame(&emulator->video_stream, &emulator->emulated_system);
+
+    emulator->frame_count++;
+    if (emulator->frame_share.segment && emulator->emulated_system.state != PAUSE)
+        frame_share_publish(&emulator->frame_share, &emulator->emulated_system, emulator->frame_count);
+
+    if (emulator->frame_limit && emulator->frame_count >= emulator->frame_limit)
+        emulator->emulated_system.state = QUIT;
+
+    // Nothing could resume a headless run stopped by the debugger
+    if (emulator->is_headless && emulator->emulated_system.state == PAUSE)
+        emulator->emulated_system.state = QUIT;
+
     // Update user interface
-    emulator_user_interface_update(&emulator->user_interface, &emulator->emulated_system);
+    if (!emulator->is_headless)
+        emulator_user_interface_update(&emulator->user_interface, &emulator->emulated_system);
+
+    // '=' starts the rom over, at the speed it was running
+    if (emulator->user_interface.should_reset) {
+        emulator->user_interface.should_reset = false;
+
+        const unsigned int instructions_per_frame = emulator->emulated_system.instructions_per_frame;
+        if (emulator_load_named_rom(emulator)) {
+            if (!emulator->autotune.is_enabled) emulator->emulated_system.instructions_per_frame = instructions_per_frame;
+
+            // The rom file replaced every patch, the source is applied over it again
+            if (emulator->live_patch.is_watching && !live_patch_sync(&emulator->live_patch, &emulator->emulated_system))
+                fprintf(stderr, "%s: not patched, the rom file runs as it is\n", emulator->live_patch.source_name);
+        }
+    }
+
+    if (emulator->frame_count == 1 && emulator->startup_trace.is_enabled) {
+        startup_trace_mark(&emulator->startup_trace, emulator->is_headless ? "first frame emulated" : "first frame presented");
+        startup_trace_report(&emulator->startup_trace, stderr, emulator->rom_name);
+    }
 }
 
 void emulator_destroy(struct Emulator *emulator) {
-    emulator_user_interface_destroy(&emulator->user_interface);
+    video_stream_close(&emulator->video_stream);
+    frame_share_close(&emulator->frame_share);
+    live_patch_close(&emulator->live_patch);
+    trace_close(&emulator->trace);
+    rom_library_close(&emulator->rom_library);
+
+    if (emulator->print_fusion_statistics)
+        predecode_report(&emulator->predecode, stderr, emulator->rom_name, emulator->frame_count);
+
+    if (emulator->user_interface.input_latency.is_enabled)
+        input_latency_report(&emulator->user_interface.input_latency, stderr, emulator->rom_name, emulator->rom_profile.hash,
+                             emulator->emulated_system.instructions_per_frame, emulator->emulated_system.frames_per_second);
+
+    if (!emulator->is_headless)
+        emulator_user_interface_destroy(&emulator->user_interface);
 }
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "instance_arena.h"
+
+#define INSTANCE_ARENA_HUGEPAGE_SIZE (2u << 20)
+
+bool instance_arena_create(struct InstanceArena *arena, size_t capacity, int flags) {
+    *arena = (struct InstanceArena){ .capacity = capacity };
+
+    const size_t page_size = (flags & INSTANCE_ARENA_HUGEPAGES) ? INSTANCE_ARENA_HUGEPAGE_SIZE : 4096;
+    arena->mapping_size = (capacity * sizeof(struct EmulatedSystem) + page_size - 1) / page_size * page_size;
+
+    void *mapping = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (flags & INSTANCE_ARENA_HUGEPAGES) {
+        mapping = mmap(NULL, arena->mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        arena->has_hugepages = mapping != MAP_FAILED;
+    }
+#endif
+    if (mapping == MAP_FAILED) {
+        mapping = mmap(NULL, arena->mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    if (mapping == MAP_FAILED) {
+        perror("Instance arena");
+        return false;
+    }
+
+#ifdef MADV_HUGEPAGE
+    // No hugepages reserved, ask for transparent ones instead
+    if ((flags & INSTANCE_ARENA_HUGEPAGES) && !arena->has_hugepages) madvise(mapping, arena->mapping_size, MADV_HUGEPAGE);
+#endif
+
+    arena->instances = mapping;
+    return instance_arena_set_rom(arena, NULL, 0);
+}
+
+void instance_arena_destroy(struct InstanceArena *arena) {
+    if (arena->instances) munmap(arena->instances, arena->mapping_size);
+    if (arena->image) munmap((void *)arena->image, sizeof ((struct EmulatedSystem *)0)->ram);
+    *arena = (struct InstanceArena){0};
+}
+
+bool instance_arena_set_rom(struct InstanceArena *arena, const uint8_t *rom, size_t rom_size) {
+    const size_t ram_size = sizeof ((struct EmulatedSystem *)0)->ram;
+    if (rom_size > ram_size - emulated_system_entry_point) {
+        fprintf(stderr, "Rom of %zu bytes does not fit in memory\n", rom_size);
+        return false;
+    }
+
+    uint8_t *image = mmap(NULL, ram_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (image == MAP_FAILED) {
+        perror("Instance arena");
+        return false;
+    }
+
+    // Same RAM emulated_system_initialize leaves, plus the rom
+    struct EmulatedSystem initial;
+    emulated_system_initialize(&initial);
+    memcpy(image, initial.ram, ram_size);
+    if (rom_size) memcpy(&image[emulated_system_entry_point], rom, rom_size);
+    mprotect(image, ram_size, PROT_READ);
+
+    if (arena->image) munmap((void *)arena->image, ram_size);
+    arena->image = image;
+    return true;
+}
+
+void instance_arena_reset(const struct InstanceArena *arena, struct EmulatedSystem *emulated_system) {
+    emulated_system_initialize(emulated_system);
+    memcpy(emulated_system->ram, arena->image, sizeof emulated_system->ram);
+}
+
+struct EmulatedSystem *instance_arena_allocate(struct InstanceArena *arena) {
+    struct EmulatedSystem *emulated_system = arena->free_list;
+
+    if (emulated_system) memcpy(&arena->free_list, emulated_system->ram, sizeof arena->free_list);
+    else if (arena->used < arena->capacity) emulated_system = &arena->instances[arena->used++];
+    else return NULL;
+
+    instance_arena_reset(arena, emulated_system);
+    return emulated_system;
+}
+
+void instance_arena_free(struct InstanceArena *arena, struct EmulatedSystem *emulated_system) {
+    emulated_system->state = QUIT;
+    memcpy(emulated_system->ram, &arena->free_list, sizeof arena->free_list);
+    arena->free_list = emulated_system;
+}
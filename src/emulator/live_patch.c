@@ -0,0 +1,113 @@
+// Live patching, inotify on the source's directory and a byte diff against the last program written
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+#include "live_patch.h"
+#include "assembler.h"
+
+// Writes the bytes of program that differ from the last one into RAM
+static void live_patch_apply(struct LivePatch *live_patch, struct EmulatedSystem *emulated_system, const uint8_t *program, size_t program_size) {
+    const size_t size = (program_size > live_patch->program_size) ? program_size : live_patch->program_size;
+    size_t changed = 0, first = 0, last = 0;
+
+    for (size_t i = 0; i < size; i++) {
+        // Bytes past the end of a program that shrank are cleared
+        const uint8_t byte = (i < program_size) ? program[i] : 0;
+        if (byte == live_patch->program[i]) continue;
+
+        // Predecoded entries check their words against RAM before every dispatch, nothing else caches code
+        emulated_system->ram[emulated_system_entry_point + i] = byte;
+        live_patch->program[i] = byte;
+
+        if (changed++ == 0) first = i;
+        last = i;
+    }
+    live_patch->program_size = program_size;
+
+    if (changed) {
+        fprintf(stderr, "%s: patched %zu bytes in 0x%03zx-0x%03zx\n", live_patch->source_name, changed,
+                emulated_system_entry_point + first, emulated_system_entry_point + last);
+    }
+}
+
+bool live_patch_open(struct LivePatch *live_patch, const char *source_name, struct EmulatedSystem *emulated_system) {
+    *live_patch = (struct LivePatch){ .source_name = source_name };
+
+    const char *slash = strrchr(source_name, '/');
+    live_patch->base_name = slash ? slash + 1 : source_name;
+
+    char directory[4096];
+    if (slash) snprintf(directory, sizeof directory, "%.*s", (int)(slash - source_name + (slash == source_name)), source_name);
+    else strcpy(directory, ".");
+
+    live_patch->inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (live_patch->inotify < 0 || inotify_add_watch(live_patch->inotify, directory, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        fprintf(stderr, "Could not watch %s for changes\n", source_name);
+        if (live_patch->inotify >= 0) close(live_patch->inotify);
+        return false;
+    }
+
+    if (!live_patch_sync(live_patch, emulated_system)) {
+        close(live_patch->inotify);
+        return false;
+    }
+
+    live_patch->is_watching = true;
+    return true;
+}
+
+bool live_patch_sync(struct LivePatch *live_patch, struct EmulatedSystem *emulated_system) {
+    // RAM stands in for the last program, so the next save is compared against what is really there even if this fails
+    memcpy(live_patch->program, &emulated_system->ram[emulated_system_entry_point], sizeof live_patch->program);
+    live_patch->program_size = 0;
+
+    static uint8_t program[LIVE_PATCH_PROGRAM_SIZE];
+    size_t program_size;
+    if (!assembler_assemble_file(live_patch->source_name, emulated_system_entry_point, program, sizeof program, &program_size)) return false;
+
+    live_patch_apply(live_patch, emulated_system, program, program_size);
+    return true;
+}
+
+void live_patch_poll(struct LivePatch *live_patch, struct EmulatedSystem *emulated_system) {
+    _Alignas(struct inotify_event) char events[4096];
+    bool is_saved = false;
+
+    for (ssize_t length; (length = read(live_patch->inotify, events, sizeof events)) > 0; ) {
+        for (ssize_t offset = 0; offset < length; ) {
+            const struct inotify_event *event = (const struct inotify_event *)&events[offset];
+            if (event->len && strcmp(event->name, live_patch->base_name) == 0) is_saved = true;
+            offset += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    if (!is_saved) return;
+
+    static uint8_t program[LIVE_PATCH_PROGRAM_SIZE];
+    size_t program_size;
+    if (!assembler_assemble_file(live_patch->source_name, emulated_system_entry_point, program, sizeof program, &program_size)) {
+        fprintf(stderr, "%s: not patched, the running program is kept\n", live_patch->source_name);
+        return;
+    }
+
+    live_patch_apply(live_patch, emulated_system, program, program_size);
+
+    // From the write that triggered it, the frame being presented next already runs the new code
+    struct stat source_status;
+    struct timespec now;
+    if (stat(live_patch->source_name, &source_status) == 0 && clock_gettime(CLOCK_REALTIME, &now) == 0) {
+        const double latency = (now.tv_sec - source_status.st_mtim.tv_sec) * 1e3 + (now.tv_nsec - source_status.st_mtim.tv_nsec) / 1e6;
+        fprintf(stderr, "%s: reassembled %.1f ms after the save\n", live_patch->source_name, latency);
+    }
+}
+
+void live_patch_close(struct LivePatch *live_patch) {
+    if (!live_patch->is_watching) return;
+
+    close(live_patch->inotify);
+    live_patch->is_watching = false;
+}
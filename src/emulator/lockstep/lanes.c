@@ -0,0 +1,226 @@
+// Lane-wise interpreter, included by lockstep.c once per vector implementation.
+//
+// Expects defined before inclusion:
+//   LOCKSTEP_NAME(name): prefix of the implementation, its vector type and primitives
+//     (LOCKSTEP_NAME(vector), LOCKSTEP_NAME(load), ...) are named with it
+//   LOCKSTEP_TARGET: attributes for every function in here, such as the instruction set
+// Instructions touching memory, the display or the stack go through lockstep_step_lane.
+// Results match the scalar core lane by lane, except for CXKK, which draws from rand() in a different order.
+
+#define vector LOCKSTEP_NAME(vector)
+#define vector_load LOCKSTEP_NAME(load)
+#define vector_store LOCKSTEP_NAME(store)
+#define vector_set1 LOCKSTEP_NAME(set1)
+#define vector_add LOCKSTEP_NAME(add)
+#define vector_sub LOCKSTEP_NAME(sub)
+#define vector_and LOCKSTEP_NAME(and)
+#define vector_or LOCKSTEP_NAME(or)
+#define vector_xor LOCKSTEP_NAME(xor)
+#define vector_shift_left LOCKSTEP_NAME(shift_left)
+#define vector_shift_right LOCKSTEP_NAME(shift_right)
+#define vector_equal LOCKSTEP_NAME(equal)
+#define vector_select LOCKSTEP_NAME(select)
+#define vector_decrement LOCKSTEP_NAME(decrement)
+#define vector_from_bits LOCKSTEP_NAME(from_bits)
+#define vector_to_bits LOCKSTEP_NAME(to_bits)
+
+// lanes[i] = value[i] where mask[i] is set
+static inline LOCKSTEP_TARGET void LOCKSTEP_NAME(write)(uint16_t *lanes, vector mask, vector value) {
+    vector_store(lanes, vector_select(mask, value, vector_load(lanes)));
+}
+
+static LOCKSTEP_TARGET void LOCKSTEP_NAME(execute)(struct Lockstep *lockstep, struct LockstepGroup *group, uint16_t lanes, uint16_t encoded_instruction) {
+    const struct DecodedInstruction decoded_instruction = decoded_instruction_from_encoded_instruction(encoded_instruction);
+    const vector mask = vector_from_bits(lanes);
+    const vector one = vector_set1(1);
+    const vector byte = vector_set1(0xFF);
+
+    // Taken from the nibbles rather than the decoded operands, which alias the address and value for other layouts.
+    // Instructions that name no register still load two vectors, which they leave unused.
+    const uint8_t x = (encoded_instruction >> 8) & 0xF;
+    const uint8_t y = (encoded_instruction >> 4) & 0xF;
+    const vector vx = vector_load(group->V[x]);
+    const vector vy = vector_load(group->V[y]);
+
+    vector_store(group->PC, vector_add(vector_load(group->PC), vector_and(mask, vector_set1(2))));
+
+    switch (decoded_instruction.type) {
+        case JUMP:
+            LOCKSTEP_NAME(write)(group->PC, mask, vector_set1(decoded_instruction.address));
+            return;
+        case IF_EQUAL_THEN_SKIP:
+        case IF_NOT_EQUAL_THEN_SKIP: {
+            const vector right = (decoded_instruction.operands_layout == REGISTER_AND_VALUE) ? vector_set1(decoded_instruction.value) : vy;
+            vector skip = vector_equal(vx, right);
+            if (decoded_instruction.type == IF_NOT_EQUAL_THEN_SKIP) skip = vector_xor(skip, vector_set1(0xFFFF));
+
+            vector_store(group->PC, vector_add(vector_load(group->PC), vector_and(vector_and(mask, skip), vector_set1(2))));
+            return;
+        }
+        case VALUE_TO_REGISTER:
+            LOCKSTEP_NAME(write)(group->V[x], mask, vector_set1(decoded_instruction.value));
+            return;
+        case SUM_REGISTER:
+            LOCKSTEP_NAME(write)(group->V[x], mask, vector_and(vector_add(vx, vector_set1(decoded_instruction.value)), byte));
+            return;
+        case REGISTER_TO_REGISTER:
+            LOCKSTEP_NAME(write)(group->V[x], mask, vy);
+            return;
+        case OR_REGISTERS:
+        case AND_REGISTERS:
+        case XOR_REGISTERS: {
+            const vector result = (decoded_instruction.type == OR_REGISTERS) ? vector_or(vx, vy)
+                                  : (decoded_instruction.type == AND_REGISTERS) ? vector_and(vx, vy)
+                                  : vector_xor(vx, vy);
+            LOCKSTEP_NAME(write)(group->V[x], mask, result);
+            if (lockstep->quirk_vf_reset) LOCKSTEP_NAME(write)(group->V[0xF], mask, vector_set1(0));
+            return;
+        }
+        // VF is written in the scalar core's order, which decides what X = F ends up holding
+        case SUM_REGISTERS: {
+            const vector sum = vector_add(vx, vy);
+            LOCKSTEP_NAME(write)(group->V[x], mask, vector_and(sum, byte));
+            LOCKSTEP_NAME(write)(group->V[0xF], mask, vector_shift_right(sum, 8));
+            return;
+        }
+        case SUBTRACT_REGISTERS:
+        case INVERT_SUBTRACT_REGISTERS: {
+            // A borrow leaves bit 8 set in the 16-bit difference
+            const vector difference = (decoded_instruction.type == SUBTRACT_REGISTERS) ? vector_sub(vx, vy) : vector_sub(vy, vx);
+            LOCKSTEP_NAME(write)(group->V[x], mask, vector_and(difference, byte));
+            LOCKSTEP_NAME(write)(group->V[0xF], mask, vector_xor(vector_and(vector_shift_right(difference, 8), one), one));
+            return;
+        }
+        case SHIFT_RIGHT_REGISTER: {
+            const vector source = lockstep->quirk_shift_vy ? vy : vx;
+            LOCKSTEP_NAME(write)(group->V[0xF], mask, vector_and(source, one));
+            LOCKSTEP_NAME(write)(group->V[x], mask, vector_shift_right(source, 1));
+            return;
+        }
+        case SHIFT_LEFT_REGISTER: {
+            const vector source = lockstep->quirk_shift_vy ? vy : vx;
+            LOCKSTEP_NAME(write)(group->V[0xF], mask, vector_shift_right(source, 7));
+            LOCKSTEP_NAME(write)(group->V[x], mask, vector_and(vector_shift_left(source, 1), byte));
+            return;
+        }
+        case ADDRESS_TO_REGISTER_I:
+            LOCKSTEP_NAME(write)(group->I, mask, vector_set1(decoded_instruction.address));
+            return;
+        case JUMP_WITH_OFFSET:
+            LOCKSTEP_NAME(write)(group->PC, mask, vector_add(vector_load(group->V[0]), vector_set1(decoded_instruction.address)));
+            return;
+        case MISC:
+            switch (decoded_instruction.value) {
+                case 0x07:
+                    LOCKSTEP_NAME(write)(group->V[x], mask, vector_load(group->delay_timer));
+                    for (unsigned int lane = 0; lane < LOCKSTEP_LANES; lane++) {
+                        if (lanes & (1u << lane)) group->systems[lane]->delay_timer_read_count++;
+                    }
+                    return;
+                case 0x15:
+                    LOCKSTEP_NAME(write)(group->delay_timer, mask, vx);
+                    return;
+                case 0x18:
+                    LOCKSTEP_NAME(write)(group->sound_timer, mask, vx);
+                    return;
+                case 0x1E:
+                    LOCKSTEP_NAME(write)(group->I, mask, vector_add(vector_load(group->I), vx));
+                    return;
+                case 0x29:
+                    LOCKSTEP_NAME(write)(group->I, mask, vector_add(vector_shift_left(vx, 2), vx));
+                    return;
+                case 0x65:
+                    // Lane by lane, but without going through the scalar core. Reads past RAM are left to it.
+                    for (unsigned int lane = 0; lane < LOCKSTEP_LANES; lane++) {
+                        if (!(lanes & (1u << lane))) continue;
+                        if (group->I[lane] + x >= 4096) {
+                            lockstep_step_lane(lockstep, group, lane, encoded_instruction);
+                            continue;
+                        }
+
+                        const uint8_t *ram = &group->systems[lane]->ram[group->I[lane]];
+                        for (int i = 0; i <= x; i++) group->V[i][lane] = ram[i];
+                        if (lockstep->quirk_load_increments_i) group->I[lane] += x + 1;
+                    }
+                    return;
+                default:
+                    break;
+            }
+            break;
+        default:
+            break;
+    }
+
+    for (unsigned int lane = 0; lane < LOCKSTEP_LANES; lane++) {
+        if (lanes & (1u << lane)) lockstep_step_lane(lockstep, group, lane, encoded_instruction);
+    }
+}
+
+// One frame of every running lane: instructions per frame each, then a timer tick
+static LOCKSTEP_TARGET uint64_t LOCKSTEP_NAME(run_frame)(struct Lockstep *lockstep, struct LockstepGroup *group) {
+    const vector one = vector_set1(1);
+    const vector zero = vector_set1(0);
+    vector remaining = vector_set1((uint16_t)lockstep->instructions_per_frame);
+    const uint16_t started = group->running;
+    uint16_t pending = started;
+    uint64_t executed = 0;
+
+    while (pending) {
+        const vector pc = vector_load(group->PC);
+        unsigned int leader = __builtin_ctz(pending);
+        uint16_t lanes = vector_to_bits(vector_equal(pc, vector_set1(group->PC[leader]))) & pending;
+
+        if (lanes != pending) {
+            // Diverged: the lowest PC goes first, so lanes that skipped ahead wait for the others to catch up
+            for (unsigned int lane = leader + 1; lane < LOCKSTEP_LANES; lane++) {
+                if ((pending & (1u << lane)) && group->PC[lane] < group->PC[leader]) leader = lane;
+            }
+            lanes = vector_to_bits(vector_equal(pc, vector_set1(group->PC[leader]))) & pending;
+        }
+
+        const uint16_t address = group->PC[leader];
+        if (address >= 4095) {
+            lockstep_stop_lanes(group, lanes);
+            pending &= group->running;
+            continue;
+        }
+
+        const uint8_t *ram = group->systems[leader]->ram;
+        const uint16_t encoded_instruction = (uint16_t)((ram[address] << 8) | ram[address + 1]);
+        if (lockstep_may_differ(group, address)) lanes = lockstep_lanes_with_instruction(group, lanes, address, encoded_instruction);
+
+        LOCKSTEP_NAME(execute)(lockstep, group, lanes, encoded_instruction);
+
+        const int lane_count = __builtin_popcount(lanes);
+        executed += lane_count;
+        lockstep->steps++;
+        lockstep->lane_steps += lane_count;
+
+        remaining = vector_sub(remaining, vector_and(vector_from_bits(lanes), one));
+        pending = (uint16_t)~vector_to_bits(vector_equal(remaining, zero)) & group->running;
+    }
+
+    // Lanes stopping during the frame still tick, like a frame loop checking the state at its start
+    const vector running = vector_from_bits(started);
+    LOCKSTEP_NAME(write)(group->delay_timer, running, vector_decrement(vector_load(group->delay_timer)));
+    LOCKSTEP_NAME(write)(group->sound_timer, running, vector_decrement(vector_load(group->sound_timer)));
+
+    return executed;
+}
+
+#undef vector
+#undef vector_load
+#undef vector_store
+#undef vector_set1
+#undef vector_add
+#undef vector_sub
+#undef vector_and
+#undef vector_or
+#undef vector_xor
+#undef vector_shift_left
+#undef vector_shift_right
+#undef vector_equal
+#undef vector_select
+#undef vector_decrement
+#undef vector_from_bits
+#undef vector_to_bits
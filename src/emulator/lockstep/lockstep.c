@@ -0,0 +1,246 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "lockstep.h"
+
+static void lockstep_lane_store(struct LockstepGroup *group, unsigned int lane) {
+    struct EmulatedSystem *emulated_system = group->systems[lane];
+
+    for (int i = 0; i < 16; i++) emulated_system->V[i] = (uint8_t)group->V[i][lane];
+    emulated_system->I = group->I[lane];
+    emulated_system->PC = group->PC[lane];
+    emulated_system->delay_timer = (uint8_t)group->delay_timer[lane];
+    emulated_system->sound_timer = (uint8_t)group->sound_timer[lane];
+    emulated_system->keypad = group->keypad[lane];
+    emulated_system->keypad_observed = group->keypad_observed[lane];
+}
+
+static void lockstep_lane_load(struct LockstepGroup *group, unsigned int lane) {
+    const struct EmulatedSystem *emulated_system = group->systems[lane];
+
+    for (int i = 0; i < 16; i++) group->V[i][lane] = emulated_system->V[i];
+    group->I[lane] = emulated_system->I;
+    group->PC[lane] = emulated_system->PC;
+    group->delay_timer[lane] = emulated_system->delay_timer;
+    group->sound_timer[lane] = emulated_system->sound_timer;
+    group->keypad[lane] = emulated_system->keypad;
+    group->keypad_observed[lane] = emulated_system->keypad_observed;
+}
+
+static void lockstep_mark_written(struct LockstepGroup *group, uint32_t first, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t address = (first + i) & 0xFFF; // Stores wrap at 4 KB
+        group->written[address / 64] |= 1ull << (address % 64);
+    }
+}
+
+static bool lockstep_may_differ(const struct LockstepGroup *group, uint16_t address) {
+    return ((group->written[address / 64] >> (address % 64)) | (group->written[(address + 1) / 64] >> ((address + 1) % 64))) & 1;
+}
+
+// Lanes out of lanes whose RAM holds encoded_instruction at address
+static uint16_t lockstep_lanes_with_instruction(const struct LockstepGroup *group, uint16_t lanes, uint16_t address, uint16_t encoded_instruction) {
+    for (unsigned int lane = 0; lane < LOCKSTEP_LANES; lane++) {
+        if (!(lanes & (1u << lane))) continue;
+
+        const uint8_t *ram = group->systems[lane]->ram;
+        if (((ram[address] << 8) | ram[address + 1]) != encoded_instruction) lanes &= ~(1u << lane);
+    }
+    return lanes;
+}
+
+// Runs an instruction the lanes do not implement through the scalar core, PC already points past it
+static void lockstep_step_lane(struct Lockstep *lockstep, struct LockstepGroup *group, unsigned int lane, uint16_t encoded_instruction) {
+    struct EmulatedSystem *emulated_system = group->systems[lane];
+    lockstep_lane_store(group, lane);
+
+    emulated_system->encoded_instruction = encoded_instruction;
+    emulated_system->decoded_instruction = decoded_instruction_from_encoded_instruction(encoded_instruction);
+
+    // Stores may change the code of this lane only
+    if (emulated_system->decoded_instruction.type == MISC) {
+        if (emulated_system->decoded_instruction.value == 0x33) lockstep_mark_written(group, emulated_system->I, 3);
+        if (emulated_system->decoded_instruction.value == 0x55) lockstep_mark_written(group, emulated_system->I, emulated_system->decoded_instruction.register_index + 1);
+    }
+
+    lockstep->emulate_decoded_instruction(emulated_system);
+    lockstep_lane_load(group, lane);
+
+    if (emulated_system->state != RUNNING) group->running &= ~(1u << lane);
+}
+
+// Lanes out of lanes whose PC ran past the end of RAM, they stop like emulated_system_consume_instruction does
+static void lockstep_stop_lanes(struct LockstepGroup *group, uint16_t lanes) {
+    for (unsigned int lane = 0; lane < LOCKSTEP_LANES; lane++) {
+        if (!(lanes & (1u << lane))) continue;
+        fprintf(stderr, "PC fora do limite: %04X\n", group->PC[lane]);
+        group->systems[lane]->state = QUIT;
+    }
+    group->running &= ~lanes;
+}
+
+// Vector implementations of lanes.c
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define LOCKSTEP_HAVE_AVX2
+#include <immintrin.h>
+
+#define LOCKSTEP_NAME(name) lockstep_avx2_##name
+#define LOCKSTEP_TARGET __attribute__((target("avx2")))
+
+typedef __m256i lockstep_avx2_vector;
+
+static inline LOCKSTEP_TARGET __m256i lockstep_avx2_load(const uint16_t *lanes) { return _mm256_loadu_si256((const __m256i *)lanes); }
+static inline LOCKSTEP_TARGET void lockstep_avx2_store(uint16_t *lanes, __m256i value) { _mm256_storeu_si256((__m256i *)lanes, value); }
+static inline LOCKSTEP_TARGET __m256i lockstep_avx2_set1(uint16_t value) { return _mm256_set1_epi16((short)value); }
+static inline LOCKSTEP_TARGET __m256i lockstep_avx2_add(__m256i a, __m256i b) { return _mm256_add_epi16(a, b); }
+static inline LOCKSTEP_TARGET __m256i lockstep_avx2_sub(__m256i a, __m256i b) { return _mm256_sub_epi16(a, b); }
+static inline LOCKSTEP_TARGET __m256i lockstep_avx2_and(__m256i a, __m256i b) { return _mm256_and_si256(a, b); }
+static inline LOCKSTEP_TARGET __m256i lockstep_avx2_or(__m256i a, __m256i b) { return _mm256_or_si256(a, b); }
+static inline LOCKSTEP_TARGET __m256i lockstep_avx2_xor(__m256i a, __m256i b) { return _mm256_xor_si256(a, b); }
+static inline LOCKSTEP_TARGET __m256i lockstep_avx2_shift_left(__m256i a, int count) { return _mm256_sll_epi16(a, _mm_cvtsi32_si128(count)); }
+static inline LOCKSTEP_TARGET __m256i lockstep_avx2_shift_right(__m256i a, int count) { return _mm256_srl_epi16(a, _mm_cvtsi32_si128(count)); }
+static inline LOCKSTEP_TARGET __m256i lockstep_avx2_equal(__m256i a, __m256i b) { return _mm256_cmpeq_epi16(a, b); }
+static inline LOCKSTEP_TARGET __m256i lockstep_avx2_select(__m256i mask, __m256i a, __m256i b) { return _mm256_blendv_epi8(b, a, mask); }
+static inline LOCKSTEP_TARGET __m256i lockstep_avx2_decrement(__m256i a) { return _mm256_subs_epu16(a, _mm256_set1_epi16(1)); }
+
+static inline LOCKSTEP_TARGET __m256i lockstep_avx2_from_bits(uint16_t bits) {
+    const __m256i lane_bits = _mm256_setr_epi16(1 << 0, 1 << 1, 1 << 2, 1 << 3, 1 << 4, 1 << 5, 1 << 6, 1 << 7,
+                                                1 << 8, 1 << 9, 1 << 10, 1 << 11, 1 << 12, 1 << 13, 1 << 14, (short)(1 << 15));
+    return _mm256_cmpeq_epi16(_mm256_and_si256(_mm256_set1_epi16((short)bits), lane_bits), lane_bits);
+}
+
+static inline LOCKSTEP_TARGET uint16_t lockstep_avx2_to_bits(__m256i mask) {
+    // Packing works within 128-bit halves: lanes 0-7 land in bytes 0-7, lanes 8-15 in bytes 16-23
+    const uint32_t bytes = (uint32_t)_mm256_movemask_epi8(_mm256_packs_epi16(mask, _mm256_setzero_si256()));
+    return (uint16_t)((bytes & 0xFF) | ((bytes >> 8) & 0xFF00));
+}
+
+#include "lanes.c"
+#undef LOCKSTEP_NAME
+#undef LOCKSTEP_TARGET
+#endif
+
+// Plain loops, for other CPUs
+#define LOCKSTEP_NAME(name) lockstep_portable_##name
+#define LOCKSTEP_TARGET
+
+typedef struct { uint16_t lanes[LOCKSTEP_LANES]; } lockstep_portable_vector;
+
+#define LOCKSTEP_PORTABLE_MAP(expression) \
+    lockstep_portable_vector result; \
+    for (int lane = 0; lane < LOCKSTEP_LANES; lane++) result.lanes[lane] = (uint16_t)(expression); \
+    return result
+
+static inline lockstep_portable_vector lockstep_portable_load(const uint16_t *lanes) { LOCKSTEP_PORTABLE_MAP(lanes[lane]); }
+static inline void lockstep_portable_store(uint16_t *lanes, lockstep_portable_vector value) { memcpy(lanes, value.lanes, sizeof value.lanes); }
+static inline lockstep_portable_vector lockstep_portable_set1(uint16_t value) { LOCKSTEP_PORTABLE_MAP(value); }
+static inline lockstep_portable_vector lockstep_portable_add(lockstep_portable_vector a, lockstep_portable_vector b) { LOCKSTEP_PORTABLE_MAP(a.lanes[lane] + b.lanes[lane]); }
+static inline lockstep_portable_vector lockstep_portable_sub(lockstep_portable_vector a, lockstep_portable_vector b) { LOCKSTEP_PORTABLE_MAP(a.lanes[lane] - b.lanes[lane]); }
+static inline lockstep_portable_vector lockstep_portable_and(lockstep_portable_vector a, lockstep_portable_vector b) { LOCKSTEP_PORTABLE_MAP(a.lanes[lane] & b.lanes[lane]); }
+static inline lockstep_portable_vector lockstep_portable_or(lockstep_portable_vector a, lockstep_portable_vector b) { LOCKSTEP_PORTABLE_MAP(a.lanes[lane] | b.lanes[lane]); }
+static inline lockstep_portable_vector lockstep_portable_xor(lockstep_portable_vector a, lockstep_portable_vector b) { LOCKSTEP_PORTABLE_MAP(a.lanes[lane] ^ b.lanes[lane]); }
+static inline lockstep_portable_vector lockstep_portable_shift_left(lockstep_portable_vector a, int count) { LOCKSTEP_PORTABLE_MAP(a.lanes[lane] << count); }
+static inline lockstep_portable_vector lockstep_portable_shift_right(lockstep_portable_vector a, int count) { LOCKSTEP_PORTABLE_MAP(a.lanes[lane] >> count); }
+static inline lockstep_portable_vector lockstep_portable_equal(lockstep_portable_vector a, lockstep_portable_vector b) { LOCKSTEP_PORTABLE_MAP((a.lanes[lane] == b.lanes[lane]) ? 0xFFFF : 0); }
+static inline lockstep_portable_vector lockstep_portable_select(lockstep_portable_vector mask, lockstep_portable_vector a, lockstep_portable_vector b) { LOCKSTEP_PORTABLE_MAP((a.lanes[lane] & mask.lanes[lane]) | (b.lanes[lane] & ~mask.lanes[lane])); }
+static inline lockstep_portable_vector lockstep_portable_decrement(lockstep_portable_vector a) { LOCKSTEP_PORTABLE_MAP(a.lanes[lane] ? a.lanes[lane] - 1 : 0); }
+static inline lockstep_portable_vector lockstep_portable_from_bits(uint16_t bits) { LOCKSTEP_PORTABLE_MAP(((bits >> lane) & 1) ? 0xFFFF : 0); }
+
+static inline uint16_t lockstep_portable_to_bits(lockstep_portable_vector mask) {
+    uint16_t bits = 0;
+    for (int lane = 0; lane < LOCKSTEP_LANES; lane++) bits |= (uint16_t)((mask.lanes[lane] >> 15) << lane);
+    return bits;
+}
+
+#include "lanes.c"
+#undef LOCKSTEP_NAME
+#undef LOCKSTEP_TARGET
+#undef LOCKSTEP_PORTABLE_MAP
+
+bool lockstep_create(struct Lockstep *lockstep, struct EmulatedSystem *instances, size_t instance_count) {
+    if (instance_count == 0) return false;
+
+    for (size_t i = 1; i < instance_count; i++) {
+        if (instances[i].extension != instances[0].extension || instances[i].instructions_per_frame != instances[0].instructions_per_frame) {
+            fprintf(stderr, "Instances stepped together must share extension and instructions per frame\n");
+            return false;
+        }
+    }
+    if (instances[0].instructions_per_frame == 0 || instances[0].instructions_per_frame > UINT16_MAX) {
+        fprintf(stderr, "Invalid instructions per frame %u\n", instances[0].instructions_per_frame);
+        return false;
+    }
+
+    *lockstep = (struct Lockstep){
+        .group_count = (instance_count + LOCKSTEP_LANES - 1) / LOCKSTEP_LANES,
+        .instance_count = instance_count,
+        .instructions_per_frame = instances[0].instructions_per_frame,
+        .quirk_vf_reset = instances[0].extension == CHIP8,
+        .quirk_shift_vy = instances[0].extension == CHIP8,
+        .quirk_load_increments_i = instances[0].extension == CHIP8,
+        .emulate_decoded_instruction = emulated_system_core(&instances[0]),
+    };
+
+#ifdef LOCKSTEP_HAVE_AVX2
+    __builtin_cpu_init();
+    lockstep->use_avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+    lockstep->groups = calloc(lockstep->group_count, sizeof(struct LockstepGroup));
+    if (!lockstep->groups) {
+        fprintf(stderr, "Not enough memory for %zu instances\n", instance_count);
+        return false;
+    }
+
+    for (size_t i = 0; i < instance_count; i++) {
+        struct LockstepGroup *group = &lockstep->groups[i / LOCKSTEP_LANES];
+        const unsigned int lane = i % LOCKSTEP_LANES;
+
+        group->systems[lane] = &instances[i];
+        lockstep_lane_load(group, lane);
+        if (instances[i].state == RUNNING) group->running |= 1u << lane;
+
+        // Lanes start out sharing code only where their RAM agrees with the first lane's
+        for (uint32_t address = 0; lane > 0 && address < sizeof instances[i].ram; address++) {
+            if (instances[i].ram[address] != group->systems[0]->ram[address]) lockstep_mark_written(group, address, 1);
+        }
+    }
+
+    return true;
+}
+
+void lockstep_destroy(struct Lockstep *lockstep) {
+    free(lockstep->groups);
+    lockstep->groups = NULL;
+}
+
+void lockstep_set_keypad(struct Lockstep *lockstep, size_t instance, uint16_t keypad) {
+    lockstep->groups[instance / LOCKSTEP_LANES].keypad[instance % LOCKSTEP_LANES] = keypad;
+}
+
+uint64_t lockstep_run_frames(struct Lockstep *lockstep, uint64_t count) {
+    uint64_t executed = 0;
+
+    // Group by group, so its registers stay in cache for every frame
+    for (size_t i = 0; i < lockstep->group_count; i++) {
+        for (uint64_t frame = 0; frame < count && lockstep->groups[i].running; frame++) {
+#ifdef LOCKSTEP_HAVE_AVX2
+            if (lockstep->use_avx2) {
+                executed += lockstep_avx2_run_frame(lockstep, &lockstep->groups[i]);
+                continue;
+            }
+#endif
+            executed += lockstep_portable_run_frame(lockstep, &lockstep->groups[i]);
+        }
+    }
+
+    return executed;
+}
+
+void lockstep_sync(struct Lockstep *lockstep) {
+    for (size_t i = 0; i < lockstep->instance_count; i++) {
+        lockstep_lane_store(&lockstep->groups[i / LOCKSTEP_LANES], i % LOCKSTEP_LANES);
+    }
+}
@@ -3,35 +3,214 @@
 
 #include "emulator.h"
 
-bool consume_command_line_arguments(struct Emulator *emulator, int argc, char **argv) {
+static const char *const usage =
+    "Usage: %s <rom_name> [--scale-factor <factor>] [--headless] [--frames <count>]\n"
+    "          [--ipf <count>] [--auto-tune] [--ipf-limits <minimum>:<maximum>] [--timing fast|vip] [--keymap <16 keys for 0-F>] [--input-latency] [--fusion-stats] [--library <filename>] [--record <filename or - for stdout>] [--record-format y4m|rgba] [--share <name>] [--watch <source.asm>] [--trace <filename[.gz]>] [--startup-trace]\n"
+    "          [--break <address>[:<condition>]] [--watch-read <first>[-<last>]] [--watch-write <first>[-<last>]] [--watch-i]\n"
+    "  Addresses take a 0x prefix for hex, conditions look like \"V3 == 5 && I > 0x300\"\n"
+    "  With --library, rom_name is a file name or content hash in the library\n"
+    "  --auto-tune adjusts instructions per frame and stores the settled value for the next launch\n"
+    "  --timing vip charges each instruction its COSMAC VIP machine cycles, instead of a flat count per frame\n"
+    "  --keymap takes the keys for CHIP8 keys 0 to F in order, the default is x123qweasdzc4rfv\n"
+    "  --input-latency prints a histogram of key press to guest read times on exit\n"
+    "  --fusion-stats prints dispatches per frame and how much of the rom ran as fused instruction sequences on exit\n"
+    "  --share publishes every frame to the shared memory segment /<name>, see tracua-chip8-frame-reader\n"
+    "  --watch reassembles the source of the rom on every save and patches the bytes that changed into the running program\n"
+    "  --startup-trace prints how long each startup step took once the first frame is shown\n";
+
+struct CommandLineOptions {
+    const char *record_filename;
+    int record_format;
+    const char *trace_filename;
+    const char *share_name;
+    const char *watch_name;
+    const char *library_filename;
+    const char *keymap;
+    unsigned int instructions_per_frame; // 0 keeps the profile's or the default
+    bool auto_tune;
+    unsigned int instructions_per_frame_minimum; // Stored in the profile when set
+    unsigned int instructions_per_frame_maximum;
+    bool measure_input_latency;
+};
+
+bool consume_command_line_arguments(struct Emulator *emulator, struct CommandLineOptions *options, int argc, char **argv) {
     if (argc < 2) {
-        fprintf(stderr, "Usage: %s <rom_name>\n", argv[0]);
+        fprintf(stderr, usage, argv[0]);
         return false;
     }
 
-   for (int i = 1; i < argc; i++) {
-        if (strncmp(argv[i], "--scale-factor", strlen("--scale-factor")) == 0) {
+    emulator->rom_name = argv[1];
+
+   for (int i = 2; i < argc; i++) {
+        if (strncmp(argv[i], "--scale-factor", strlen("--scale-factor")) == 0 && i + 1 < argc) {
             i++;
             emulator->user_interface.scale_factor = (uint32_t)strtol(argv[i], NULL, 10);
         }
+        else if (strcmp(argv[i], "--headless") == 0) {
+            emulator->is_headless = true;
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            emulator->frame_limit = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--break") == 0 && i + 1 < argc) {
+            char *condition;
+            const uint16_t address = (uint16_t)strtoul(argv[++i], &condition, 0);
+            if (!debugger_add_breakpoint(&emulator->debugger, address, (*condition == ':') ? condition + 1 : NULL)) return false;
+        }
+        else if ((strcmp(argv[i], "--watch-read") == 0 || strcmp(argv[i], "--watch-write") == 0) && i + 1 < argc) {
+            const int access = (strcmp(argv[i], "--watch-read") == 0) ? WATCH_READ : WATCH_WRITE;
+            char *last;
+            const uint16_t first = (uint16_t)strtoul(argv[++i], &last, 0);
+            if (!debugger_add_watchpoint(&emulator->debugger, first, (*last == '-') ? (uint16_t)strtoul(last + 1, NULL, 0) : first, access)) return false;
+        }
+        else if (strcmp(argv[i], "--watch-i") == 0) {
+            debugger_watch_I(&emulator->debugger);
+        }
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            options->record_filename = argv[++i];
+        }
+        else if (strcmp(argv[i], "--ipf") == 0 && i + 1 < argc) {
+            options->instructions_per_frame = (unsigned int)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--auto-tune") == 0) {
+            options->auto_tune = true;
+        }
+        else if (strcmp(argv[i], "--ipf-limits") == 0 && i + 1 < argc) {
+            char *maximum;
+            options->instructions_per_frame_minimum = (unsigned int)strtoul(argv[++i], &maximum, 10);
+            options->instructions_per_frame_maximum = (*maximum == ':') ? (unsigned int)strtoul(maximum + 1, NULL, 10) : 0;
+
+            if (options->instructions_per_frame_minimum == 0
+                || options->instructions_per_frame_maximum < options->instructions_per_frame_minimum
+                || options->instructions_per_frame_maximum > UINT16_MAX) {
+                fprintf(stderr, "Invalid instructions per frame limits %s\n", argv[i]);
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--timing") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "fast") == 0) emulator->timing = EMULATOR_TIMING_FAST;
+            else if (strcmp(argv[i], "vip") == 0) emulator->timing = EMULATOR_TIMING_VIP;
+            else {
+                fprintf(stderr, "Unknown timing %s\n", argv[i]);
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--keymap") == 0 && i + 1 < argc) {
+            options->keymap = argv[++i];
+        }
+        else if (strcmp(argv[i], "--input-latency") == 0) {
+            options->measure_input_latency = true;
+        }
+        else if (strcmp(argv[i], "--fusion-stats") == 0) {
+            emulator->print_fusion_statistics = true;
+        }
+        else if (strcmp(argv[i], "--library") == 0 && i + 1 < argc) {
+            options->library_filename = argv[++i];
+        }
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            options->trace_filename = argv[++i];
+        }
+        else if (strcmp(argv[i], "--share") == 0 && i + 1 < argc) {
+            options->share_name = argv[++i];
+        }
+        else if (strcmp(argv[i], "--watch") == 0 && i + 1 < argc) {
+            options->watch_name = argv[++i];
+        }
+        else if (strcmp(argv[i], "--startup-trace") == 0) {
+            emulator->startup_trace.is_enabled = true;
+        }
+        else if (strcmp(argv[i], "--record-format") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "y4m") == 0) options->record_format = VIDEO_STREAM_Y4M;
+            else if (strcmp(argv[i], "rgba") == 0) options->record_format = VIDEO_STREAM_RGBA;
+            else {
+                fprintf(stderr, "Unknown record format %s\n", argv[i]);
+                return false;
+            }
+        }
+    }
+
+    // The VIP timing loop runs instructions itself, none of these would see them
+    if (emulator->timing == EMULATOR_TIMING_VIP) {
+        if (emulator->debugger.is_active) {
+            fprintf(stderr, "--break and --watch-* are not available with --timing vip\n");
+            return false;
+        }
+        else if (options->trace_filename) {
+            fprintf(stderr, "--trace is not available with --timing vip\n");
+            return false;
+        }
+        else if (options->auto_tune) {
+            fprintf(stderr, "--auto-tune is not available with --timing vip\n");
+            return false;
+        }
+        else if (emulator->print_fusion_statistics) {
+            fprintf(stderr, "--fusion-stats is not available with --timing vip\n");
+            return false;
+        }
     }
-    emulator_load_rom(emulator, argv[1]);
     return true;
 }
 
 int main(int argc, char **argv) {
-    struct Emulator emulator;
+    struct Emulator emulator = {0};
+    struct CommandLineOptions options = { .record_format = VIDEO_STREAM_Y4M };
+    startup_trace_begin(&emulator.startup_trace);
 
-    emulator_initialize(&emulator);
-
-    if (!consume_command_line_arguments(&emulator, argc, argv)) return EXIT_FAILURE;
+    if (!consume_command_line_arguments(&emulator, &options, argc, argv)) return EXIT_FAILURE;
+    else if (options.library_filename && !rom_library_open(&emulator.rom_library, options.library_filename)) {
+        return EXIT_FAILURE;
+    }
+    else if (!emulator_initialize(&emulator)) {
+        emulator_destroy(&emulator);
+        return EXIT_FAILURE;
+    }
+    else if (options.keymap && !emulator_user_interface_set_keymap(&emulator.user_interface, options.keymap)) {
+        emulator_destroy(&emulator);
+        return EXIT_FAILURE;
+    }
+    else if (options.record_filename && !video_stream_open(
+            &emulator.video_stream,
+            options.record_filename,
+            options.record_format,
+            emulator.user_interface.fg_color,
+            emulator.user_interface.bg_color,
+            emulator.user_interface.color_lerp_rate,
+            emulator.emulated_system.frames_per_second)) {
+        emulator_destroy(&emulator);
+        return EXIT_FAILURE;
+    }
+    else if (options.trace_filename && !trace_open(&emulator.trace, options.trace_filename, emulated_system_entry_point)) {
+        emulator_destroy(&emulator);
+        return EXIT_FAILURE;
+    }
+    else if (options.share_name && !frame_share_open(&emulator.frame_share, options.share_name)) {
+        emulator_destroy(&emulator);
+        return EXIT_FAILURE;
+    }
+    else if (options.watch_name && !live_patch_open(&emulator.live_patch, options.watch_name, &emulator.emulated_system)) {
+        emulator_destroy(&emulator);
+        return EXIT_FAILURE;
+    }
     else {
+        startup_trace_mark(&emulator.startup_trace, "outputs opened");
         srand(time(NULL));
+        emulator.user_interface.input_latency.is_enabled = options.measure_input_latency;
+
+        if (options.instructions_per_frame_minimum) {
+            emulator.rom_profile.instructions_per_frame_minimum = options.instructions_per_frame_minimum;
+            emulator.rom_profile.instructions_per_frame_maximum = options.instructions_per_frame_maximum;
+            rom_profile_save(&emulator.rom_profile);
+        }
+
+        if (options.instructions_per_frame) emulator.emulated_system.instructions_per_frame = options.instructions_per_frame;
+        if (options.auto_tune) autotune_begin(&emulator.autotune, &emulator.rom_profile, &emulator.emulated_system);
 
         while (emulator.emulated_system.state != QUIT) {
             emulator_update(&emulator);
         }
-        emulator_destroy(&emulator); 
+        emulator_destroy(&emulator);
         return EXIT_SUCCESS;
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,154 @@
+#include <string.h>
+
+#include "predecode.h"
+
+const char *const predecode_fusion_names[PREDECODE_FUSION_COUNT] = {
+    [PREDECODE_SINGLE] = "single",
+    [PREDECODE_LOAD_I_DRAW] = "ANNN; DXYN",
+    [PREDECODE_LOAD_I_LOAD_REGISTERS] = "ANNN; FX65",
+    [PREDECODE_COUNTED_LOOP] = "7XKK; skip; 1NNN",
+    [PREDECODE_DELAY_WAIT] = "FX07; skip; 1NNN",
+};
+
+static inline uint16_t predecode_word(const uint8_t *ram, uint16_t address) {
+    return (uint16_t)((ram[address] << 8) | ram[address + 1]);
+}
+
+static inline bool predecode_is_current(const struct PredecodedInstruction *entry, const uint8_t *ram, uint16_t address) {
+    for (uint8_t i = 0; i < entry->length; i++) {
+        if (predecode_word(ram, address + 2 * i) != entry->words[i]) return false;
+    }
+    return entry->length > 0;
+}
+
+// 3XKK or 4XKK on register x, the skips that end a loop
+static bool predecode_is_loop_test(struct DecodedInstruction decoded_instruction, uint8_t x) {
+    return (decoded_instruction.type == IF_EQUAL_THEN_SKIP || decoded_instruction.type == IF_NOT_EQUAL_THEN_SKIP)
+        && decoded_instruction.operands_layout == REGISTER_AND_VALUE
+        && decoded_instruction.register_index == x;
+}
+
+static void predecode_instruction(struct PredecodedInstruction *entry, const uint8_t *ram, uint16_t address) {
+    struct DecodedInstruction decoded[3];
+    uint8_t available = 1;
+
+    entry->words[0] = predecode_word(ram, address);
+    decoded[0] = decoded_instruction_from_encoded_instruction(entry->words[0]);
+
+    // Fused instructions must all lie in RAM
+    for (; available < 3 && address + 2 * available + 1 < 4096; available++) {
+        entry->words[available] = predecode_word(ram, address + 2 * available);
+        decoded[available] = decoded_instruction_from_encoded_instruction(entry->words[available]);
+    }
+
+    entry->fusion = PREDECODE_SINGLE;
+    entry->length = 1;
+    entry->decoded_instruction = decoded[0];
+
+    if (available >= 3 && decoded[2].type == JUMP && predecode_is_loop_test(decoded[1], decoded[0].register_index)) {
+        if (decoded[0].type == SUM_REGISTER) entry->fusion = PREDECODE_COUNTED_LOOP;
+        else if (decoded[0].type == MISC && decoded[0].value == 0x07) entry->fusion = PREDECODE_DELAY_WAIT;
+        if (entry->fusion != PREDECODE_SINGLE) entry->length = 3;
+    }
+    else if (available >= 2 && decoded[0].type == ADDRESS_TO_REGISTER_I) {
+        if (decoded[1].type == DRAW) entry->fusion = PREDECODE_LOAD_I_DRAW;
+        else if (decoded[1].type == MISC && decoded[1].value == 0x65) entry->fusion = PREDECODE_LOAD_I_LOAD_REGISTERS;
+
+        if (entry->fusion != PREDECODE_SINGLE) {
+            entry->length = 2;
+            entry->decoded_instruction = decoded[1];
+        }
+    }
+}
+
+unsigned int predecode_run(struct Predecode *predecode, struct EmulatedSystem *emulated_system,
+                           EmulatedSystemCore emulate_decoded_instruction, unsigned int count) {
+    unsigned int executed = 0;
+
+    while (executed < count && emulated_system->state == RUNNING) {
+        const uint16_t address = emulated_system->PC;
+        if (address >= 4095) {
+            emulated_system_consume_instruction(emulated_system); // Reports it and quits
+            break;
+        }
+
+        struct PredecodedInstruction *entry = &predecode->entries[address];
+        if (!predecode_is_current(entry, emulated_system->ram, address)) predecode_instruction(entry, emulated_system->ram, address);
+
+        // A fused sequence never runs past the end of the budget, its first instruction goes alone instead
+        if (entry->fusion == PREDECODE_SINGLE || entry->length > count - executed) {
+            emulated_system->encoded_instruction = entry->words[0];
+            emulated_system->decoded_instruction = (entry->fusion == PREDECODE_SINGLE)
+                ? entry->decoded_instruction : decoded_instruction_from_encoded_instruction(entry->words[0]);
+            emulated_system->PC += 2;
+            emulate_decoded_instruction(emulated_system);
+
+            predecode->statistics.fused_instructions[PREDECODE_SINGLE]++;
+            predecode->statistics.dispatches++;
+            executed++;
+            continue;
+        }
+
+        unsigned int length = entry->length;
+
+        switch (entry->fusion) {
+            case PREDECODE_LOAD_I_DRAW:
+            case PREDECODE_LOAD_I_LOAD_REGISTERS:
+                emulated_system->I = entry->words[0] & 0x0FFF;
+                emulated_system->encoded_instruction = entry->words[1];
+                emulated_system->decoded_instruction = entry->decoded_instruction;
+                emulated_system->PC += 4;
+                emulate_decoded_instruction(emulated_system);
+                break;
+
+            case PREDECODE_COUNTED_LOOP:
+            case PREDECODE_DELAY_WAIT: {
+                uint8_t *x = &emulated_system->V[(entry->words[0] >> 8) & 0xF];
+
+                if (entry->fusion == PREDECODE_COUNTED_LOOP) *x += entry->words[0] & 0xFF;
+                else {
+                    emulated_system->delay_timer_read_count++;
+                    *x = emulated_system->delay_timer;
+                }
+
+                // The test skips the jump, or the jump runs
+                const bool is_equal = *x == (entry->words[1] & 0xFF);
+                if (is_equal == ((entry->words[1] >> 12) == 0x3)) {
+                    emulated_system->PC += 6;
+                    length = 2;
+                }
+                else emulated_system->PC = entry->words[2] & 0x0FFF;
+
+                // Last instruction run, as the core would leave it. decoded_instruction keeps the previous core dispatch.
+                emulated_system->encoded_instruction = entry->words[length - 1];
+                break;
+            }
+        }
+
+        predecode->statistics.fused_instructions[entry->fusion] += length;
+        predecode->statistics.dispatches++;
+        executed += length;
+    }
+
+    predecode->statistics.instructions += executed;
+    return executed;
+}
+
+void predecode_report(const struct Predecode *predecode, FILE *output, const char *rom_name, uint64_t frames) {
+    const struct PredecodeStatistics *statistics = &predecode->statistics;
+    if (frames == 0) frames = 1;
+
+    unsigned int sites[PREDECODE_FUSION_COUNT] = {0};
+    for (unsigned int address = 0; address < 4096; address++) {
+        if (predecode->entries[address].length) sites[predecode->entries[address].fusion]++;
+    }
+
+    fprintf(output, "Fusion for %s: %.1f dispatches per frame, %.1f without fusion (%.1f%% fewer)\n", rom_name,
+            (double)statistics->dispatches / frames, (double)statistics->instructions / frames,
+            statistics->instructions ? 100.0 * (statistics->instructions - statistics->dispatches) / statistics->instructions : 0.0);
+
+    for (unsigned int fusion = 0; fusion < PREDECODE_FUSION_COUNT; fusion++) {
+        fprintf(output, "  %-18s %6.2f%% of instructions, %4u places\n", predecode_fusion_names[fusion],
+                statistics->instructions ? 100.0 * statistics->fused_instructions[fusion] / statistics->instructions : 0.0, sites[fusion]);
+    }
+}
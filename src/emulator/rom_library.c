@@ -0,0 +1,132 @@
+// Rom library reader, everything is read in place from the mapping
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "rom_hash.h"
+#include "rom_library.h"
+
+static bool rom_library_fits(const struct RomLibrary *rom_library, uint64_t offset, uint64_t size) {
+    return offset <= rom_library->size && size <= rom_library->size - offset;
+}
+
+bool rom_library_open(struct RomLibrary *rom_library, const char *filename) {
+    *rom_library = (struct RomLibrary){0};
+
+    const int file = open(filename, O_RDONLY);
+    if (file < 0) {
+        fprintf(stderr, "Rom library %s is invalid or does not exist\n", filename);
+        return false;
+    }
+
+    struct stat file_status;
+    if (fstat(file, &file_status) != 0 || (size_t)file_status.st_size < sizeof(struct RomLibraryHeader)) {
+        fprintf(stderr, "Rom library %s is too small\n", filename);
+        close(file);
+        return false;
+    }
+
+    const uint8_t *data = mmap(NULL, file_status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "Could not map rom library %s\n", filename);
+        return false;
+    }
+
+    rom_library->data = data;
+    rom_library->size = file_status.st_size;
+    rom_library->header = (const struct RomLibraryHeader *)data;
+
+    const struct RomLibraryHeader *header = rom_library->header;
+
+    // Only the tables are checked here, roms are checked when found
+    if (memcmp(header->magic, ROM_LIBRARY_MAGIC, sizeof header->magic) != 0
+        || header->version != ROM_LIBRARY_VERSION
+        || header->entries_offset % 8 != 0 || header->names_offset % 8 != 0
+        || !rom_library_fits(rom_library, header->entries_offset, (uint64_t)header->entry_count * sizeof(struct RomLibraryEntry))
+        || !rom_library_fits(rom_library, header->names_offset, (uint64_t)header->name_count * sizeof(struct RomLibraryName))
+        || !rom_library_fits(rom_library, header->strings_offset, header->strings_size)
+        || header->strings_size == 0 || data[header->strings_offset + header->strings_size - 1] != '\0') {
+        fprintf(stderr, "%s is not a rom library this version can read\n", filename);
+        rom_library_close(rom_library);
+        return false;
+    }
+
+    rom_library->entries = (const struct RomLibraryEntry *)(data + header->entries_offset);
+    rom_library->names = (const struct RomLibraryName *)(data + header->names_offset);
+    rom_library->strings = (const char *)(data + header->strings_offset);
+
+    return true;
+}
+
+void rom_library_close(struct RomLibrary *rom_library) {
+    if (rom_library->data) munmap((void *)rom_library->data, rom_library->size);
+    *rom_library = (struct RomLibrary){0};
+}
+
+const char *rom_library_name(const struct RomLibrary *rom_library, uint32_t index) {
+    if (index >= rom_library->header->name_count) return "";
+
+    const uint32_t string_offset = rom_library->names[index].string_offset;
+    return (string_offset < rom_library->header->strings_size) ? &rom_library->strings[string_offset] : "";
+}
+
+// First index whose name hash is not below name_hash
+static uint32_t rom_library_lower_bound_name(const struct RomLibrary *rom_library, uint64_t name_hash) {
+    uint32_t low = 0, high = rom_library->header->name_count;
+
+    while (low < high) {
+        const uint32_t middle = low + (high - low) / 2;
+        if (rom_library->names[middle].name_hash < name_hash) low = middle + 1;
+        else high = middle;
+    }
+
+    return low;
+}
+
+static const struct RomLibraryEntry *rom_library_find_hash(const struct RomLibrary *rom_library, uint64_t hash) {
+    uint32_t low = 0, high = rom_library->header->entry_count;
+
+    while (low < high) {
+        const uint32_t middle = low + (high - low) / 2;
+        if (rom_library->entries[middle].hash < hash) low = middle + 1;
+        else high = middle;
+    }
+
+    return (low < rom_library->header->entry_count && rom_library->entries[low].hash == hash) ? &rom_library->entries[low] : NULL;
+}
+
+static const struct RomLibraryEntry *rom_library_find_name(const struct RomLibrary *rom_library, const char *name) {
+    const uint64_t name_hash = rom_hash((const uint8_t *)name, strlen(name));
+
+    // Different names may share a hash
+    for (uint32_t i = rom_library_lower_bound_name(rom_library, name_hash);
+         i < rom_library->header->name_count && rom_library->names[i].name_hash == name_hash; i++) {
+        if (strcmp(rom_library_name(rom_library, i), name) == 0 && rom_library->names[i].entry_index < rom_library->header->entry_count)
+            return &rom_library->entries[rom_library->names[i].entry_index];
+    }
+
+    return NULL;
+}
+
+bool rom_library_find(const struct RomLibrary *rom_library, const char *key, const uint8_t **rom, size_t *rom_size) {
+    const struct RomLibraryEntry *entry = rom_library_find_name(rom_library, key);
+
+    if (!entry && strlen(key) == 16 && strspn(key, "0123456789abcdefABCDEF") == 16)
+        entry = rom_library_find_hash(rom_library, strtoull(key, NULL, 16));
+
+    if (!entry) return false;
+    if (!rom_library_fits(rom_library, entry->data_offset, entry->size)) {
+        fprintf(stderr, "Rom library entry %016llx is out of bounds\n", (long long unsigned)entry->hash);
+        return false;
+    }
+
+    *rom = rom_library->data + entry->data_offset;
+    *rom_size = entry->size;
+    return true;
+}
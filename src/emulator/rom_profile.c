@@ -0,0 +1,134 @@
+// Rom profiles: static analysis once per rom, cached by content hash
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "emulated.h"
+#include "program_analysis.h"
+#include "rom_hash.h"
+#include "rom_profile.h"
+
+static uint32_t rom_profile_features_of(uint16_t encoded_instruction) {
+    const uint8_t low_byte = encoded_instruction & 0x00FF;
+
+    switch ((encoded_instruction & 0xF000) >> 12) {
+        case 0x0:
+            if ((encoded_instruction & 0xFFF0) == 0x00C0 || (encoded_instruction >= 0x00FB && encoded_instruction <= 0x00FF))
+                return ROM_PROFILE_SUPERCHIP;
+            if ((encoded_instruction & 0xFFF0) == 0x00D0) return ROM_PROFILE_XOCHIP;
+            break;
+        case 0x5:
+            if ((encoded_instruction & 0x000F) == 2 || (encoded_instruction & 0x000F) == 3) return ROM_PROFILE_XOCHIP;
+            break;
+        case 0xF:
+            switch (low_byte) {
+                case 0x30: case 0x75: case 0x85: return ROM_PROFILE_SUPERCHIP;
+                case 0x00: case 0x01: case 0x02: case 0x3A: return ROM_PROFILE_XOCHIP;
+            }
+            break;
+    }
+
+    return 0;
+}
+
+bool rom_profile_analyze(struct RomProfile *rom_profile, const uint8_t *rom, size_t rom_size, uint16_t load_address) {
+    // Too big for the stack, and one per call so instances can be created from several threads
+    struct ProgramAnalysis *analysis = malloc(sizeof(struct ProgramAnalysis));
+    if (!analysis) return false;
+
+    program_analysis_run(analysis, rom, rom_size, load_address);
+
+    *rom_profile = (struct RomProfile){
+        .version = ROM_PROFILE_VERSION,
+        .hash = rom_hash(rom, rom_size),
+        .size = rom_size,
+        .instructions_per_frame_minimum = ROM_PROFILE_DEFAULT_MINIMUM_INSTRUCTIONS_PER_FRAME,
+        .instructions_per_frame_maximum = ROM_PROFILE_DEFAULT_MAXIMUM_INSTRUCTIONS_PER_FRAME,
+    };
+
+    for (uint32_t address = analysis->load_address; address < analysis->rom_end; address++) {
+        if (!program_analysis_is_code(analysis, address)) continue;
+        rom_profile->features |= rom_profile_features_of(program_analysis_encoded_instruction_at(analysis, address));
+    }
+
+    if (rom_profile->features & ROM_PROFILE_XOCHIP) rom_profile->extension = XOCHIP;
+    else if (rom_profile->features & ROM_PROFILE_SUPERCHIP) rom_profile->extension = SUPERCHIP;
+    else rom_profile->extension = CHIP8;
+
+    free(analysis);
+    return true;
+}
+
+// Builds the cache directory name, creating it when create is set
+static bool rom_profile_cache_directory(char *directory, size_t size, bool create) {
+    const char *cache_home = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+
+    if (cache_home && cache_home[0]) snprintf(directory, size, "%s", cache_home);
+    else if (home && home[0]) snprintf(directory, size, "%s/.cache", home);
+    else return false;
+
+    if (create) mkdir(directory, 0755);
+
+    const size_t length = strlen(directory);
+    snprintf(&directory[length], size - length, "/tracua-chip8");
+
+    if (create) mkdir(directory, 0755);
+
+    return true;
+}
+
+static bool rom_profile_cache_filename(char *filename, size_t size, uint64_t hash, bool create) {
+    char directory[4096];
+    if (!rom_profile_cache_directory(directory, sizeof directory, create)) return false;
+
+    snprintf(filename, size, "%s/%016llx.profile", directory, (long long unsigned)hash);
+    return true;
+}
+
+bool rom_profile_load(struct RomProfile *rom_profile, uint64_t hash, uint32_t size) {
+    char filename[4200];
+    if (!rom_profile_cache_filename(filename, sizeof filename, hash, false)) return false;
+
+    FILE *file = fopen(filename, "rb");
+    if (!file) return false;
+
+    struct RomProfile cached_profile;
+    const bool is_read = fread(&cached_profile, sizeof(struct RomProfile), 1, file) == 1;
+    fclose(file);
+
+    if (!is_read
+        || cached_profile.version != ROM_PROFILE_VERSION
+        || cached_profile.hash != hash
+        || cached_profile.size != size) return false;
+
+    *rom_profile = cached_profile;
+    return true;
+}
+
+bool rom_profile_save(const struct RomProfile *rom_profile) {
+    char filename[4200];
+    if (!rom_profile_cache_filename(filename, sizeof filename, rom_profile->hash, true)) return false;
+
+    FILE *file = fopen(filename, "wb");
+    if (!file) return false;
+    else if (fwrite(rom_profile, sizeof(struct RomProfile), 1, file) != 1) {
+        fclose(file);
+        return false;
+    }
+    else {
+        fclose(file);
+        return true;
+    }
+}
+
+bool rom_profile_get(struct RomProfile *rom_profile, const uint8_t *rom, size_t rom_size, uint16_t load_address) {
+    if (rom_profile_load(rom_profile, rom_hash(rom, rom_size), rom_size)) return true;
+    else if (!rom_profile_analyze(rom_profile, rom, rom_size, load_address)) return false;
+
+    if (!rom_profile_save(rom_profile))
+        fprintf(stderr, "Could not cache rom profile %016llx\n", (long long unsigned)rom_profile->hash);
+    return true;
+}
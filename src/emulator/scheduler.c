@@ -0,0 +1,46 @@
+// Event queue in emulated time
+
+#include "scheduler.h"
+
+static inline bool scheduler_is_before(const struct SchedulerEvent *a, const struct SchedulerEvent *b) {
+    return a->time < b->time || (a->time == b->time && a->type < b->type);
+}
+
+bool scheduler_post(struct Scheduler *scheduler, uint64_t time, enum SchedulerEventType type) {
+    if (scheduler->event_count == SCHEDULER_MAX_EVENTS) return false;
+
+    // Sift up
+    unsigned int i = scheduler->event_count++;
+    const struct SchedulerEvent event = { .time = time, .type = type };
+
+    while (i > 0 && scheduler_is_before(&event, &scheduler->events[(i - 1) / 2])) {
+        scheduler->events[i] = scheduler->events[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    scheduler->events[i] = event;
+
+    return true;
+}
+
+bool scheduler_take_due(struct Scheduler *scheduler, struct SchedulerEvent *event) {
+    if (scheduler->event_count == 0 || scheduler->events[0].time > scheduler->now) return false;
+
+    *event = scheduler->events[0];
+
+    // Sift the last event down from the root
+    const struct SchedulerEvent last = scheduler->events[--scheduler->event_count];
+    unsigned int i = 0;
+
+    for (;;) {
+        unsigned int child = 2 * i + 1;
+        if (child >= scheduler->event_count) break;
+        if (child + 1 < scheduler->event_count && scheduler_is_before(&scheduler->events[child + 1], &scheduler->events[child])) child++;
+        if (!scheduler_is_before(&scheduler->events[child], &last)) break;
+
+        scheduler->events[i] = scheduler->events[child];
+        i = child;
+    }
+    scheduler->events[i] = last;
+
+    return true;
+}
@@ -0,0 +1,48 @@
+#include <time.h>
+
+#include "startup_trace.h"
+
+static uint64_t startup_trace_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+void startup_trace_begin(struct StartupTrace *startup_trace) {
+    startup_trace->start = startup_trace_now_ns();
+    atomic_store(&startup_trace->mark_count, 0);
+}
+
+void startup_trace_mark(struct StartupTrace *startup_trace, const char *name) {
+    if (!startup_trace->is_enabled) return;
+
+    const uint64_t at = startup_trace_now_ns();
+    const unsigned int index = atomic_fetch_add(&startup_trace->mark_count, 1);
+    if (index >= STARTUP_TRACE_MAX_MARKS) return;
+
+    startup_trace->marks[index].name = name;
+    startup_trace->marks[index].at = at;
+}
+
+void startup_trace_report(const struct StartupTrace *startup_trace, FILE *output, const char *rom_name) {
+    unsigned int count = atomic_load(&startup_trace->mark_count);
+    if (count > STARTUP_TRACE_MAX_MARKS) count = STARTUP_TRACE_MAX_MARKS;
+
+    // Marks from the loading thread may have landed out of order, a few of them at most
+    unsigned int order[STARTUP_TRACE_MAX_MARKS];
+    for (unsigned int i = 0; i < count; i++) {
+        unsigned int j = i;
+        for (; j > 0 && startup_trace->marks[order[j - 1]].at > startup_trace->marks[i].at; j--) order[j] = order[j - 1];
+        order[j] = i;
+    }
+
+    const uint64_t end = (count > 0) ? startup_trace->marks[order[count - 1]].at : startup_trace->start;
+    fprintf(output, "Startup of %s: %.2f ms to the first frame\n", rom_name, (end - startup_trace->start) / 1e6);
+
+    uint64_t previous = startup_trace->start;
+    for (unsigned int i = 0; i < count; i++) {
+        const uint64_t at = startup_trace->marks[order[i]].at;
+        fprintf(output, "  %8.2f ms  +%7.2f ms  %s\n", (at - startup_trace->start) / 1e6, (at - previous) / 1e6, startup_trace->marks[order[i]].name);
+        previous = at;
+    }
+}
@@ -0,0 +1,193 @@
+// Execution trace, records go through a lock-free ring to a writer thread
+
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+
+#ifdef TRACE_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "trace.h"
+
+#define TRACE_RING_MASK (TRACE_RING_RECORDS - 1)
+
+static bool trace_write(struct Trace *trace, const void *data, size_t size) {
+#ifdef TRACE_HAVE_ZLIB
+    if (trace->compressed_output) return gzwrite(trace->compressed_output, data, (unsigned int)size) == (int)size;
+#endif
+    return fwrite(data, 1, size, trace->output) == size;
+}
+
+static void *trace_writer(void *userdata) {
+    struct Trace *trace = userdata;
+    uint32_t tail = atomic_load_explicit(&trace->tail, memory_order_relaxed);
+    bool has_failed = false;
+
+    while (true) {
+        // Read before head, so records published before closing are still drained
+        const bool is_closing = atomic_load_explicit(&trace->is_closing, memory_order_acquire);
+        const uint32_t head = atomic_load_explicit(&trace->head, memory_order_acquire);
+
+        if (head == tail) {
+            if (is_closing) break;
+            nanosleep(&(struct timespec){ .tv_nsec = 1000000 }, NULL);
+            continue;
+        }
+
+        // Up to the end of the ring, the rest goes on the next pass
+        const uint32_t first = tail & TRACE_RING_MASK;
+        uint32_t count = head - tail;
+        if (first + count > TRACE_RING_RECORDS) count = TRACE_RING_RECORDS - first;
+
+        // After a failed write records are still drained, so the emulator never blocks
+        if (!has_failed && !trace_write(trace, &trace->records[first], count * sizeof(struct TraceRecord))) {
+            fprintf(stderr, "Could not write trace, the rest is discarded\n");
+            has_failed = true;
+        }
+
+        tail += count;
+        atomic_store_explicit(&trace->tail, tail, memory_order_release);
+    }
+
+    return NULL;
+}
+
+bool trace_open(struct Trace *trace, const char *filename, uint16_t load_address) {
+    *trace = (struct Trace){0};
+
+    const size_t length = strlen(filename);
+    const bool is_compressed = length > 3 && strcmp(&filename[length - 3], ".gz") == 0;
+
+#ifdef TRACE_HAVE_ZLIB
+    if (is_compressed) {
+        trace->compressed_output = gzopen(filename, "wb1"); // Fastest level, the writer has to keep up
+        if (!trace->compressed_output) {
+            fprintf(stderr, "Could not open trace output %s\n", filename);
+            return false;
+        }
+        gzbuffer(trace->compressed_output, 1 << 20);
+    }
+#else
+    if (is_compressed) {
+        fprintf(stderr, "Built without zlib, %s can't be compressed\n", filename);
+        return false;
+    }
+#endif
+
+    if (!is_compressed) {
+        trace->output = fopen(filename, "wb");
+        if (!trace->output) {
+            fprintf(stderr, "Could not open trace output %s\n", filename);
+            return false;
+        }
+        setvbuf(trace->output, NULL, _IOFBF, 1 << 20);
+    }
+
+    const struct TraceFileHeader header = {
+        .magic = TRACE_MAGIC,
+        .version = TRACE_VERSION,
+        .record_size = sizeof(struct TraceRecord),
+        .load_address = load_address,
+    };
+
+    trace->records = malloc(TRACE_RING_RECORDS * sizeof(struct TraceRecord));
+
+    if (!trace->records || !trace_write(trace, &header, sizeof header)
+        || pthread_create(&trace->writer, NULL, trace_writer, trace) != 0) {
+        fprintf(stderr, "Could not start trace writer\n");
+#ifdef TRACE_HAVE_ZLIB
+        if (trace->compressed_output) gzclose(trace->compressed_output);
+#endif
+        if (trace->output) fclose(trace->output);
+        free(trace->records);
+        *trace = (struct Trace){0};
+        return false;
+    }
+
+    trace->is_open = true;
+    return true;
+}
+
+// Register written by the instruction, taken from the opcode. Comparing every register
+// before and after reads back bytes the core just stored, which stalls store forwarding.
+static inline uint8_t trace_destination_register(uint16_t encoded_instruction) {
+    const uint8_t x = (encoded_instruction >> 8) & 0xF;
+
+    switch (encoded_instruction >> 12) {
+        case 0x6: case 0x7: case 0x8: case 0xC:
+            return x;
+        case 0xD:
+            return 0xF; // Collision flag
+        case 0xF:
+            switch (encoded_instruction & 0xFF) {
+                case 0x07: case 0x0A: case 0x65: return x; // Fx65 loads V0 to Vx
+                default: return TRACE_NO_REGISTER;
+            }
+        default:
+            return TRACE_NO_REGISTER;
+    }
+}
+
+unsigned int trace_run(struct Trace *trace, struct EmulatedSystem *emulated_system,
+                       EmulatedSystemCore emulate_decoded_instruction, unsigned int count) {
+    struct TraceRecord *records = trace->records;
+    uint32_t head = atomic_load_explicit(&trace->head, memory_order_relaxed);
+    unsigned int executed = 0;
+
+    while (executed < count && emulated_system->state == RUNNING) {
+        const uint32_t tail = atomic_load_explicit(&trace->tail, memory_order_acquire);
+        uint32_t available = TRACE_RING_RECORDS - (head - tail);
+
+        if (available == 0) {
+            trace->stalls++;
+            sched_yield();
+            continue;
+        }
+        if (available > count - executed) available = count - executed;
+
+        // Records are published once per batch, not per instruction. The batch ends with the run, like the other loops.
+        for (; available > 0 && emulated_system->state == RUNNING; available--) {
+            const uint16_t PC = emulated_system->PC;
+            if (!emulated_system_consume_instruction(emulated_system)) break;
+
+            emulate_decoded_instruction(emulated_system);
+
+            const uint8_t register_index = trace_destination_register(emulated_system->encoded_instruction);
+            const struct TraceRecord record = {
+                .PC = PC,
+                .encoded_instruction = emulated_system->encoded_instruction,
+                .I = emulated_system->I,
+                .register_index = register_index,
+                .register_value = (register_index != TRACE_NO_REGISTER) ? emulated_system->V[register_index] : 0,
+            };
+            records[head & TRACE_RING_MASK] = record;
+
+            head++;
+            executed++;
+        }
+
+        atomic_store_explicit(&trace->head, head, memory_order_release);
+    }
+
+    return executed;
+}
+
+void trace_close(struct Trace *trace) {
+    if (!trace->is_open) return;
+
+    atomic_store_explicit(&trace->is_closing, true, memory_order_release);
+    pthread_join(trace->writer, NULL);
+
+#ifdef TRACE_HAVE_ZLIB
+    if (trace->compressed_output) gzclose(trace->compressed_output);
+#endif
+    if (trace->output) fclose(trace->output);
+
+    if (trace->stalls > 0)
+        fprintf(stderr, "Trace writer fell behind %llu times\n", (long long unsigned)trace->stalls);
+
+    free(trace->records);
+    *trace = (struct Trace){0};
+}
@@ -0,0 +1,66 @@
+// COSMAC VIP timing model. Costs approximate the routines of the original interpreter.
+
+#include "vip_timing.h"
+
+#define VIP_FETCH_CYCLES 40 // Fetch, decode and dispatch, paid by every instruction
+
+uint32_t vip_timing_cycles(uint16_t encoded_instruction) {
+    const uint8_t x = (encoded_instruction >> 8) & 0xF;
+    const uint8_t n = encoded_instruction & 0xF;
+
+    switch (encoded_instruction >> 12) {
+        case 0x0:
+            if (encoded_instruction == 0x00E0) return VIP_FETCH_CYCLES + 24 + 3078; // Clears 256 bytes
+            if (encoded_instruction == 0x00EE) return VIP_FETCH_CYCLES + 10;
+            return VIP_FETCH_CYCLES + 26; // Machine code call
+        case 0x1: return VIP_FETCH_CYCLES + 12;
+        case 0x2: return VIP_FETCH_CYCLES + 26;
+        case 0x3: case 0x4: return VIP_FETCH_CYCLES + 14;
+        case 0x5: case 0x9: return VIP_FETCH_CYCLES + 18;
+        case 0x6: return VIP_FETCH_CYCLES + 6;
+        case 0x7: return VIP_FETCH_CYCLES + 10;
+        case 0x8: return VIP_FETCH_CYCLES + 44;
+        case 0xA: return VIP_FETCH_CYCLES + 12;
+        case 0xB: return VIP_FETCH_CYCLES + 22;
+        case 0xC: return VIP_FETCH_CYCLES + 36;
+        case 0xD: return VIP_FETCH_CYCLES + 26 + n * 46; // Each row is shifted into place and XORed in two bytes
+        case 0xE: return VIP_FETCH_CYCLES + 18;
+        case 0xF:
+            switch (encoded_instruction & 0xFF) {
+                case 0x07: case 0x15: case 0x18: return VIP_FETCH_CYCLES + 10;
+                case 0x0A: return VIP_FETCH_CYCLES + 19; // Per check, the instruction repeats until a key is down
+                case 0x1E: case 0x29: return VIP_FETCH_CYCLES + 16;
+                case 0x33: return VIP_FETCH_CYCLES + 84 + 3 * 16; // Repeated subtraction per digit
+                case 0x55: case 0x65: return VIP_FETCH_CYCLES + 14 + 14 * (x + 1);
+                default: return VIP_FETCH_CYCLES;
+            }
+        default:
+            return VIP_FETCH_CYCLES;
+    }
+}
+
+unsigned int vip_timing_run_frame(struct VipTiming *vip_timing, struct EmulatedSystem *emulated_system,
+                                  EmulatedSystemCore emulate_decoded_instruction) {
+    unsigned int executed = 0;
+
+    // Display interrupt: timers count down, then DMA takes its cycles
+    if (emulated_system->delay_timer > 0) emulated_system->delay_timer--;
+    if (emulated_system->sound_timer > 0) emulated_system->sound_timer--;
+
+    vip_timing->next_interrupt += VIP_CYCLES_PER_FRAME;
+    vip_timing->cycle_count += VIP_DISPLAY_CYCLES;
+
+    while (vip_timing->cycle_count < vip_timing->next_interrupt && emulated_system->state == RUNNING) {
+        if (!emulated_system_consume_instruction(emulated_system)) break;
+
+        emulate_decoded_instruction(emulated_system);
+        executed++;
+
+        // Sprites are drawn after the interrupt, the rest of this frame is spent waiting
+        if ((emulated_system->encoded_instruction >> 12) == 0xD) vip_timing->cycle_count = vip_timing->next_interrupt;
+
+        vip_timing->cycle_count += vip_timing_cycles(emulated_system->encoded_instruction);
+    }
+
+    return executed;
+}
@@ -0,0 +1,82 @@
+// Follows a running emulator through its shared frames (--share) and draws them in the terminal
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "user_interface/frame_share.h"
+
+static const char *const usage =
+    "Usage: %s <name> [--frames <count>] [--quiet]\n"
+    "  Reads the segment published by tracua-chip8-emulator --share <name>\n"
+    "  --quiet only counts frames, received and missed ones are printed on exit\n";
+
+static void frame_reader_draw(const struct FrameShareFrame *frame) {
+    // Cursor home, the frame is drawn over the last one
+    printf("\033[H");
+    for (uint32_t y = 0; y < EMULATED_DISPLAY_HEIGHT; y++) {
+        char row[EMULATED_DISPLAY_WIDTH + 1];
+        for (uint32_t x = 0; x < EMULATED_DISPLAY_WIDTH; x++)
+            row[x] = emulated_display_pixel(frame->display, x, y) ? '#' : ' ';
+        row[EMULATED_DISPLAY_WIDTH] = '\0';
+        printf("|%s|\n", row);
+    }
+
+    printf("frame %llu PC %03x I %03x SP %x DT %02x ST %02x\n",
+           (long long unsigned)frame->frame_number, frame->PC, frame->I, frame->SP, frame->delay_timer, frame->sound_timer);
+    for (int i = 0; i < 16; i++) printf("V%X %02x%s", i, frame->V[i], (i == 15) ? "\n" : " ");
+    fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, usage, argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    uint64_t frame_limit = 0;
+    bool is_quiet = false;
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) frame_limit = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--quiet") == 0) is_quiet = true;
+        else {
+            fprintf(stderr, usage, argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    struct FrameShareReader reader;
+    if (!frame_share_reader_open(&reader, argv[1])) return EXIT_FAILURE;
+
+    if (!is_quiet) printf("\033[2J");
+
+    struct FrameShareFrame frame;
+    uint64_t last_frame_number = 0;
+    uint64_t received = 0;
+    uint64_t missed = 0;
+    unsigned int idle_polls = 0;
+
+    // Polled a few times per emulated frame, a frame that stops changing for 2 seconds means the emulator is gone
+    while ((!frame_limit || received < frame_limit) && idle_polls < 2000) {
+        if (!frame_share_read(&reader, &frame)) {
+            idle_polls++;
+            nanosleep(&(struct timespec){ .tv_nsec = 1000000 }, NULL);
+            continue;
+        }
+
+        if (last_frame_number && frame.frame_number > last_frame_number + 1) missed += frame.frame_number - last_frame_number - 1;
+        last_frame_number = frame.frame_number;
+        received++;
+        idle_polls = 0;
+
+        if (!is_quiet) frame_reader_draw(&frame);
+    }
+
+    fprintf(stderr, "%llu frames received, %llu missed, %llu torn reads retried\n",
+            (long long unsigned)received, (long long unsigned)missed, (long long unsigned)reader.torn_read_count);
+
+    frame_share_reader_close(&reader);
+    return EXIT_SUCCESS;
+}
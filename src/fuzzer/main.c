@@ -0,0 +1,483 @@
+// Coverage-guided exploration of game states: mutates keypad input, not rom bytes, and keeps the inputs that make the
+// guest take PC to PC transitions it never took before. Each kept input starts from the snapshot its parent ended in,
+// so exploring deeper only runs the new frames.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "emulated.h"
+#include "rom_profile.h"
+
+#define FUZZER_MAP_BITS 14
+#define FUZZER_MAP_SIZE (1 << FUZZER_MAP_BITS) // Edge slots, a hit count byte each
+#define FUZZER_MAX_CHUNK_FRAMES 600
+#define FUZZER_MAX_JOBS 64
+
+// Input for chunk_frames frames from where the parent ended, so movies form a tree rooted at the boot state
+struct FuzzerEntry {
+    struct FuzzerEntry *parent; // NULL for the root
+    uint32_t id;
+    uint32_t depth_frames; // Frames from boot to the end of this entry, the length of its movie
+    uint32_t chunk_frames;
+    uint16_t keys_read; // Keys the guest checked while running it, mutations press these
+    atomic_uint fuzz_count;
+    struct EmulatedSystem snapshot; // State at the end of the movie, children start from it
+    uint16_t chunk[]; // keypad per frame
+};
+
+struct Fuzzer {
+    // Set before the workers start
+    EmulatedSystemCore emulate_decoded_instruction;
+    unsigned int chunk_frames;
+    const char *output_directory; // Movies and states of new entries go here when set
+
+    pthread_mutex_t lock; // Guards the rest, except the atomics
+    struct FuzzerEntry **entries;
+    size_t entry_count;
+    size_t entry_capacity;
+    uint8_t virgin[FUZZER_MAP_SIZE]; // Hit count buckets no run reached yet, AFL style
+    uint32_t edge_count; // Slots reached at least once
+    uint32_t deepest_frames;
+    uint64_t stop_count; // Runs where the rom quit or ran off memory
+
+    atomic_uint_fast64_t exec_count;
+    atomic_bool is_stopping;
+};
+
+struct FuzzerWorker {
+    struct Fuzzer *fuzzer;
+    pthread_t thread;
+    uint64_t random; // xorshift64 state, rand() is left to CXKK
+
+    struct EmulatedSystem emulated_system;
+    uint8_t hits[FUZZER_MAP_SIZE];
+    uint16_t touched[FUZZER_MAP_SIZE]; // Slots hit by this run, so only those are classified and cleared
+    uint32_t touched_count;
+    uint16_t chunk[FUZZER_MAX_CHUNK_FRAMES];
+};
+
+static const char *const usage =
+    "Usage: tracua-chip8-fuzzer <rom_name> [--seconds <count>] [--jobs <count>] [--chunk <frames>] [--ipf <count>]\n"
+    "          [--extension chip8|superchip] [--output <directory>] [--replay <movie.keys>]\n"
+    "  Each entry that reaches new coverage is written as <id>.keys, the keypad word of every frame from boot,\n"
+    "  and <id>.state, the emulator save state at its end (CXKK draws from rand(), so a movie may not replay exactly)\n";
+
+static uint64_t fuzzer_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+static inline uint64_t fuzzer_random(struct FuzzerWorker *worker) {
+    worker->random ^= worker->random << 13;
+    worker->random ^= worker->random >> 7;
+    worker->random ^= worker->random << 17;
+    return worker->random;
+}
+
+static inline uint32_t fuzzer_random_below(struct FuzzerWorker *worker, uint32_t limit) {
+    return (uint32_t)(fuzzer_random(worker) % limit);
+}
+
+static inline void fuzzer_hit(struct FuzzerWorker *worker, uint16_t from, uint16_t to) {
+    const uint32_t slot = ((from * 0x9E3779B1u) ^ (to * 0x85EBCA77u)) >> (32 - FUZZER_MAP_BITS);
+
+    if (worker->hits[slot] == 0) worker->touched[worker->touched_count++] = (uint16_t)slot;
+    if (worker->hits[slot] < UINT8_MAX) worker->hits[slot]++;
+}
+
+// Hit counts in power of two buckets, so a loop running a few more times is not new coverage
+static inline uint8_t fuzzer_bucket(uint8_t hits) {
+    if (hits <= 2) return hits;
+    else if (hits == 3) return 4;
+    else if (hits < 8) return 8;
+    else if (hits < 16) return 16;
+    else if (hits < 32) return 32;
+    else if (hits < 128) return 64;
+    return 128;
+}
+
+// Runs frames of input from worker->emulated_system, counting every transfer to anything but the next instruction.
+// Returns false when the rom stopped.
+static bool fuzzer_run(struct FuzzerWorker *worker, const uint16_t *chunk, unsigned int chunk_frames) {
+    struct EmulatedSystem *emulated_system = &worker->emulated_system;
+    const EmulatedSystemCore emulate_decoded_instruction = worker->fuzzer->emulate_decoded_instruction;
+
+    for (unsigned int frame = 0; frame < chunk_frames; frame++) {
+        emulated_system->keypad = chunk[frame];
+
+        for (unsigned int i = 0; i < emulated_system->instructions_per_frame; i++) {
+            const uint16_t from = emulated_system->PC;
+
+            // Checked here, so a run off memory is a stop instead of a message per run
+            if (from >= 4095) emulated_system->state = QUIT;
+            if (emulated_system->state != RUNNING) return false;
+
+            emulated_system_consume_instruction(emulated_system);
+            emulate_decoded_instruction(emulated_system);
+
+            if (emulated_system->PC != (uint16_t)(from + 2)) fuzzer_hit(worker, from, emulated_system->PC);
+        }
+
+        if (emulated_system->delay_timer > 0) emulated_system->delay_timer--;
+        if (emulated_system->sound_timer > 0) emulated_system->sound_timer--;
+    }
+
+    return emulated_system->state == RUNNING;
+}
+
+// Parent's input with a few AFL style edits, the keys the parent read are pressed far more often than the rest
+static void fuzzer_mutate(struct FuzzerWorker *worker, const struct FuzzerEntry *parent) {
+    const unsigned int frames = worker->fuzzer->chunk_frames;
+    const uint16_t keys = parent->keys_read ? parent->keys_read : 0xFFFF;
+    const uint16_t held = parent->chunk_frames ? parent->chunk[parent->chunk_frames - 1] : 0;
+
+    for (unsigned int i = 0; i < frames; i++)
+        worker->chunk[i] = (i < parent->chunk_frames) ? parent->chunk[i] : held;
+
+    for (uint32_t edits = 1 + fuzzer_random_below(worker, 4); edits > 0; edits--) {
+        uint16_t key;
+        do {
+            key = (uint16_t)(1u << fuzzer_random_below(worker, 16));
+        } while (!(key & keys) && fuzzer_random_below(worker, 8) != 0);
+
+        const unsigned int first = fuzzer_random_below(worker, frames);
+        const unsigned int last = first + fuzzer_random_below(worker, frames - first);
+
+        switch (fuzzer_random_below(worker, 5)) {
+            case 0: // Hold a key
+                for (unsigned int i = first; i <= last; i++) worker->chunk[i] |= key;
+                break;
+            case 1: // Release a key
+                for (unsigned int i = first; i <= last; i++) worker->chunk[i] &= ~key;
+                break;
+            case 2: // Tap a key
+                worker->chunk[first] ^= key;
+                break;
+            case 3: // Nothing held
+                for (unsigned int i = first; i <= last; i++) worker->chunk[i] = 0;
+                break;
+            case 4: // Mash
+                for (unsigned int i = first; i <= last; i++) worker->chunk[i] = (uint16_t)fuzzer_random(worker) & keys;
+                break;
+        }
+    }
+}
+
+// Two random entries, the one fuzzed less wins
+static struct FuzzerEntry *fuzzer_pick(struct FuzzerWorker *worker) {
+    struct Fuzzer *fuzzer = worker->fuzzer;
+
+    pthread_mutex_lock(&fuzzer->lock);
+    struct FuzzerEntry *a = fuzzer->entries[fuzzer_random_below(worker, (uint32_t)fuzzer->entry_count)];
+    struct FuzzerEntry *b = fuzzer->entries[fuzzer_random_below(worker, (uint32_t)fuzzer->entry_count)];
+    pthread_mutex_unlock(&fuzzer->lock);
+
+    struct FuzzerEntry *picked = (atomic_load(&b->fuzz_count) < atomic_load(&a->fuzz_count)) ? b : a;
+    atomic_fetch_add(&picked->fuzz_count, 1);
+    return picked;
+}
+
+static struct FuzzerEntry *fuzzer_entry_create(struct FuzzerEntry *parent, const uint16_t *chunk, unsigned int chunk_frames,
+                                               const struct EmulatedSystem *snapshot) {
+    // Rounded up, aligned_alloc wants a multiple of the alignment struct EmulatedSystem asks for
+    const size_t size = (sizeof(struct FuzzerEntry) + chunk_frames * sizeof(uint16_t) + 63) & ~(size_t)63;
+    struct FuzzerEntry *entry = aligned_alloc(64, size);
+    if (!entry) return NULL;
+
+    entry->parent = parent;
+    entry->depth_frames = (parent ? parent->depth_frames : 0) + chunk_frames;
+    entry->chunk_frames = chunk_frames;
+    entry->keys_read = snapshot->keypad_observed;
+    atomic_init(&entry->fuzz_count, 0);
+    entry->snapshot = *snapshot;
+    if (chunk_frames) memcpy(entry->chunk, chunk, chunk_frames * sizeof(uint16_t));
+    return entry;
+}
+
+// Movie from boot, the chunks of every ancestor in order
+static void fuzzer_write_entry(const struct Fuzzer *fuzzer, struct FuzzerEntry *entry, const char *prefix) {
+    uint16_t *movie = malloc(entry->depth_frames * sizeof(uint16_t));
+    if (!movie) return;
+
+    uint32_t end = entry->depth_frames;
+    for (const struct FuzzerEntry *ancestor = entry; ancestor; ancestor = ancestor->parent) {
+        end -= ancestor->chunk_frames;
+        for (uint32_t i = 0; i < ancestor->chunk_frames; i++) {
+            // Little endian on disk whatever the host is
+            const uint8_t bytes[2] = { ancestor->chunk[i] & 0xFF, ancestor->chunk[i] >> 8 };
+            memcpy(&movie[end + i], bytes, sizeof bytes);
+        }
+    }
+
+    char path[4096];
+    snprintf(path, sizeof path, "%s/%s%06u.keys", fuzzer->output_directory, prefix, entry->id);
+    FILE *file = fopen(path, "wb");
+    if (!file || fwrite(movie, sizeof(uint16_t), entry->depth_frames, file) != entry->depth_frames)
+        fprintf(stderr, "Could not write %s\n", path);
+    if (file) fclose(file);
+    free(movie);
+
+    snprintf(path, sizeof path, "%s/%s%06u.state", fuzzer->output_directory, prefix, entry->id);
+    if (!emulated_state_save(&entry->snapshot, path)) fprintf(stderr, "Could not write %s\n", path);
+}
+
+// Called with the lock held
+static bool fuzzer_append(struct Fuzzer *fuzzer, struct FuzzerEntry *entry) {
+    if (fuzzer->entry_count == fuzzer->entry_capacity) {
+        const size_t capacity = fuzzer->entry_capacity * 2;
+        struct FuzzerEntry **entries = realloc(fuzzer->entries, capacity * sizeof *entries);
+        if (!entries) return false;
+
+        fuzzer->entries = entries;
+        fuzzer->entry_capacity = capacity;
+    }
+
+    entry->id = (uint32_t)fuzzer->entry_count;
+    fuzzer->entries[fuzzer->entry_count++] = entry;
+    if (entry->depth_frames > fuzzer->deepest_frames) fuzzer->deepest_frames = entry->depth_frames;
+    return true;
+}
+
+// Merges the run's hit counts into the virgin map, keeps the run as an entry when it reached something new
+static void fuzzer_keep_if_new(struct FuzzerWorker *worker, struct FuzzerEntry *parent, bool is_running) {
+    struct Fuzzer *fuzzer = worker->fuzzer;
+    uint32_t new_buckets = 0;
+    struct FuzzerEntry *entry = NULL;
+
+    pthread_mutex_lock(&fuzzer->lock);
+    for (uint32_t i = 0; i < worker->touched_count; i++) {
+        const uint16_t slot = worker->touched[i];
+        const uint8_t bucket = fuzzer_bucket(worker->hits[slot]);
+
+        if (fuzzer->virgin[slot] & bucket) {
+            if (fuzzer->virgin[slot] == UINT8_MAX) fuzzer->edge_count++;
+            fuzzer->virgin[slot] &= ~bucket;
+            new_buckets++;
+        }
+        worker->hits[slot] = 0;
+    }
+    worker->touched_count = 0;
+
+    if (new_buckets) entry = fuzzer_entry_create(parent, worker->chunk, fuzzer->chunk_frames, &worker->emulated_system);
+
+    if (entry && !is_running) {
+        entry->id = (uint32_t)fuzzer->stop_count;
+    }
+    else if (entry && !fuzzer_append(fuzzer, entry)) {
+        free(entry);
+        entry = NULL;
+    }
+    if (!is_running) fuzzer->stop_count++;
+    pthread_mutex_unlock(&fuzzer->lock);
+
+    // Written outside the lock, entries never change once kept
+    if (entry && fuzzer->output_directory) fuzzer_write_entry(fuzzer, entry, is_running ? "" : "stop_");
+
+    // A stopped run is never a parent, it only keeps its files
+    if (entry && !is_running) free(entry);
+}
+
+static void *fuzzer_worker(void *userdata) {
+    struct FuzzerWorker *worker = userdata;
+    struct Fuzzer *fuzzer = worker->fuzzer;
+
+    while (!atomic_load_explicit(&fuzzer->is_stopping, memory_order_relaxed)) {
+        struct FuzzerEntry *parent = fuzzer_pick(worker);
+
+        worker->emulated_system = parent->snapshot;
+        worker->emulated_system.keypad_observed = 0;
+        fuzzer_mutate(worker, parent);
+
+        const bool is_running = fuzzer_run(worker, worker->chunk, fuzzer->chunk_frames);
+        fuzzer_keep_if_new(worker, parent, is_running);
+
+        atomic_fetch_add_explicit(&fuzzer->exec_count, 1, memory_order_relaxed);
+    }
+
+    return NULL;
+}
+
+static bool fuzzer_load_rom(struct EmulatedSystem *emulated_system, const char *rom_name, int extension, unsigned int instructions_per_frame) {
+    emulated_system_initialize(emulated_system);
+
+    FILE *rom = fopen(rom_name, "rb");
+    if (!rom) {
+        fprintf(stderr, "Rom file %s is invalid or does not exist\n", rom_name);
+        return false;
+    }
+
+    const size_t max_size = sizeof emulated_system->ram - emulated_system_entry_point;
+    const size_t rom_size = fread(&emulated_system->ram[emulated_system_entry_point], 1, max_size, rom);
+    fclose(rom);
+
+    if (rom_size == 0) {
+        fprintf(stderr, "Rom file %s is empty\n", rom_name);
+        return false;
+    }
+
+    // Same quirks and speed the emulator would pick, unless given
+    struct RomProfile rom_profile;
+    if (!rom_profile_analyze(&rom_profile, &emulated_system->ram[emulated_system_entry_point], rom_size, emulated_system_entry_point)) {
+        fprintf(stderr, "Could not analyse rom %s\n", rom_name);
+        return false;
+    }
+    emulated_system->extension = (extension >= 0) ? extension : rom_profile.extension;
+    if (instructions_per_frame) emulated_system->instructions_per_frame = instructions_per_frame;
+    else if (rom_profile.instructions_per_frame) emulated_system->instructions_per_frame = rom_profile.instructions_per_frame;
+
+    return true;
+}
+
+// Plays a movie from boot and prints where it ended
+static bool fuzzer_replay(struct EmulatedSystem *emulated_system, const char *movie_name) {
+    FILE *file = fopen(movie_name, "rb");
+    if (!file) {
+        fprintf(stderr, "Movie %s is invalid or does not exist\n", movie_name);
+        return false;
+    }
+
+    const EmulatedSystemCore emulate_decoded_instruction = emulated_system_core(emulated_system);
+    uint64_t frame_count = 0;
+    uint8_t bytes[2];
+
+    while (emulated_system->state == RUNNING && fread(bytes, 1, sizeof bytes, file) == sizeof bytes) {
+        emulated_system->keypad = (uint16_t)(bytes[0] | bytes[1] << 8);
+
+        for (unsigned int i = 0; i < emulated_system->instructions_per_frame && emulated_system->state == RUNNING; i++) {
+            if (!emulated_system_consume_instruction(emulated_system)) break;
+            emulate_decoded_instruction(emulated_system);
+        }
+
+        if (emulated_system->delay_timer > 0) emulated_system->delay_timer--;
+        if (emulated_system->sound_timer > 0) emulated_system->sound_timer--;
+        frame_count++;
+    }
+    fclose(file);
+
+    for (uint32_t y = 0; y < EMULATED_DISPLAY_HEIGHT; y++) {
+        for (uint32_t x = 0; x < EMULATED_DISPLAY_WIDTH; x++) putchar(emulated_display_pixel(emulated_system->display, x, y) ? '#' : '.');
+        putchar('\n');
+    }
+    printf("%llu frames, PC %03x, I %03x%s\n", (long long unsigned)frame_count, emulated_system->PC, emulated_system->I,
+           (emulated_system->state == RUNNING) ? "" : ", stopped");
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fputs(usage, stderr);
+        return EXIT_FAILURE;
+    }
+
+    static struct Fuzzer fuzzer;
+    unsigned int seconds = 60;
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned int instructions_per_frame = 0;
+    int extension = -1; // From the rom profile
+    const char *replay_name = NULL;
+
+    fuzzer.chunk_frames = 60;
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) seconds = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) jobs = strtol(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--chunk") == 0 && i + 1 < argc) fuzzer.chunk_frames = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--ipf") == 0 && i + 1 < argc) instructions_per_frame = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) fuzzer.output_directory = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) replay_name = argv[++i];
+        else if (strcmp(argv[i], "--extension") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "chip8") == 0) extension = CHIP8;
+            else if (strcmp(argv[i], "superchip") == 0) extension = SUPERCHIP;
+            else {
+                fprintf(stderr, "Unknown extension %s\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        }
+        else {
+            fputs(usage, stderr);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (fuzzer.chunk_frames == 0 || fuzzer.chunk_frames > FUZZER_MAX_CHUNK_FRAMES) {
+        fprintf(stderr, "Chunk must be 1 to %d frames\n", FUZZER_MAX_CHUNK_FRAMES);
+        return EXIT_FAILURE;
+    }
+    if (jobs < 1) jobs = 1;
+    if (jobs > FUZZER_MAX_JOBS) jobs = FUZZER_MAX_JOBS;
+
+    static struct EmulatedSystem boot;
+    if (!fuzzer_load_rom(&boot, argv[1], extension, instructions_per_frame)) return EXIT_FAILURE;
+    if (replay_name) return fuzzer_replay(&boot, replay_name) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (fuzzer.output_directory && mkdir(fuzzer.output_directory, 0755) != 0 && access(fuzzer.output_directory, W_OK) != 0) {
+        fprintf(stderr, "Could not create output directory %s\n", fuzzer.output_directory);
+        return EXIT_FAILURE;
+    }
+
+    fuzzer.emulate_decoded_instruction = emulated_system_core(&boot);
+    memset(fuzzer.virgin, UINT8_MAX, sizeof fuzzer.virgin);
+    pthread_mutex_init(&fuzzer.lock, NULL);
+
+    fuzzer.entry_capacity = 1024;
+    fuzzer.entries = malloc(fuzzer.entry_capacity * sizeof *fuzzer.entries);
+    fuzzer.entries[fuzzer.entry_count++] = fuzzer_entry_create(NULL, NULL, 0, &boot);
+
+    struct FuzzerWorker *workers = aligned_alloc(64, jobs * sizeof *workers);
+    if (!fuzzer.entries || !fuzzer.entries[0] || !workers) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    for (long i = 0; i < jobs; i++) {
+        workers[i] = (struct FuzzerWorker){ .fuzzer = &fuzzer, .random = 0x9E3779B97F4A7C15ull * (i + 1) };
+        if (pthread_create(&workers[i].thread, NULL, fuzzer_worker, &workers[i]) != 0) {
+            fprintf(stderr, "Could not start fuzzer thread\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("%s: %ld jobs, %u frames per run, %u instructions per frame\n", argv[1], jobs, fuzzer.chunk_frames, boot.instructions_per_frame);
+    printf("  %8s %12s %10s %8s %6s %6s %14s\n", "time", "execs", "execs/s", "entries", "edges", "stops", "deepest frames");
+
+    // Coverage growth, a line per second
+    const uint64_t start = fuzzer_now_ns();
+    uint64_t last_exec_count = 0, last_report = start;
+
+    for (unsigned int second = 1; second <= seconds; second++) {
+        const uint64_t wake = start + second * 1000000000ull;
+        for (uint64_t now = fuzzer_now_ns(); now < wake; now = fuzzer_now_ns())
+            nanosleep(&(struct timespec){ .tv_sec = (wake - now) / 1000000000ull, .tv_nsec = (wake - now) % 1000000000ull }, NULL);
+
+        const uint64_t now = fuzzer_now_ns();
+        const uint64_t exec_count = atomic_load(&fuzzer.exec_count);
+
+        pthread_mutex_lock(&fuzzer.lock);
+        printf("  %7us %12llu %10.0f %8zu %6u %6llu %14u\n", second, (long long unsigned)exec_count,
+               (exec_count - last_exec_count) * 1e9 / (now - last_report), fuzzer.entry_count, fuzzer.edge_count,
+               (long long unsigned)fuzzer.stop_count, fuzzer.deepest_frames);
+        pthread_mutex_unlock(&fuzzer.lock);
+        fflush(stdout);
+
+        last_exec_count = exec_count;
+        last_report = now;
+    }
+
+    atomic_store(&fuzzer.is_stopping, true);
+    for (long i = 0; i < jobs; i++) pthread_join(workers[i].thread, NULL);
+
+    for (size_t i = 0; i < fuzzer.entry_count; i++) free(fuzzer.entries[i]);
+    free(fuzzer.entries);
+    free(workers);
+    pthread_mutex_destroy(&fuzzer.lock);
+    return EXIT_SUCCESS;
+}
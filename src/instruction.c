@@ -1,5 +1,7 @@
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
 
 #include "instruction.h"
 
@@ -33,32 +35,163 @@ const struct InstructionMnemonic instruction_mnemonics[] = {
     {.type = INVALID}, // Must terminate with this
 };
 
+// Operands layout each type is written with, skips take either of the first two
+static bool instruction_type_accepts_layout(enum DecodedInstructionType type, int operands_layout) {
+    switch (type) {
+        case CLEAR:
+        case RETURN:
+            return operands_layout == NONE;
+        case JUMP:
+        case SUBROUTINE:
+        case ADDRESS_TO_REGISTER_I:
+        case JUMP_WITH_OFFSET:
+            return operands_layout == ADDRESS;
+        case IF_EQUAL_THEN_SKIP:
+        case IF_NOT_EQUAL_THEN_SKIP:
+            return operands_layout == REGISTER_AND_VALUE || operands_layout == REGISTERS_AND_HALF_VALUE;
+        case VALUE_TO_REGISTER:
+        case SUM_REGISTER:
+        case RANDOM_NUMBER_TO_REGISTER:
+        case IF_PRESSED_THEN_SKIP:
+        case IF_NOT_PRESSED_THEN_SKIP:
+        case MISC:
+            return operands_layout == REGISTER_AND_VALUE;
+        case REGISTER_TO_REGISTER:
+        case OR_REGISTERS:
+        case AND_REGISTERS:
+        case XOR_REGISTERS:
+        case SUM_REGISTERS:
+        case SUBTRACT_REGISTERS:
+        case SHIFT_RIGHT_REGISTER:
+        case INVERT_SUBTRACT_REGISTERS:
+        case SHIFT_LEFT_REGISTER:
+        case DRAW:
+            return operands_layout == REGISTERS_AND_HALF_VALUE;
+        case INVALID:
+        default:
+            return false;
+    }
+}
+
+static enum DecodedInstructionType instruction_type_from_mnemonic(const char *mnemonic, int operands_layout) {
+    for (int i = 0; instruction_mnemonics[i].type != INVALID; i++) {
+        if (strcmp(mnemonic, instruction_mnemonics[i].name) == 0 && instruction_type_accepts_layout(instruction_mnemonics[i].type, operands_layout))
+            return instruction_mnemonics[i].type;
+    }
+    return INVALID;
+}
+
+static const char *instruction_skip_spaces(const char *string) {
+    while (*string == ' ' || *string == '\t') string++;
+    return string;
+}
+
+// V followed by one hex digit (VA) or by a decimal index (V10, as instruction_decoded_sprint writes it)
+static const char *instruction_parse_register(const char *string, uint8_t *register_index) {
+    if (*string != 'V' && *string != 'v') return NULL;
+    string++;
+
+    char *end;
+    const bool is_hex_digit = isxdigit((unsigned char)string[0]) && !isalnum((unsigned char)string[1]);
+    const unsigned long index = strtoul(string, &end, is_hex_digit ? 16 : 10);
+    if (end == string || isalnum((unsigned char)*end) || index > 0xF) return NULL;
+
+    *register_index = (uint8_t)index;
+    return end;
+}
+
 struct DecodedInstruction decoded_instruction_from_string(const char *string) {
     struct DecodedInstruction decoded_instruction = { .type = INVALID };
 
-    // Get type
+    // Get mnemonic
     char mnemonic[20] = {0};
+    size_t length = 0;
+    string = instruction_skip_spaces(string);
+    while (isalpha((unsigned char)*string) && length < sizeof mnemonic - 1) mnemonic[length++] = *string++;
+
+    // Operands: registers, I and numbers (decimal, or hex with 0x), separated by commas
+    enum { OPERAND_REGISTER, OPERAND_I, OPERAND_NUMBER } kinds[3] = {0};
+    unsigned long values[3] = {0};
+    int operand_count = 0;
+
+    for (string = instruction_skip_spaces(string); *string && *string != '\n' && *string != '\r' && *string != ';'; ) {
+        if (operand_count == 3 || (operand_count > 0 && *string++ != ',')) return decoded_instruction;
+        string = instruction_skip_spaces(string);
 
-    if (sscanf(string, "%s\n", mnemonic) == 1) {
+        uint8_t register_index;
+        const char *end = instruction_parse_register(string, &register_index);
+        if (end) {
+            kinds[operand_count] = OPERAND_REGISTER;
+            values[operand_count] = register_index;
+        }
+        else if ((*string == 'I' || *string == 'i') && !isalnum((unsigned char)string[1])) {
+            kinds[operand_count] = OPERAND_I;
+            end = string + 1;
+        }
+        else {
+            kinds[operand_count] = OPERAND_NUMBER;
+            values[operand_count] = strtoul(string, (char **)&end, 0);
+            if (end == string) return decoded_instruction;
+        }
+
+        operand_count++;
+        string = instruction_skip_spaces(end);
+    }
+
+    // Layout from the operands, the type from the mnemonic written with that layout (ld and jp have several)
+    bool is_jump_with_offset = false;
+
+    if (operand_count == 0) {
         decoded_instruction.operands_layout = NONE;
     }
-    else if (sscanf(string, "%s V%u, %u\n", mnemonic, (unsigned int*)&decoded_instruction.register_index, (unsigned int*)&decoded_instruction.value) == 3) {
-        decoded_instruction.operands_layout = REGISTER_AND_VALUE;
+    else if (operand_count == 1 && kinds[0] == OPERAND_NUMBER && values[0] <= 0xFFF) {
+        decoded_instruction.operands_layout = ADDRESS;
+        decoded_instruction.address = (uint16_t)values[0];
     }
-    else if (sscanf(string, "%s %x\n", mnemonic, (unsigned int*)&decoded_instruction.address) == 2) {
+    else if (operand_count == 2 && kinds[0] == OPERAND_I && kinds[1] == OPERAND_NUMBER && values[1] <= 0xFFF) {
         decoded_instruction.operands_layout = ADDRESS;
+        decoded_instruction.address = (uint16_t)values[1];
+        decoded_instruction.type = ADDRESS_TO_REGISTER_I;
+        return decoded_instruction;
+    }
+    else if (kinds[0] == OPERAND_REGISTER && (operand_count == 1 || (operand_count == 2 && kinds[1] == OPERAND_NUMBER))) {
+        // jp V0, address is BNNN, the rest are register and byte, a lone register (skp VX) has a 0 byte
+        const unsigned long value = (operand_count == 2) ? values[1] : 0;
+        is_jump_with_offset = strcmp(mnemonic, "jp") == 0 && values[0] == 0 && value <= 0xFFF;
+        if (!is_jump_with_offset && value > 0xFF) return decoded_instruction;
+
+        decoded_instruction.operands_layout = is_jump_with_offset ? ADDRESS : REGISTER_AND_VALUE;
+        if (is_jump_with_offset) decoded_instruction.address = (uint16_t)value;
+        else {
+            decoded_instruction.register_index = (uint8_t)values[0];
+            decoded_instruction.value = (uint8_t)value;
+        }
+    }
+    else if (operand_count >= 2 && kinds[0] == OPERAND_REGISTER && kinds[1] == OPERAND_REGISTER
+             && (operand_count == 2 || (kinds[2] == OPERAND_NUMBER && values[2] <= 0xF))) {
+        decoded_instruction.operands_layout = REGISTERS_AND_HALF_VALUE;
+        decoded_instruction.register_indexes[0] = (uint8_t)values[0];
+        decoded_instruction.register_indexes[1] = (uint8_t)values[1];
+        decoded_instruction.half_value = (operand_count == 3) ? (uint8_t)values[2] : 0;
     }
     else {
-        fprintf(stderr, "Line looks strange O_o\n");
         return decoded_instruction;
     }
 
-    for (int i=0; instruction_mnemonics[i].type != INVALID ; i++) {
-        if (strcmp(mnemonic, instruction_mnemonics[i].name) == 0)
-            decoded_instruction.type = instruction_mnemonics[i].type;
+    if (is_jump_with_offset) {
+        decoded_instruction.type = JUMP_WITH_OFFSET;
+        return decoded_instruction;
     }
 
-    // TODO: check for correctness of type and operands
+    decoded_instruction.type = instruction_type_from_mnemonic(mnemonic, decoded_instruction.operands_layout);
+
+    // A lone register also stands for VX, V0 (shr VX)
+    if (decoded_instruction.type == INVALID && operand_count == 1 && decoded_instruction.operands_layout == REGISTER_AND_VALUE) {
+        const uint8_t register_index = decoded_instruction.register_index;
+        decoded_instruction = (struct DecodedInstruction){ .operands_layout = REGISTERS_AND_HALF_VALUE };
+        decoded_instruction.register_indexes[0] = register_index;
+        decoded_instruction.type = instruction_type_from_mnemonic(mnemonic, REGISTERS_AND_HALF_VALUE);
+    }
 
     return decoded_instruction;
 }
@@ -211,21 +344,15 @@ uint16_t encoded_instruction_from_decoded_instruction(struct DecodedInstruction
     // Encode the operands (last 12 bits)
     switch (decoded_instruction.operands_layout) {
         case ADDRESS:
-            encoded_instruction = decoded_instruction.address;
+            encoded_instruction = decoded_instruction.address & 0x0FFF;
             break;
         case REGISTER_AND_VALUE:
-            encoded_instruction += decoded_instruction.register_index;
-            encoded_instruction <<= 4;
-            encoded_instruction += decoded_instruction.value;
-            encoded_instruction <<= 8;
+            encoded_instruction = (uint16_t)((decoded_instruction.register_index & 0xF) << 8 | decoded_instruction.value);
             break;
         case REGISTERS_AND_HALF_VALUE:
-            encoded_instruction += decoded_instruction.register_indexes[0];
-            encoded_instruction <<= 4;
-            encoded_instruction += decoded_instruction.register_indexes[1];
-            encoded_instruction <<= 4;
-            encoded_instruction += decoded_instruction.half_value;
-            encoded_instruction <<= 8;
+            encoded_instruction = (uint16_t)((decoded_instruction.register_indexes[0] & 0xF) << 8
+                                             | (decoded_instruction.register_indexes[1] & 0xF) << 4
+                                             | (decoded_instruction.half_value & 0xF));
             break;
         case NONE:
         default:
@@ -254,7 +381,7 @@ uint16_t encoded_instruction_from_decoded_instruction(struct DecodedInstruction
                     encoded_instruction |= 0x3000;
                     break;
                 case REGISTERS_AND_HALF_VALUE:
-                    encoded_instruction |= 0x5000;
+                    encoded_instruction = (encoded_instruction & 0x0FF0) | 0x5000;
                     break;
                 default:
                     return 0x0000;
@@ -267,7 +394,7 @@ uint16_t encoded_instruction_from_decoded_instruction(struct DecodedInstruction
                     encoded_instruction |= 0x4000;
                     break;
                 case REGISTERS_AND_HALF_VALUE:
-                    encoded_instruction |= 0x9000;
+                    encoded_instruction = (encoded_instruction & 0x0FF0) | 0x9000;
                     break;
                 default:
                     return 0x0000;
@@ -280,17 +407,16 @@ uint16_t encoded_instruction_from_decoded_instruction(struct DecodedInstruction
         case SUM_REGISTER:
             encoded_instruction |= 0x7000;
             break;
-        case REGISTER_TO_REGISTER:
-        case OR_REGISTERS:
-        case AND_REGISTERS:
-        case XOR_REGISTERS:
-        case SUM_REGISTERS:
-        case SUBTRACT_REGISTERS:
-        case SHIFT_RIGHT_REGISTER:
-        case INVERT_SUBTRACT_REGISTERS:
-        case SHIFT_LEFT_REGISTER:
-            encoded_instruction |= 0x8000;
-            break;
+        // The lowest 4 bits pick the operation, whatever half_value holds
+        case REGISTER_TO_REGISTER: encoded_instruction = (encoded_instruction & 0x0FF0) | 0x8000; break;
+        case OR_REGISTERS: encoded_instruction = (encoded_instruction & 0x0FF0) | 0x8001; break;
+        case AND_REGISTERS: encoded_instruction = (encoded_instruction & 0x0FF0) | 0x8002; break;
+        case XOR_REGISTERS: encoded_instruction = (encoded_instruction & 0x0FF0) | 0x8003; break;
+        case SUM_REGISTERS: encoded_instruction = (encoded_instruction & 0x0FF0) | 0x8004; break;
+        case SUBTRACT_REGISTERS: encoded_instruction = (encoded_instruction & 0x0FF0) | 0x8005; break;
+        case SHIFT_RIGHT_REGISTER: encoded_instruction = (encoded_instruction & 0x0FF0) | 0x8006; break;
+        case INVERT_SUBTRACT_REGISTERS: encoded_instruction = (encoded_instruction & 0x0FF0) | 0x8007; break;
+        case SHIFT_LEFT_REGISTER: encoded_instruction = (encoded_instruction & 0x0FF0) | 0x800E; break;
         case ADDRESS_TO_REGISTER_I:
             encoded_instruction |= 0xA000;
             break;
@@ -303,9 +429,12 @@ uint16_t encoded_instruction_from_decoded_instruction(struct DecodedInstruction
         case DRAW:
             encoded_instruction |= 0xD000;
             break;
+        // Same for the lowest byte
         case IF_PRESSED_THEN_SKIP:
+            encoded_instruction = (encoded_instruction & 0x0F00) | 0xE09E;
+            break;
         case IF_NOT_PRESSED_THEN_SKIP:
-            encoded_instruction |= 0xE000;
+            encoded_instruction = (encoded_instruction & 0x0F00) | 0xE0A1;
             break;
         case MISC:
             encoded_instruction |= 0xF000;
@@ -0,0 +1,370 @@
+// Ahead of time recompiler: turns the code recovered from a rom into C, a label per basic block,
+// to be built against the core library (recompiled.h) into a native executable
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "instruction.h"
+#include "program_analysis.h"
+
+static const uint16_t rom_load_address = 0x200; // CHIP8 roms are loaded to 0x200
+
+struct Recompiler {
+    const char *input_filename;
+    const char *output_filename;
+    enum { RECOMPILER_CHIP8, RECOMPILER_SUPERCHIP } quirks; // Same order as EmulatedSystem.extension
+    FILE *output;
+
+    const struct ProgramAnalysis *analysis;
+    uint16_t block_starting_at[PROGRAM_ANALYSIS_MEMORY_SIZE]; // Index of the block starting at each address
+    unsigned int inline_instructions;
+    unsigned int runtime_instructions; // Left to recompiled_runtime_emulate
+};
+
+static const char *const usage =
+    "Usage: tracua-chip8-recompiler [--extension chip8|superchip] [--output <output_filename.c>] <input_filename>\n";
+
+static bool consume_command_line_arguments(struct Recompiler *recompiler, int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            recompiler->output_filename = argv[++i];
+        }
+        else if (strcmp(argv[i], "--extension") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "chip8") == 0) recompiler->quirks = RECOMPILER_CHIP8;
+            else if (strcmp(argv[i], "superchip") == 0) recompiler->quirks = RECOMPILER_SUPERCHIP;
+            else {
+                fprintf(stderr, "Unknown extension %s\n", argv[i]);
+                return false;
+            }
+        }
+        else recompiler->input_filename = argv[i];
+    }
+
+    if (!recompiler->input_filename) {
+        fputs(usage, stderr);
+        return false;
+    }
+
+    return true;
+}
+
+// Continues at address: straight to its block when recompiled, back to the runtime otherwise
+static void recompiler_emit_goto(struct Recompiler *recompiler, uint32_t address) {
+    if (address < PROGRAM_ANALYSIS_MEMORY_SIZE && recompiler->block_starting_at[address] != PROGRAM_ANALYSIS_NO_BLOCK)
+        fprintf(recompiler->output, "goto block_0x%03x;", address);
+    else
+        fprintf(recompiler->output, "{ PC = 0x%03x; goto leave; }", address);
+}
+
+// Hands the instruction to the interpreter, registers go through emulated_system around the call
+static void recompiler_emit_runtime_call(struct Recompiler *recompiler, uint16_t address, unsigned int instructions_after) {
+    fprintf(recompiler->output,
+            "    RECOMPILED_STORE();\n"
+            "    if (!recompiled_runtime_emulate(runtime, emulated_system, 0x%03x)) { RECOMPILED_LOAD(); executed -= %u; PC = emulated_system->PC; goto leave; }\n"
+            "    RECOMPILED_LOAD();\n",
+            address, instructions_after);
+    recompiler->runtime_instructions++;
+}
+
+// Fx65, unrolled
+static void recompiler_emit_load_registers(struct Recompiler *recompiler, uint8_t last) {
+    for (uint8_t i = 0; i <= last; i++) {
+        if (recompiler->quirks == RECOMPILER_CHIP8)
+            fprintf(recompiler->output, "    V[0x%X] = emulated_system->ram[I++ & 0xFFF];\n", i);
+        else
+            fprintf(recompiler->output, "    V[0x%X] = emulated_system->ram[(I + %u) & 0xFFF];\n", i, i);
+    }
+}
+
+// Emits one instruction, mirroring core.c for the quirks being recompiled for
+static void recompiler_emit_instruction(struct Recompiler *recompiler, uint16_t address, unsigned int instructions_after) {
+    FILE *output = recompiler->output;
+    const uint16_t encoded_instruction = program_analysis_encoded_instruction_at(recompiler->analysis, address);
+    const struct DecodedInstruction decoded_instruction = decoded_instruction_from_encoded_instruction(encoded_instruction);
+    const bool has_quirks = recompiler->quirks == RECOMPILER_CHIP8;
+    const uint8_t x = decoded_instruction.register_indexes[0], y = decoded_instruction.register_indexes[1];
+    const uint8_t kk = decoded_instruction.value;
+    const uint16_t nnn = decoded_instruction.address;
+
+    fprintf(output, "    // 0x%03x: %04x\n", address, encoded_instruction);
+    recompiler->inline_instructions++;
+
+    switch (decoded_instruction.type) {
+        case CLEAR:
+            fprintf(output, "    memset(emulated_system->display, 0, sizeof emulated_system->display);\n");
+            break;
+        case JUMP:
+            fprintf(output, "    ");
+            recompiler_emit_goto(recompiler, nnn);
+            fprintf(output, "\n");
+            break;
+        case RETURN:
+            // An empty stack is left to the interpreter, which fails the same way as always
+            fprintf(output, "    if (emulated_system->SP == 0) { executed -= 1; PC = 0x%03x; goto leave; }\n", address);
+            fprintf(output, "    PC = emulated_system->stack[--emulated_system->SP];\n    goto dispatch;\n");
+            break;
+        case SUBROUTINE:
+            fprintf(output, "    if (emulated_system->SP >= STACK_SIZE) { executed -= 1; PC = 0x%03x; goto leave; }\n", address);
+            fprintf(output, "    emulated_system->stack[emulated_system->SP++] = 0x%03x;\n    ", address + 2);
+            recompiler_emit_goto(recompiler, nnn);
+            fprintf(output, "\n");
+            break;
+        case IF_EQUAL_THEN_SKIP:
+        case IF_NOT_EQUAL_THEN_SKIP:
+            if (decoded_instruction.operands_layout == REGISTER_AND_VALUE)
+                fprintf(output, "    if (V[0x%X] %s 0x%02x) ", decoded_instruction.register_index, (decoded_instruction.type == IF_EQUAL_THEN_SKIP) ? "==" : "!=", kk);
+            else
+                fprintf(output, "    if (V[0x%X] %s V[0x%X]) ", x, (decoded_instruction.type == IF_EQUAL_THEN_SKIP) ? "==" : "!=", y);
+            recompiler_emit_goto(recompiler, address + 4);
+            fprintf(output, "\n    ");
+            recompiler_emit_goto(recompiler, address + 2);
+            fprintf(output, "\n");
+            break;
+        case IF_PRESSED_THEN_SKIP:
+        case IF_NOT_PRESSED_THEN_SKIP:
+            fprintf(output, "    key = 1u << (V[0x%X] & 0x0F);\n", decoded_instruction.register_index);
+            fprintf(output, "    emulated_system->keypad_observed |= key;\n");
+            fprintf(output, "    if (%s(emulated_system->keypad & key)) ", (decoded_instruction.type == IF_PRESSED_THEN_SKIP) ? "" : "!");
+            recompiler_emit_goto(recompiler, address + 4);
+            fprintf(output, "\n    ");
+            recompiler_emit_goto(recompiler, address + 2);
+            fprintf(output, "\n");
+            break;
+        case VALUE_TO_REGISTER:
+            fprintf(output, "    V[0x%X] = 0x%02x;\n", decoded_instruction.register_index, kk);
+            break;
+        case SUM_REGISTER:
+            fprintf(output, "    V[0x%X] += 0x%02x;\n", decoded_instruction.register_index, kk);
+            break;
+        case REGISTER_TO_REGISTER:
+            fprintf(output, "    V[0x%X] = V[0x%X];\n", x, y);
+            break;
+        case OR_REGISTERS:
+        case AND_REGISTERS:
+        case XOR_REGISTERS: {
+            const char operator = (decoded_instruction.type == OR_REGISTERS) ? '|' : (decoded_instruction.type == AND_REGISTERS) ? '&' : '^';
+            fprintf(output, "    V[0x%X] %c= V[0x%X];\n", x, operator, y);
+            if (has_quirks) fprintf(output, "    V[0xF] = 0;\n");
+            break;
+        }
+        case SUM_REGISTERS:
+            fprintf(output, "    result = V[0x%X] + V[0x%X];\n    V[0x%X] = result & 0xFF;\n    V[0xF] = result > 255;\n", x, y, x);
+            break;
+        case SUBTRACT_REGISTERS:
+            fprintf(output, "    flag = V[0x%X] >= V[0x%X];\n    V[0x%X] = V[0x%X] - V[0x%X];\n    V[0xF] = flag;\n", x, y, x, x, y);
+            break;
+        case INVERT_SUBTRACT_REGISTERS:
+            fprintf(output, "    flag = V[0x%X] >= V[0x%X];\n    V[0x%X] = V[0x%X] - V[0x%X];\n    V[0xF] = flag;\n", y, x, x, y, x);
+            break;
+        case SHIFT_RIGHT_REGISTER:
+            if (has_quirks) fprintf(output, "    V[0xF] = V[0x%X] & 1;\n    V[0x%X] = V[0x%X] >> 1;\n", y, x, y);
+            else fprintf(output, "    V[0xF] = V[0x%X] & 1;\n    V[0x%X] >>= 1;\n", x, x);
+            break;
+        case SHIFT_LEFT_REGISTER:
+            if (has_quirks) fprintf(output, "    V[0xF] = (V[0x%X] & 0x80) >> 7;\n    V[0x%X] = V[0x%X] << 1;\n", y, x, y);
+            else fprintf(output, "    V[0xF] = (V[0x%X] & 0x80) >> 7;\n    V[0x%X] <<= 1;\n", x, x);
+            break;
+        case ADDRESS_TO_REGISTER_I:
+            fprintf(output, "    I = 0x%03x;\n", nnn);
+            break;
+        case JUMP_WITH_OFFSET:
+            // Target only known at run time, the dispatch switch finds its block or leaves it to the interpreter
+            fprintf(output, "    PC = V[0x0] + 0x%03x;\n    goto dispatch;\n", nnn);
+            break;
+        case RANDOM_NUMBER_TO_REGISTER:
+            fprintf(output, "    V[0x%X] = (rand() %% 256) & 0x%02x;\n", decoded_instruction.register_index, kk);
+            break;
+        case MISC:
+            switch (kk) {
+                case 0x07:
+                    fprintf(output, "    emulated_system->delay_timer_read_count++;\n    V[0x%X] = emulated_system->delay_timer;\n", decoded_instruction.register_index);
+                    break;
+                case 0x15:
+                    fprintf(output, "    emulated_system->delay_timer = V[0x%X];\n", decoded_instruction.register_index);
+                    break;
+                case 0x18:
+                    fprintf(output, "    emulated_system->sound_timer = V[0x%X];\n", decoded_instruction.register_index);
+                    break;
+                case 0x1E:
+                    fprintf(output, "    I += V[0x%X];\n", decoded_instruction.register_index);
+                    break;
+                case 0x29:
+                    fprintf(output, "    I = V[0x%X] * 5;\n", decoded_instruction.register_index);
+                    break;
+                case 0x65:
+                    recompiler_emit_load_registers(recompiler, decoded_instruction.register_index);
+                    break;
+                case 0x0A: // May stay on itself
+                case 0x33: // Stores may overwrite code
+                case 0x55:
+                    recompiler->inline_instructions--;
+                    recompiler_emit_runtime_call(recompiler, address, instructions_after);
+                    break;
+                default:
+                    break; // No effect
+            }
+            break;
+        case DRAW:
+        case INVALID:
+        default:
+            recompiler->inline_instructions--;
+            recompiler_emit_runtime_call(recompiler, address, instructions_after);
+            break;
+    }
+}
+
+static bool recompiler_ends_block(enum DecodedInstructionType type) {
+    switch (type) {
+        case JUMP:
+        case RETURN:
+        case SUBROUTINE:
+        case IF_EQUAL_THEN_SKIP:
+        case IF_NOT_EQUAL_THEN_SKIP:
+        case IF_PRESSED_THEN_SKIP:
+        case IF_NOT_PRESSED_THEN_SKIP:
+        case JUMP_WITH_OFFSET:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void recompiler_emit_block(struct Recompiler *recompiler, uint16_t block_index) {
+    const struct ProgramAnalysisBlock *block = &recompiler->analysis->blocks[block_index];
+    const unsigned int length = (block->end - block->start) / 2;
+
+    // The budget is checked once per block, so a frame can't end in the middle of one
+    fprintf(recompiler->output, "\nblock_0x%03x:\n", block->start);
+    fprintf(recompiler->output, "    if (runtime->is_disabled[%u] || budget - executed < %u) { PC = 0x%03x; goto leave; }\n", block_index, length, block->start);
+    fprintf(recompiler->output, "    executed += %u;\n", length);
+
+    uint16_t address = block->start;
+    for (unsigned int i = 0; i < length; i++, address += 2) recompiler_emit_instruction(recompiler, address, length - i - 1);
+
+    const uint16_t last_instruction = program_analysis_encoded_instruction_at(recompiler->analysis, block->end - 2);
+    if (!recompiler_ends_block(decoded_instruction_from_encoded_instruction(last_instruction).type)) {
+        fprintf(recompiler->output, "    ");
+        recompiler_emit_goto(recompiler, block->end);
+        fprintf(recompiler->output, "\n");
+    }
+}
+
+static void recompiler_emit(struct Recompiler *recompiler) {
+    const struct ProgramAnalysis *analysis = recompiler->analysis;
+    FILE *output = recompiler->output;
+    bool has_dispatch = false;
+
+    for (uint16_t i = 0; i < analysis->block_count; i++) {
+        const enum ProgramAnalysisTerminator terminator = analysis->blocks[i].terminator;
+        if (terminator == TERMINATOR_RETURN || terminator == TERMINATOR_INDIRECT) has_dispatch = true;
+    }
+
+    fprintf(output, "// Recompiled from %s by tracua-chip8-recompiler, do not edit\n", recompiler->input_filename);
+    fprintf(output, "// Build against the core library: cc -O2 -I include <this file> libtracua-chip8.a\n\n");
+    fprintf(output, "#include <stdlib.h>\n#include <string.h>\n\n#include \"recompiled.h\"\n\n");
+
+    fprintf(output, "static const uint8_t recompiled_rom[] = {");
+    for (uint32_t address = analysis->load_address; address < analysis->rom_end; address++)
+        fprintf(output, "%s0x%02x,", ((address - analysis->load_address) % 16 == 0) ? "\n    " : " ", analysis->memory[address]);
+    fprintf(output, "\n};\n\n");
+
+    fprintf(output, "static const uint16_t recompiled_blocks[][2] = {\n");
+    for (uint16_t i = 0; i < analysis->block_count; i++)
+        fprintf(output, "    {0x%03x, 0x%03x},\n", analysis->blocks[i].start, analysis->blocks[i].end);
+    fprintf(output, "};\n\n");
+
+    fprintf(output,
+            "// Registers stay in locals while recompiled code runs\n"
+            "#define RECOMPILED_STORE() (memcpy(emulated_system->V, V, sizeof V), emulated_system->I = I)\n"
+            "#define RECOMPILED_LOAD() (memcpy(V, emulated_system->V, sizeof V), I = emulated_system->I)\n\n");
+
+    fprintf(output,
+            "static unsigned int recompiled_run(struct RecompiledRuntime *runtime, struct EmulatedSystem *emulated_system, unsigned int budget) {\n"
+            "    uint8_t V[16];\n"
+            "    uint16_t I;\n"
+            "    uint16_t PC = emulated_system->PC;\n"
+            "    unsigned int executed = 0;\n"
+            "    uint16_t result, key;\n"
+            "    uint8_t flag;\n"
+            "    (void)result; (void)key; (void)flag;\n"
+            "    RECOMPILED_LOAD();\n\n");
+
+    fprintf(output, "%s    switch (PC) {\n", has_dispatch ? "dispatch:\n" : "");
+    for (uint16_t i = 0; i < analysis->block_count; i++)
+        fprintf(output, "        case 0x%03x: goto block_0x%03x;\n", analysis->blocks[i].start, analysis->blocks[i].start);
+    fprintf(output, "        default: goto leave;\n    }\n");
+
+    for (uint16_t i = 0; i < analysis->block_count; i++) recompiler_emit_block(recompiler, i);
+
+    fprintf(output,
+            "\nleave:\n"
+            "    RECOMPILED_STORE();\n"
+            "    emulated_system->PC = PC;\n"
+            "    return executed;\n"
+            "}\n\n");
+
+    fprintf(output,
+            "const struct RecompiledProgram recompiled_program = {\n"
+            "    .rom_name = \"%s\",\n"
+            "    .rom = recompiled_rom,\n"
+            "    .rom_size = sizeof recompiled_rom,\n"
+            "    .extension = %d,\n"
+            "    .blocks = recompiled_blocks,\n"
+            "    .block_count = sizeof recompiled_blocks / sizeof recompiled_blocks[0],\n"
+            "    .run = recompiled_run,\n"
+            "};\n\n",
+            recompiler->input_filename, recompiler->quirks);
+
+    fprintf(output,
+            "#ifndef RECOMPILED_NO_MAIN\n"
+            "int main(int argc, char **argv) {\n"
+            "    return recompiled_main(&recompiled_program, argc, argv);\n"
+            "}\n"
+            "#endif\n");
+}
+
+int main(int argc, char **argv) {
+    struct Recompiler recompiler = {0};
+
+    if (!consume_command_line_arguments(&recompiler, argc, argv)) return EXIT_FAILURE;
+
+    const size_t max_size = PROGRAM_ANALYSIS_MEMORY_SIZE - rom_load_address;
+    uint8_t rom[PROGRAM_ANALYSIS_MEMORY_SIZE];
+
+    FILE *input_file = fopen(recompiler.input_filename, "rb");
+    if (!input_file) {
+        fprintf(stderr, "Rom file %s is invalid or does not exist\n", recompiler.input_filename);
+        return EXIT_FAILURE;
+    }
+
+    const size_t rom_size = fread(rom, 1, max_size, input_file);
+    fclose(input_file);
+
+    if (rom_size == 0) {
+        fprintf(stderr, "Rom file %s is empty\n", recompiler.input_filename);
+        return EXIT_FAILURE;
+    }
+
+    static struct ProgramAnalysis analysis;
+    program_analysis_run(&analysis, rom, rom_size, rom_load_address);
+    recompiler.analysis = &analysis;
+
+    memset(recompiler.block_starting_at, 0xFF, sizeof recompiler.block_starting_at);
+    for (uint16_t i = 0; i < analysis.block_count; i++) recompiler.block_starting_at[analysis.blocks[i].start] = i;
+
+    recompiler.output = stdout;
+    if (recompiler.output_filename && !(recompiler.output = fopen(recompiler.output_filename, "w"))) {
+        fprintf(stderr, "Could not open output file %s\n", recompiler.output_filename);
+        return EXIT_FAILURE;
+    }
+
+    recompiler_emit(&recompiler);
+    if (recompiler.output != stdout) fclose(recompiler.output);
+
+    fprintf(stderr, "Blocks: %u, instructions inline: %u, through the interpreter: %u, data bytes: %u\n",
+            analysis.block_count, recompiler.inline_instructions, recompiler.runtime_instructions, analysis.data_bytes);
+    return EXIT_SUCCESS;
+}
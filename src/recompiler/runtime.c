@@ -0,0 +1,168 @@
+// Runtime linked into roms recompiled by tracua-chip8-recompiler: interpreter fallback and a headless driver
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "recompiled.h"
+#include "rom_hash.h"
+
+// Disables every block holding a byte that no longer matches the image it was recompiled from
+static bool recompiled_runtime_note_store(struct RecompiledRuntime *runtime, struct EmulatedSystem *emulated_system, uint16_t address, unsigned int length) {
+    const struct RecompiledProgram *program = runtime->program;
+    bool is_code_overwritten = false;
+
+    for (unsigned int i = 0; i < length; i++) {
+        const uint16_t written = (address + i) & 0xFFF;
+        if (!runtime->is_code[written] || emulated_system->ram[written] == program->rom[written - emulated_system_entry_point]) continue;
+
+        is_code_overwritten = true;
+        for (uint16_t block = 0; block < program->block_count; block++) {
+            if (program->blocks[block][0] <= written && written < program->blocks[block][1]) runtime->is_disabled[block] = true;
+        }
+    }
+
+    return is_code_overwritten;
+}
+
+// One instruction at PC through the interpreter, returns whether it overwrote recompiled code
+static bool recompiled_runtime_interpret(struct RecompiledRuntime *runtime, struct EmulatedSystem *emulated_system) {
+    const uint16_t I = emulated_system->I; // Stores start at I before the instruction moves it
+
+    if (!emulated_system_consume_instruction(emulated_system)) return false;
+    runtime->core(emulated_system);
+
+    switch (emulated_system->encoded_instruction & 0xF0FF) {
+        case 0xF033: return recompiled_runtime_note_store(runtime, emulated_system, I, 3);
+        case 0xF055: return recompiled_runtime_note_store(runtime, emulated_system, I, emulated_system->decoded_instruction.register_index + 1);
+        default: return false;
+    }
+}
+
+void recompiled_runtime_initialize(struct RecompiledRuntime *runtime, const struct RecompiledProgram *program, struct EmulatedSystem *emulated_system) {
+    emulated_system_initialize(emulated_system);
+    emulated_system->extension = program->extension;
+    emulated_system->rom_name = program->rom_name;
+    memcpy(&emulated_system->ram[emulated_system_entry_point], program->rom, program->rom_size);
+
+    memset(runtime, 0, sizeof(struct RecompiledRuntime));
+    runtime->program = program;
+    runtime->core = emulated_system_core(emulated_system);
+
+    for (uint16_t block = 0; block < program->block_count; block++) {
+        for (uint16_t address = program->blocks[block][0]; address < program->blocks[block][1]; address++) runtime->is_code[address] = true;
+    }
+}
+
+void recompiled_runtime_run(struct RecompiledRuntime *runtime, struct EmulatedSystem *emulated_system, unsigned int count) {
+    unsigned int executed = 0;
+
+    while (executed < count && emulated_system->state == RUNNING) {
+        const unsigned int recompiled = runtime->program->run(runtime, emulated_system, count - executed);
+        executed += recompiled;
+        runtime->recompiled_instructions += recompiled;
+
+        // PC left the recompiled code, or too few instructions are left for the next block
+        if (executed < count && emulated_system->state == RUNNING) {
+            recompiled_runtime_interpret(runtime, emulated_system);
+            executed++;
+            runtime->interpreted_instructions++;
+        }
+    }
+}
+
+bool recompiled_runtime_emulate(struct RecompiledRuntime *runtime, struct EmulatedSystem *emulated_system, uint16_t address) {
+    emulated_system->PC = address;
+    const bool is_code_overwritten = recompiled_runtime_interpret(runtime, emulated_system);
+
+    return !is_code_overwritten && emulated_system->state == RUNNING && emulated_system->PC == address + 2;
+}
+
+static uint64_t recompiled_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+static void recompiled_tick_timers(struct EmulatedSystem *emulated_system) {
+    if (emulated_system->delay_timer > 0) emulated_system->delay_timer--;
+    if (emulated_system->sound_timer > 0) emulated_system->sound_timer--;
+}
+
+static bool recompiled_same_state(const struct EmulatedSystem *a, const struct EmulatedSystem *b) {
+    return a->state == b->state && a->PC == b->PC && a->I == b->I && a->SP == b->SP
+        && a->delay_timer == b->delay_timer && a->sound_timer == b->sound_timer
+        && a->draw_count == b->draw_count && a->delay_timer_read_count == b->delay_timer_read_count
+        && memcmp(a->V, b->V, sizeof a->V) == 0 && memcmp(a->stack, b->stack, sizeof a->stack) == 0
+        && memcmp(a->ram, b->ram, sizeof a->ram) == 0 && memcmp(a->display, b->display, sizeof a->display) == 0;
+}
+
+static const char *const recompiled_usage = "Usage: %s [--frames <count>] [--ipf <count>] [--compare]\n"
+    "  --compare also runs the rom through the interpreter, reports both speeds and fails if they end apart\n";
+
+int recompiled_main(const struct RecompiledProgram *program, int argc, char **argv) {
+    uint64_t frames = 600;
+    unsigned int instructions_per_frame = 0; // 0 keeps the default
+    bool should_compare = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) frames = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--ipf") == 0 && i + 1 < argc) instructions_per_frame = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--compare") == 0) should_compare = true;
+        else {
+            fprintf(stderr, recompiled_usage, argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    static struct EmulatedSystem recompiled, interpreted;
+    static struct RecompiledRuntime runtime;
+
+    recompiled_runtime_initialize(&runtime, program, &recompiled);
+    if (instructions_per_frame) recompiled.instructions_per_frame = instructions_per_frame;
+
+    // Same rand() sequence for both runs, CXKK draws from it
+    srand(1);
+    uint64_t start = recompiled_now_ns();
+    uint64_t frame = 0;
+    for (; frame < frames && recompiled.state == RUNNING; frame++) {
+        recompiled_runtime_run(&runtime, &recompiled, recompiled.instructions_per_frame);
+        recompiled_tick_timers(&recompiled);
+    }
+    const double recompiled_seconds = (recompiled_now_ns() - start) / 1e9;
+    const uint64_t recompiled_executed = runtime.recompiled_instructions + runtime.interpreted_instructions;
+
+    printf("%s: %llu frames, %llu instructions, %.1f%% recompiled, display %016llx\n",
+           program->rom_name, (unsigned long long)frame, (unsigned long long)recompiled_executed,
+           recompiled_executed ? 100.0 * runtime.recompiled_instructions / recompiled_executed : 0.0,
+           (unsigned long long)rom_hash((const uint8_t *)recompiled.display, sizeof recompiled.display));
+
+    if (!should_compare) return EXIT_SUCCESS;
+
+    emulated_system_initialize(&interpreted);
+    interpreted.extension = program->extension;
+    interpreted.instructions_per_frame = recompiled.instructions_per_frame;
+    memcpy(&interpreted.ram[emulated_system_entry_point], program->rom, program->rom_size);
+    const EmulatedSystemCore emulate_decoded_instruction = emulated_system_core(&interpreted);
+    uint64_t interpreted_executed = 0;
+
+    srand(1);
+    start = recompiled_now_ns();
+    for (uint64_t i = 0; i < frames && interpreted.state == RUNNING; i++) {
+        for (unsigned int j = 0; j < interpreted.instructions_per_frame && interpreted.state == RUNNING; j++) {
+            if (!emulated_system_consume_instruction(&interpreted)) break;
+            emulate_decoded_instruction(&interpreted);
+            interpreted_executed++;
+        }
+        recompiled_tick_timers(&interpreted);
+    }
+    const double interpreted_seconds = (recompiled_now_ns() - start) / 1e9;
+
+    const bool matches = interpreted_executed == recompiled_executed && recompiled_same_state(&recompiled, &interpreted);
+    printf("  %-12s %8.2f MIPS\n", "interpreted", interpreted_executed / interpreted_seconds / 1e6);
+    printf("  %-12s %8.2f MIPS  %.2fx\n", "recompiled", recompiled_executed / recompiled_seconds / 1e6, interpreted_seconds / recompiled_seconds);
+    printf("  %s\n", matches ? "same final state" : "FINAL STATE DIFFERS");
+
+    return matches ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,250 @@
+// Builds and lists rom libraries, see include/rom_library.h for the format
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "rom_hash.h"
+#include "rom_library.h"
+
+#define ROMLIB_MAX_ROM_SIZE (4096 - 0x200)
+
+static const char *const usage =
+    "Usage: %s build <library> <rom or directory>...\n"
+    "       %s list <library>\n";
+
+struct RomlibRom {
+    char *name;
+    uint8_t *data;
+    uint32_t size;
+    uint64_t hash;
+    uint64_t name_hash;
+    uint32_t entry_index; // Index of the first rom with the same content, after sorting
+};
+
+struct Romlib {
+    struct RomlibRom *roms;
+    size_t rom_count;
+    size_t rom_capacity;
+};
+
+// name: how the rom is looked up, the path relative to the directory given on the command line
+static bool romlib_add_file(struct Romlib *romlib, const char *path, const char *name) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "Could not open %s\n", path);
+        return true; // Skipped, not fatal
+    }
+
+    uint8_t buffer[ROMLIB_MAX_ROM_SIZE + 1];
+    const size_t size = fread(buffer, 1, sizeof buffer, file);
+    fclose(file);
+
+    if (size == 0 || size > ROMLIB_MAX_ROM_SIZE) {
+        fprintf(stderr, "Skipping %s, not a rom (%llu bytes)\n", path, (long long unsigned)size);
+        return true;
+    }
+
+    if (romlib->rom_count == romlib->rom_capacity) {
+        const size_t capacity = romlib->rom_capacity ? romlib->rom_capacity * 2 : 1024;
+        struct RomlibRom *roms = realloc(romlib->roms, capacity * sizeof(struct RomlibRom));
+        if (!roms) return false;
+
+        romlib->roms = roms;
+        romlib->rom_capacity = capacity;
+    }
+
+    struct RomlibRom *rom = &romlib->roms[romlib->rom_count];
+    *rom = (struct RomlibRom){
+        .name = strdup(name),
+        .data = malloc(size),
+        .size = size,
+        .hash = rom_hash(buffer, size),
+        .name_hash = rom_hash((const uint8_t *)name, strlen(name)),
+    };
+    if (!rom->name || !rom->data) return false;
+
+    memcpy(rom->data, buffer, size);
+    romlib->rom_count++;
+    return true;
+}
+
+// Recursively collects regular files, names start at name_offset in their path.
+// Links to files are collected, links to directories are only followed when given directly, one found inside could lead back up.
+static bool romlib_collect(struct Romlib *romlib, const char *path, size_t name_offset) {
+    struct stat file_status;
+    if (stat(path, &file_status) != 0) {
+        fprintf(stderr, "Could not open %s\n", path);
+        return true;
+    }
+    if (!S_ISDIR(file_status.st_mode)) return S_ISREG(file_status.st_mode) ? romlib_add_file(romlib, path, &path[name_offset]) : true;
+
+    DIR *directory = opendir(path);
+    if (!directory) {
+        fprintf(stderr, "Could not open directory %s\n", path);
+        return true;
+    }
+
+    struct dirent *directory_entry;
+    char child_path[4096];
+
+    while ((directory_entry = readdir(directory)) != NULL) {
+        if (strcmp(directory_entry->d_name, ".") == 0 || strcmp(directory_entry->d_name, "..") == 0) continue;
+
+        const bool has_separator = path[strlen(path) - 1] == '/';
+        snprintf(child_path, sizeof child_path, has_separator ? "%s%s" : "%s/%s", path, directory_entry->d_name);
+
+        if (lstat(child_path, &file_status) == 0 && S_ISLNK(file_status.st_mode)
+            && stat(child_path, &file_status) == 0 && S_ISDIR(file_status.st_mode)) continue;
+
+        if (!romlib_collect(romlib, child_path, name_offset)) {
+            closedir(directory);
+            return false;
+        }
+    }
+
+    closedir(directory);
+    return true;
+}
+
+static int romlib_compare_hash(const void *a, const void *b) {
+    const struct RomlibRom *rom_a = a, *rom_b = b;
+    if (rom_a->hash != rom_b->hash) return (rom_a->hash < rom_b->hash) ? -1 : 1;
+    return strcmp(rom_a->name, rom_b->name);
+}
+
+static int romlib_compare_name(const void *a, const void *b) {
+    const struct RomLibraryName *name_a = a, *name_b = b;
+    if (name_a->name_hash != name_b->name_hash) return (name_a->name_hash < name_b->name_hash) ? -1 : 1;
+    return (name_a->string_offset > name_b->string_offset) - (name_a->string_offset < name_b->string_offset);
+}
+
+static bool romlib_build(const char *library_filename, char **paths, int path_count) {
+    struct Romlib romlib = {0};
+
+    for (int i = 0; i < path_count; i++) {
+        struct stat file_status;
+        const char *base_name = strrchr(paths[i], '/') ? strrchr(paths[i], '/') + 1 : paths[i];
+
+        // Files given directly are named by their base name, files found in a directory by their path inside it
+        const size_t name_offset = (stat(paths[i], &file_status) == 0 && S_ISDIR(file_status.st_mode))
+            ? strlen(paths[i]) + (paths[i][strlen(paths[i]) - 1] != '/') // Skip the separator
+            : (size_t)(base_name - paths[i]);
+
+        if (!romlib_collect(&romlib, paths[i], name_offset)) {
+            fprintf(stderr, "Out of memory\n");
+            return false;
+        }
+    }
+
+    // Same content is stored once, every name points to it
+    qsort(romlib.roms, romlib.rom_count, sizeof(struct RomlibRom), romlib_compare_hash);
+
+    struct RomLibraryHeader header = { .magic = ROM_LIBRARY_MAGIC, .version = ROM_LIBRARY_VERSION };
+    struct RomLibraryEntry *entries = calloc(romlib.rom_count + 1, sizeof(struct RomLibraryEntry));
+    struct RomLibraryName *names = calloc(romlib.rom_count + 1, sizeof(struct RomLibraryName));
+    char *strings = NULL;
+    size_t strings_size = 0, data_size = 0;
+
+    for (size_t i = 0; i < romlib.rom_count; i++) strings_size += strlen(romlib.roms[i].name) + 1;
+    strings = malloc(strings_size + 1);
+
+    if (!entries || !names || !strings) {
+        fprintf(stderr, "Out of memory\n");
+        return false;
+    }
+
+    header.entries_offset = sizeof header;
+    strings_size = 0;
+
+    for (size_t i = 0; i < romlib.rom_count; i++) {
+        struct RomlibRom *rom = &romlib.roms[i];
+
+        if (i == 0 || rom->hash != romlib.roms[i - 1].hash) {
+            entries[header.entry_count] = (struct RomLibraryEntry){ .hash = rom->hash, .data_offset = data_size, .size = rom->size };
+            data_size += rom->size;
+            header.entry_count++;
+        }
+        else if (rom->size != romlib.roms[i - 1].size || memcmp(rom->data, romlib.roms[i - 1].data, rom->size) != 0) {
+            fprintf(stderr, "Skipping %s, its hash collides with %s\n", rom->name, romlib.roms[i - 1].name);
+            continue;
+        }
+        rom->entry_index = header.entry_count - 1;
+
+        names[header.name_count++] = (struct RomLibraryName){
+            .name_hash = rom->name_hash,
+            .entry_index = rom->entry_index,
+            .string_offset = strings_size,
+        };
+        strcpy(&strings[strings_size], rom->name);
+        strings_size += strlen(rom->name) + 1;
+    }
+
+    qsort(names, header.name_count, sizeof(struct RomLibraryName), romlib_compare_name);
+
+    // Lookups return the first of equal names
+    for (uint32_t i = 1; i < header.name_count; i++) {
+        if (names[i].name_hash == names[i - 1].name_hash && strcmp(&strings[names[i].string_offset], &strings[names[i - 1].string_offset]) == 0)
+            fprintf(stderr, "Name %s is used more than once, only one rom is reachable by it\n", &strings[names[i].string_offset]);
+    }
+
+    if (strings_size == 0) strings[strings_size++] = '\0'; // Never empty, simplifies validation
+
+    header.names_offset = header.entries_offset + (uint64_t)header.entry_count * sizeof(struct RomLibraryEntry);
+    header.strings_offset = header.names_offset + (uint64_t)header.name_count * sizeof(struct RomLibraryName);
+    header.strings_size = strings_size;
+
+    const uint64_t data_offset = header.strings_offset + strings_size;
+    for (uint32_t i = 0; i < header.entry_count; i++) entries[i].data_offset += data_offset;
+
+    FILE *library = fopen(library_filename, "wb");
+    if (!library) {
+        fprintf(stderr, "Could not open %s\n", library_filename);
+        return false;
+    }
+
+    bool is_written = fwrite(&header, sizeof header, 1, library) == 1
+        && fwrite(entries, sizeof(struct RomLibraryEntry), header.entry_count, library) == header.entry_count
+        && fwrite(names, sizeof(struct RomLibraryName), header.name_count, library) == header.name_count
+        && fwrite(strings, 1, strings_size, library) == strings_size;
+
+    for (size_t i = 0; i < romlib.rom_count && is_written; i++) {
+        if (i == 0 || romlib.roms[i].hash != romlib.roms[i - 1].hash)
+            is_written = fwrite(romlib.roms[i].data, 1, romlib.roms[i].size, library) == romlib.roms[i].size;
+    }
+
+    if (fclose(library) != 0 || !is_written) {
+        fprintf(stderr, "Could not write %s\n", library_filename);
+        return false;
+    }
+
+    printf("%u roms, %u names, %llu bytes of rom data\n", header.entry_count, header.name_count, (long long unsigned)data_size);
+    return true;
+}
+
+static bool romlib_list(const char *library_filename) {
+    struct RomLibrary rom_library;
+    if (!rom_library_open(&rom_library, library_filename)) return false;
+
+    for (uint32_t i = 0; i < rom_library.header->name_count; i++) {
+        const uint32_t entry_index = rom_library.names[i].entry_index;
+        if (entry_index >= rom_library.header->entry_count) continue;
+
+        printf("%016llx\t%u\t%s\n", (long long unsigned)rom_library.entries[entry_index].hash,
+               rom_library.entries[entry_index].size, rom_library_name(&rom_library, i));
+    }
+
+    rom_library_close(&rom_library);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 4 && strcmp(argv[1], "build") == 0) return romlib_build(argv[2], &argv[3], argc - 3) ? EXIT_SUCCESS : EXIT_FAILURE;
+    if (argc == 3 && strcmp(argv[1], "list") == 0) return romlib_list(argv[2]) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    fprintf(stderr, usage, argv[0], argv[0]);
+    return EXIT_FAILURE;
+}
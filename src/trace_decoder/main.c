@@ -0,0 +1,150 @@
+// Turns a binary trace written with --trace into text
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#ifdef TRACE_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "trace.h"
+#include "instruction.h"
+#include "user_interface/instruction_print.h"
+
+#define TRACE_DECODER_BATCH 4096 // Records read at a time
+#define TRACE_DECODER_LINE_SIZE 80 // Text of a batch is written at once, a line never takes more than this
+
+static const char *const usage = "Usage: %s <trace_file> [--from <record>] [--count <records>] [--cowgod]\n";
+
+struct TraceDecoderInput {
+#ifdef TRACE_HAVE_ZLIB
+    gzFile file; // Also reads uncompressed files
+#else
+    FILE *file;
+#endif
+};
+
+static bool trace_decoder_open(struct TraceDecoderInput *input, const char *filename) {
+#ifdef TRACE_HAVE_ZLIB
+    input->file = gzopen(filename, "rb");
+#else
+    input->file = fopen(filename, "rb");
+#endif
+    return input->file != NULL;
+}
+
+static size_t trace_decoder_read(struct TraceDecoderInput *input, void *buffer, size_t size) {
+#ifdef TRACE_HAVE_ZLIB
+    const int read = gzread(input->file, buffer, (unsigned int)size);
+    return (read > 0) ? (size_t)read : 0;
+#else
+    return fread(buffer, 1, size, input->file);
+#endif
+}
+
+// Same as %10llu
+static char *trace_decoder_format_index(char *text, uint64_t index) {
+    char digits[20];
+    int count = 0;
+    do {
+        digits[count++] = '0' + index % 10;
+        index /= 10;
+    } while (index > 0);
+
+    for (int i = count; i < 10; i++) *text++ = ' ';
+    while (count > 0) *text++ = digits[--count];
+    return text;
+}
+
+static char *trace_decoder_format_record(char *text, uint64_t index, const struct TraceRecord *record, enum InstructionSyntax syntax) {
+    text = trace_decoder_format_index(text, index);
+    memcpy(text, "  ", 2);
+    text = instruction_format_hex(text + 2, record->PC, 3);
+    memcpy(text, ": ", 2);
+    text = instruction_format_hex(text + 2, record->encoded_instruction, 4);
+    memcpy(text, "  I=", 4);
+    text = instruction_format_hex(text + 4, record->I, 3);
+    memcpy(text, "  ", 2);
+    text += 2;
+
+    if (record->register_index != TRACE_NO_REGISTER) {
+        *text++ = 'V';
+        *text++ = "0123456789ABCDEF"[record->register_index & 0xF];
+        *text++ = '=';
+        text = instruction_format_hex(text, record->register_value, 2);
+        memcpy(text, "  ", 2);
+        text += 2;
+    }
+    else {
+        memcpy(text, "       ", 7);
+        text += 7;
+    }
+
+    text = instruction_format(text, decoded_instruction_from_encoded_instruction(record->encoded_instruction), syntax);
+    *text++ = '\n';
+    return text;
+}
+
+static void trace_decoder_close(struct TraceDecoderInput *input) {
+#ifdef TRACE_HAVE_ZLIB
+    gzclose(input->file);
+#else
+    fclose(input->file);
+#endif
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, usage, argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    uint64_t from = 0, count = UINT64_MAX;
+    enum InstructionSyntax syntax = INSTRUCTION_SYNTAX_OWN;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--from") == 0 && i + 1 < argc) from = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) count = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--cowgod") == 0) syntax = INSTRUCTION_SYNTAX_COWGOD;
+        else {
+            fprintf(stderr, usage, argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    struct TraceDecoderInput input;
+    if (!trace_decoder_open(&input, argv[1])) {
+        fprintf(stderr, "Could not open trace %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    struct TraceFileHeader header;
+    if (trace_decoder_read(&input, &header, sizeof header) != sizeof header
+        || memcmp(header.magic, TRACE_MAGIC, sizeof header.magic) != 0
+        || header.version != TRACE_VERSION
+        || header.record_size != sizeof(struct TraceRecord)) {
+        fprintf(stderr, "%s is not a trace this version can read\n", argv[1]);
+        trace_decoder_close(&input);
+        return EXIT_FAILURE;
+    }
+
+    static struct TraceRecord records[TRACE_DECODER_BATCH];
+    static char text[TRACE_DECODER_BATCH * TRACE_DECODER_LINE_SIZE];
+    uint64_t index = 0;
+    size_t size;
+
+    while (count > 0 && (size = trace_decoder_read(&input, records, sizeof records)) >= sizeof records[0]) {
+        char *text_end = text;
+        for (size_t i = 0; i < size / sizeof records[0] && count > 0; i++, index++) {
+            if (index < from) continue;
+            count--;
+
+            text_end = trace_decoder_format_record(text_end, index, &records[i], syntax);
+        }
+        fwrite(text, 1, text_end - text, stdout);
+    }
+
+    trace_decoder_close(&input);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,199 @@
+// Shared-memory frames, the emulator writes under a sequence lock and readers retry when they catch it mid-write
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "user_interface/frame_share.h"
+
+// shm_open wants a single leading slash
+static bool frame_share_segment_name(char name[FRAME_SHARE_NAME_SIZE], const char *requested) {
+    const int length = snprintf(name, FRAME_SHARE_NAME_SIZE, "%s%s", (requested[0] == '/') ? "" : "/", requested);
+    if (length <= 1 || length >= FRAME_SHARE_NAME_SIZE || strchr(name + 1, '/')) {
+        fprintf(stderr, "Invalid shared frame name %s\n", requested);
+        return false;
+    }
+    return true;
+}
+
+// Whether an existing segment can be replaced: written by another version, never finished, or its owner is gone.
+// owner_pid is set to the process still publishing into it otherwise.
+static bool frame_share_is_stale(const char *name, pid_t *owner_pid) {
+    const int segment = shm_open(name, O_RDONLY, 0);
+    struct stat segment_status;
+
+    if (segment < 0) return errno == ENOENT; // Removed meanwhile, nothing in the way
+    else if (fstat(segment, &segment_status) != 0 || (size_t)segment_status.st_size < sizeof(struct FrameShareSegment)) {
+        close(segment);
+        return true;
+    }
+
+    const struct FrameShareSegment *mapping = mmap(NULL, sizeof(struct FrameShareSegment), PROT_READ, MAP_SHARED, segment, 0);
+    close(segment);
+    if (mapping == MAP_FAILED) return false;
+
+    *owner_pid = (pid_t)mapping->owner_pid;
+    const bool is_current = mapping->magic == FRAME_SHARE_MAGIC && mapping->version == FRAME_SHARE_VERSION
+                            && mapping->size == sizeof(struct FrameShareSegment);
+    munmap((void *)mapping, sizeof(struct FrameShareSegment));
+
+    // Signal 0 only checks the process exists, EPERM means it does and belongs to someone else
+    return !is_current || *owner_pid <= 0 || (kill(*owner_pid, 0) != 0 && errno == ESRCH);
+}
+
+bool frame_share_open(struct FrameShare *frame_share, const char *name) {
+    *frame_share = (struct FrameShare){0};
+    if (!frame_share_segment_name(frame_share->name, name)) return false;
+
+    int segment = shm_open(frame_share->name, O_CREAT | O_EXCL | O_RDWR, 0644);
+
+    // A segment left by a crashed run may have another size or a torn sequence, it is replaced
+    pid_t owner_pid = 0;
+    if (segment < 0 && errno == EEXIST) {
+        if (!frame_share_is_stale(frame_share->name, &owner_pid)) {
+            fprintf(stderr, "Shared frame segment %s is in use by process %d\n", frame_share->name, (int)owner_pid);
+            return false;
+        }
+
+        shm_unlink(frame_share->name);
+        segment = shm_open(frame_share->name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    }
+
+    if (segment < 0) {
+        fprintf(stderr, "Could not create shared frame segment %s\n", frame_share->name);
+        return false;
+    }
+
+    if (ftruncate(segment, sizeof(struct FrameShareSegment)) != 0) {
+        fprintf(stderr, "Could not size shared frame segment %s\n", frame_share->name);
+        close(segment);
+        shm_unlink(frame_share->name);
+        return false;
+    }
+
+    void *mapping = mmap(NULL, sizeof(struct FrameShareSegment), PROT_READ | PROT_WRITE, MAP_SHARED, segment, 0);
+    close(segment);
+
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "Could not map shared frame segment %s\n", frame_share->name);
+        shm_unlink(frame_share->name);
+        return false;
+    }
+
+    // Zero filled by ftruncate, so the sequence starts even and frame_number 0 means nothing published yet
+    frame_share->segment = mapping;
+    frame_share->segment->version = FRAME_SHARE_VERSION;
+    frame_share->segment->size = sizeof(struct FrameShareSegment);
+    frame_share->segment->owner_pid = (uint32_t)getpid();
+    atomic_thread_fence(memory_order_release);
+    frame_share->segment->magic = FRAME_SHARE_MAGIC;
+
+    return true;
+}
+
+void frame_share_publish(struct FrameShare *frame_share, const struct EmulatedSystem *emulated_system, uint64_t frame_number) {
+    struct FrameShareSegment *segment = frame_share->segment;
+    struct FrameShareFrame *frame = &segment->frame;
+    const uint64_t sequence = atomic_load_explicit(&segment->sequence, memory_order_relaxed);
+
+    // Odd first, readers that see it or race past it retry
+    atomic_store_explicit(&segment->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    frame->frame_number = frame_number;
+    memcpy(frame->display, emulated_system->display, sizeof frame->display);
+    memcpy(frame->V, emulated_system->V, sizeof frame->V);
+    frame->I = emulated_system->I;
+    frame->PC = emulated_system->PC;
+    memcpy(frame->stack, emulated_system->stack, sizeof frame->stack);
+    frame->SP = emulated_system->SP;
+    frame->delay_timer = emulated_system->delay_timer;
+    frame->sound_timer = emulated_system->sound_timer;
+    frame->extension = (uint8_t)emulated_system->extension;
+    frame->instructions_per_frame = emulated_system->instructions_per_frame;
+
+    atomic_store_explicit(&segment->sequence, sequence + 2, memory_order_release);
+}
+
+void frame_share_close(struct FrameShare *frame_share) {
+    if (!frame_share->segment) return;
+
+    munmap(frame_share->segment, sizeof(struct FrameShareSegment));
+    shm_unlink(frame_share->name);
+    frame_share->segment = NULL;
+}
+
+bool frame_share_reader_open(struct FrameShareReader *reader, const char *name) {
+    *reader = (struct FrameShareReader){0};
+
+    char segment_name[FRAME_SHARE_NAME_SIZE];
+    if (!frame_share_segment_name(segment_name, name)) return false;
+
+    const int segment = shm_open(segment_name, O_RDONLY, 0);
+    struct stat segment_status;
+
+    if (segment < 0 || fstat(segment, &segment_status) != 0) {
+        fprintf(stderr, "Shared frame segment %s does not exist, is the emulator running with --share?\n", segment_name);
+        if (segment >= 0) close(segment);
+        return false;
+    }
+    else if ((size_t)segment_status.st_size < sizeof(struct FrameShareSegment)) {
+        fprintf(stderr, "Shared frame segment %s is too small\n", segment_name);
+        close(segment);
+        return false;
+    }
+
+    const struct FrameShareSegment *mapping = mmap(NULL, sizeof(struct FrameShareSegment), PROT_READ, MAP_SHARED, segment, 0);
+    close(segment);
+
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "Could not map shared frame segment %s\n", segment_name);
+        return false;
+    }
+    else if (mapping->magic != FRAME_SHARE_MAGIC || mapping->version != FRAME_SHARE_VERSION || mapping->size != sizeof(struct FrameShareSegment)) {
+        fprintf(stderr, "Shared frame segment %s was written by another version\n", segment_name);
+        munmap((void *)mapping, sizeof(struct FrameShareSegment));
+        return false;
+    }
+
+    atomic_thread_fence(memory_order_acquire);
+    reader->segment = mapping;
+    return true;
+}
+
+bool frame_share_read(struct FrameShareReader *reader, struct FrameShareFrame *frame) {
+    const struct FrameShareSegment *segment = reader->segment;
+
+    for (unsigned int attempt = 0; attempt < FRAME_SHARE_READ_ATTEMPTS; attempt++) {
+        const uint64_t before = atomic_load_explicit(&segment->sequence, memory_order_acquire);
+
+        // Unchanged, the frame lines stay out of this core's cache and the emulator writes them without contention
+        if (before == reader->last_sequence) return false;
+
+        if (!(before & 1)) {
+            memcpy(frame, &segment->frame, sizeof *frame);
+            atomic_thread_fence(memory_order_acquire);
+
+            if (atomic_load_explicit(&segment->sequence, memory_order_relaxed) == before) {
+                reader->last_sequence = before;
+                return true;
+            }
+        }
+
+        reader->torn_read_count++;
+    }
+
+    return false;
+}
+
+void frame_share_reader_close(struct FrameShareReader *reader) {
+    if (!reader->segment) return;
+
+    munmap((void *)reader->segment, sizeof(struct FrameShareSegment));
+    reader->segment = NULL;
+}
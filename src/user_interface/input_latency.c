@@ -0,0 +1,70 @@
+#include "user_interface/input_latency.h"
+
+void input_latency_key_down(struct InputLatency *input_latency, uint8_t key, uint64_t timestamp) {
+    if (!input_latency->is_enabled || (input_latency->pending & (1u << key))) return;
+
+    input_latency->pending |= 1u << key;
+    input_latency->pressed_at[key] = timestamp;
+}
+
+void input_latency_key_up(struct InputLatency *input_latency, uint8_t key) {
+    if (!(input_latency->pending & (1u << key))) return;
+
+    input_latency->pending &= ~(1u << key);
+    input_latency->unseen_count++;
+}
+
+void input_latency_collect(struct InputLatency *input_latency, uint16_t observed, uint64_t now) {
+    uint16_t seen = input_latency->pending & observed;
+    input_latency->pending &= ~seen;
+
+    for (uint8_t key = 0; seen; key++, seen >>= 1) {
+        if (!(seen & 1)) continue;
+
+        const uint64_t latency = (now > input_latency->pressed_at[key]) ? now - input_latency->pressed_at[key] : 0;
+        input_latency->histogram[(latency < INPUT_LATENCY_BUCKETS - 1) ? latency : INPUT_LATENCY_BUCKETS - 1]++;
+        input_latency->sample_count++;
+    }
+}
+
+// Bucket holding the given fraction of samples
+static unsigned int input_latency_percentile(const struct InputLatency *input_latency, double fraction) {
+    const uint64_t wanted = (uint64_t)(fraction * input_latency->sample_count + 0.5);
+    uint64_t count = 0;
+
+    for (unsigned int i = 0; i < INPUT_LATENCY_BUCKETS; i++) {
+        count += input_latency->histogram[i];
+        if (count >= wanted && count > 0) return i;
+    }
+
+    return INPUT_LATENCY_BUCKETS - 1;
+}
+
+void input_latency_report(const struct InputLatency *input_latency, FILE *output, const char *rom_name, uint64_t rom_hash,
+                          unsigned int instructions_per_frame, unsigned int frames_per_second) {
+    fprintf(output, "Input latency for %s (%016llx), %u instructions per frame at %u fps\n",
+            rom_name, (long long unsigned)rom_hash, instructions_per_frame, frames_per_second);
+    fprintf(output, "  %u key presses read by the guest, %u released unread\n", input_latency->sample_count, input_latency->unseen_count);
+
+    if (input_latency->sample_count == 0) return;
+
+    fprintf(output, "  p50 %u ms, p90 %u ms, p99 %u ms\n",
+            input_latency_percentile(input_latency, 0.5),
+            input_latency_percentile(input_latency, 0.9),
+            input_latency_percentile(input_latency, 0.99));
+
+    uint32_t largest = 0;
+    for (unsigned int i = 0; i < INPUT_LATENCY_BUCKETS; i++)
+        if (input_latency->histogram[i] > largest) largest = input_latency->histogram[i];
+
+    for (unsigned int i = 0; i < INPUT_LATENCY_BUCKETS; i++) {
+        if (!input_latency->histogram[i]) continue;
+
+        char bar[41];
+        const unsigned int length = (unsigned int)((uint64_t)input_latency->histogram[i] * 40 / largest);
+        for (unsigned int j = 0; j < length; j++) bar[j] = '#';
+        bar[length] = '\0';
+
+        fprintf(output, "  %s%3u ms %6u %s\n", (i == INPUT_LATENCY_BUCKETS - 1) ? ">=" : "  ", i, input_latency->histogram[i], bar);
+    }
+}
@@ -1,48 +1,185 @@
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include "user_interface/instruction_print.h"
 
-// TODO: option to choose between cowgod's format and our own format.
-void instruction_decoded_print(struct DecodedInstruction decoded_instruction) {
-    bool found_mnemonic = false;
-    int i = 0;
-    while (!instruction_mnemonics[i].type == INVALID) {
-        if (decoded_instruction.type == instruction_mnemonics[i].type) {
-            printf("%s ", instruction_mnemonics[i].name);
-            found_mnemonic = true;
-        }
-        i++;
+// Indexed by type, the same names decoded_instruction_from_string looks up
+static const char *const instruction_print_own_mnemonics[] = {
+    [CLEAR] = "cls",
+    [RETURN] = "ret",
+    [JUMP] = "jp",
+    [SUBROUTINE] = "call",
+    [IF_EQUAL_THEN_SKIP] = "se",
+    [IF_NOT_EQUAL_THEN_SKIP] = "sne",
+    [VALUE_TO_REGISTER] = "ld",
+    [SUM_REGISTER] = "add",
+    [REGISTER_TO_REGISTER] = "ld",
+    [OR_REGISTERS] = "or",
+    [AND_REGISTERS] = "and",
+    [XOR_REGISTERS] = "xor",
+    [SUM_REGISTERS] = "sum",
+    [SUBTRACT_REGISTERS] = "sub",
+    [SHIFT_RIGHT_REGISTER] = "shr",
+    [INVERT_SUBTRACT_REGISTERS] = "subn",
+    [SHIFT_LEFT_REGISTER] = "shl",
+    [ADDRESS_TO_REGISTER_I] = "ld",
+    [JUMP_WITH_OFFSET] = "jp",
+    [RANDOM_NUMBER_TO_REGISTER] = "rnd",
+    [DRAW] = "drw",
+    [IF_PRESSED_THEN_SKIP] = "skp",
+    [IF_NOT_PRESSED_THEN_SKIP] = "sknp",
+    [MISC] = "misc",
+};
+
+static const char *const instruction_print_cowgod_mnemonics[] = {
+    [CLEAR] = "CLS",
+    [RETURN] = "RET",
+    [JUMP] = "JP",
+    [SUBROUTINE] = "CALL",
+    [IF_EQUAL_THEN_SKIP] = "SE",
+    [IF_NOT_EQUAL_THEN_SKIP] = "SNE",
+    [VALUE_TO_REGISTER] = "LD",
+    [SUM_REGISTER] = "ADD",
+    [REGISTER_TO_REGISTER] = "LD",
+    [OR_REGISTERS] = "OR",
+    [AND_REGISTERS] = "AND",
+    [XOR_REGISTERS] = "XOR",
+    [SUM_REGISTERS] = "ADD",
+    [SUBTRACT_REGISTERS] = "SUB",
+    [SHIFT_RIGHT_REGISTER] = "SHR",
+    [INVERT_SUBTRACT_REGISTERS] = "SUBN",
+    [SHIFT_LEFT_REGISTER] = "SHL",
+    [ADDRESS_TO_REGISTER_I] = "LD",
+    [JUMP_WITH_OFFSET] = "JP",
+    [RANDOM_NUMBER_TO_REGISTER] = "RND",
+    [DRAW] = "DRW",
+    [IF_PRESSED_THEN_SKIP] = "SKP",
+    [IF_NOT_PRESSED_THEN_SKIP] = "SKNP",
+};
+
+#define INSTRUCTION_PRINT_TYPE_COUNT (sizeof instruction_print_own_mnemonics / sizeof *instruction_print_own_mnemonics)
+
+static inline char *instruction_print_text(char *buffer, const char *text) {
+    while (*text) *buffer++ = *text++;
+    return buffer;
+}
+
+static inline char *instruction_print_decimal(char *buffer, unsigned int value) {
+    if (value >= 100) *buffer++ = '0' + value / 100;
+    if (value >= 10) *buffer++ = '0' + value / 10 % 10;
+    *buffer++ = '0' + value % 10;
+    return buffer;
+}
+
+static inline char *instruction_print_register(char *buffer, unsigned int index, enum InstructionSyntax syntax) {
+    *buffer++ = 'V';
+    if (syntax == INSTRUCTION_SYNTAX_COWGOD) {
+        *buffer++ = "0123456789ABCDEF"[index & 0xF];
+        return buffer;
     }
+    return instruction_print_decimal(buffer, index);
+}
+
+static inline char *instruction_print_address(char *buffer, uint16_t address) {
+    *buffer++ = '0';
+    *buffer++ = 'x';
+    return instruction_format_hex(buffer, address, 3);
+}
+
+// Fx instructions are told apart by their low byte, Cowgod writes each with its own operands
+static char *instruction_print_cowgod_misc(char *buffer, uint8_t register_index, uint8_t value) {
+    const char *before = NULL;
+    const char *after = NULL;
 
-    if (!found_mnemonic) {
-        printf("Unknown\n");
-        return;
+    switch (value) {
+        case 0x07: after = ", DT"; break;
+        case 0x0A: after = ", K"; break;
+        case 0x85: after = ", R"; break;
+        case 0x65: after = ", [I]"; break;
+        case 0x15: before = "DT, "; break;
+        case 0x18: before = "ST, "; break;
+        case 0x29: before = "F, "; break;
+        case 0x30: before = "HF, "; break;
+        case 0x33: before = "B, "; break;
+        case 0x55: before = "[I], "; break;
+        case 0x75: before = "R, "; break;
+        case 0x1E:
+            buffer = instruction_print_text(buffer, "ADD I, ");
+            return instruction_print_register(buffer, register_index, INSTRUCTION_SYNTAX_COWGOD);
+        default:
+            return instruction_print_text(buffer, "Unknown");
     }
 
+    buffer = instruction_print_text(buffer, "LD ");
+    if (before) buffer = instruction_print_text(buffer, before);
+    buffer = instruction_print_register(buffer, register_index, INSTRUCTION_SYNTAX_COWGOD);
+    if (after) buffer = instruction_print_text(buffer, after);
+    return buffer;
+}
+
+char *instruction_format(char *buffer, struct DecodedInstruction decoded_instruction, enum InstructionSyntax syntax) {
+    const bool is_cowgod = syntax == INSTRUCTION_SYNTAX_COWGOD;
+    const enum DecodedInstructionType type = decoded_instruction.type;
+
+    if ((unsigned int)type >= INSTRUCTION_PRINT_TYPE_COUNT || type == INVALID)
+        return instruction_print_text(buffer, "Unknown");
+    else if (is_cowgod && type == MISC)
+        return instruction_print_cowgod_misc(buffer, decoded_instruction.register_index, decoded_instruction.value);
+
+    buffer = instruction_print_text(buffer, is_cowgod ? instruction_print_cowgod_mnemonics[type] : instruction_print_own_mnemonics[type]);
+
     switch (decoded_instruction.operands_layout) {
         case ADDRESS:
-            if (decoded_instruction.type == ADDRESS_TO_REGISTER_I) printf("I, ");
-            printf("0x%03x\n", decoded_instruction.address);
-            break;
+            *buffer++ = ' ';
+            if (type == ADDRESS_TO_REGISTER_I) buffer = instruction_print_text(buffer, "I, ");
+            else if (type == JUMP_WITH_OFFSET) buffer = instruction_print_text(buffer, "V0, ");
+            return instruction_print_address(buffer, decoded_instruction.address);
         case REGISTER_AND_VALUE:
-            printf(
-                "V%d, %d\n",
-                decoded_instruction.register_index,
-                decoded_instruction.value
-            );
-            break;
+            *buffer++ = ' ';
+            buffer = instruction_print_register(buffer, decoded_instruction.register_index, syntax);
+            if (!is_cowgod) {
+                buffer = instruction_print_text(buffer, ", ");
+                return instruction_print_decimal(buffer, decoded_instruction.value);
+            }
+            // The low byte of EX9E/EXA1 is part of the opcode
+            else if (type == IF_PRESSED_THEN_SKIP || type == IF_NOT_PRESSED_THEN_SKIP) {
+                return buffer;
+            }
+            buffer = instruction_print_text(buffer, ", 0x");
+            return instruction_format_hex(buffer, decoded_instruction.value, 2);
         case REGISTERS_AND_HALF_VALUE:
-            printf(
-                "V%d, V%d, %d\n",
-                decoded_instruction.register_indexes[0],
-                decoded_instruction.register_indexes[1],
-                decoded_instruction.half_value
-            );
-            break;
+            *buffer++ = ' ';
+            buffer = instruction_print_register(buffer, decoded_instruction.register_indexes[0], syntax);
+            buffer = instruction_print_text(buffer, ", ");
+            buffer = instruction_print_register(buffer, decoded_instruction.register_indexes[1], syntax);
+            // Cowgod only writes the nibble where it is an operand
+            if (!is_cowgod || type == DRAW) {
+                buffer = instruction_print_text(buffer, ", ");
+                buffer = instruction_print_decimal(buffer, decoded_instruction.half_value);
+            }
+            return buffer;
         case NONE:
         default:
-            printf("No operands\n");
-            break;
+            return buffer;
+    }
+}
+
+void instruction_decoded_print(struct DecodedInstruction decoded_instruction) {
+    char text[INSTRUCTION_TEXT_SIZE + 1];
+    char *end = instruction_format(text, decoded_instruction, INSTRUCTION_SYNTAX_OWN);
+    *end++ = '\n';
+    fwrite(text, 1, end - text, stdout);
+}
+
+int instruction_decoded_sprint(char *buffer, size_t size, struct DecodedInstruction decoded_instruction) {
+    char text[INSTRUCTION_TEXT_SIZE];
+    const size_t length = instruction_format(text, decoded_instruction, INSTRUCTION_SYNTAX_OWN) - text;
+
+    if (size > 0) {
+        const size_t copied = (length < size) ? length : size - 1;
+        memcpy(buffer, text, copied);
+        buffer[copied] = '\0';
     }
+    return (int)length;
 }
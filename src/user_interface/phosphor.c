@@ -0,0 +1,98 @@
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "user_interface/phosphor.h"
+
+void phosphor_reset(struct Phosphor *phosphor, uint32_t bg_color) {
+    for (size_t i = 0; i < PHOSPHOR_PIXELS; i++) phosphor->pixel_color[i] = bg_color;
+    memset(phosphor->last_display, 0, sizeof phosphor->last_display);
+    phosphor->is_settled = true;
+}
+
+// Per channel: c + (t - c) * weight / 2^PHOSPHOR_WEIGHT_BITS, rounded away from c
+static inline uint32_t phosphor_step_pixel(uint32_t color, uint32_t target, int32_t weight) {
+    uint32_t result = 0;
+
+    for (int shift = 0; shift < 32; shift += 8) {
+        const int32_t channel = (color >> shift) & 0xFF;
+        const int32_t difference = (int32_t)((target >> shift) & 0xFF) - channel;
+        const int32_t bias = (difference > 0) ? (1 << PHOSPHOR_WEIGHT_BITS) - 1 : 0;
+
+        result |= (uint32_t)(channel + ((difference * weight + bias) >> PHOSPHOR_WEIGHT_BITS)) << shift;
+    }
+
+    return result;
+}
+
+// Pixel i of a display given as rows
+static inline bool phosphor_pixel(const uint64_t *display, size_t i) {
+    return (display[i / 64] >> (63 - i % 64)) & 1;
+}
+
+bool phosphor_step(uint32_t *pixel_color, const uint64_t *display, size_t count, uint32_t fg_color, uint32_t bg_color, uint16_t weight) {
+    size_t i = 0;
+    bool is_settled = true;
+
+#ifdef __SSE2__
+    // 4 pixels at a time, channels widened to 16 bits. |difference * weight| + bias fits in int16.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i fg = _mm_set1_epi32((int32_t)fg_color);
+    const __m128i bg = _mm_set1_epi32((int32_t)bg_color);
+    const __m128i weights = _mm_set1_epi16((int16_t)weight);
+    const __m128i rounding = _mm_set1_epi16((1 << PHOSPHOR_WEIGHT_BITS) - 1);
+    const __m128i pixel_bits = _mm_setr_epi32(8, 4, 2, 1); // Leftmost pixel in the highest bit
+    __m128i unsettled = zero;
+
+    for (; i + 4 <= count; i += 4) {
+        // The 4 pixels' bits, widened to a 32-bit mask per pixel
+        const int32_t nibble = (int32_t)((display[i / 64] >> (60 - i % 64)) & 0xF);
+        const __m128i is_on = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(nibble), pixel_bits), pixel_bits);
+        const __m128i target = _mm_or_si128(_mm_and_si128(is_on, fg), _mm_andnot_si128(is_on, bg));
+
+        const __m128i color = _mm_loadu_si128((const __m128i *)&pixel_color[i]);
+        __m128i halves[2];
+
+        for (int half = 0; half < 2; half++) {
+            const __m128i channels = half ? _mm_unpackhi_epi8(color, zero) : _mm_unpacklo_epi8(color, zero);
+            const __m128i difference = _mm_sub_epi16(half ? _mm_unpackhi_epi8(target, zero) : _mm_unpacklo_epi8(target, zero), channels);
+            const __m128i bias = _mm_and_si128(_mm_cmpgt_epi16(difference, zero), rounding);
+            const __m128i step = _mm_srai_epi16(_mm_add_epi16(_mm_mullo_epi16(difference, weights), bias), PHOSPHOR_WEIGHT_BITS);
+
+            halves[half] = _mm_add_epi16(channels, step);
+        }
+
+        const __m128i result = _mm_packus_epi16(halves[0], halves[1]);
+        _mm_storeu_si128((__m128i *)&pixel_color[i], result);
+        unsettled = _mm_or_si128(unsettled, _mm_xor_si128(result, target));
+    }
+
+    is_settled = _mm_movemask_epi8(_mm_cmpeq_epi8(unsettled, zero)) == 0xFFFF;
+#endif
+
+    for (; i < count; i++) {
+        const uint32_t target = phosphor_pixel(display, i) ? fg_color : bg_color;
+        if (pixel_color[i] == target) continue;
+
+        pixel_color[i] = phosphor_step_pixel(pixel_color[i], target, weight);
+        is_settled = is_settled && pixel_color[i] == target;
+    }
+
+    return is_settled;
+}
+
+void phosphor_update(struct Phosphor *phosphor, const uint64_t *display, uint32_t fg_color, uint32_t bg_color, float color_lerp_rate) {
+    const bool display_changed = memcmp(phosphor->last_display, display, sizeof phosphor->last_display) != 0;
+    if (phosphor->is_settled && !display_changed) return;
+
+    if (display_changed) memcpy(phosphor->last_display, display, sizeof phosphor->last_display);
+
+    // The j/k keys move the rate in steps of 0.1, 7 bits tell those apart
+    float scaled_rate = color_lerp_rate * (1 << PHOSPHOR_WEIGHT_BITS) + 0.5f;
+    if (scaled_rate < 1) scaled_rate = 1;
+    if (scaled_rate > (1 << PHOSPHOR_WEIGHT_BITS)) scaled_rate = 1 << PHOSPHOR_WEIGHT_BITS;
+
+    phosphor->is_settled = phosphor_step(phosphor->pixel_color, display, PHOSPHOR_PIXELS, fg_color, bg_color, (uint16_t)scaled_rate);
+}
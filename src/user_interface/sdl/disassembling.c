@@ -1,29 +1,57 @@
 #include "user_interface/sdl/interface.h"
 #include "user_interface/instruction_print.h"
 
+// Registers, stack and disassembly around PC, drawn through the glyph atlas
 static inline void disassembling_user_interface_draw(struct UserInterface *user_interface, struct EmulatedSystem *emulated_system) {
-    user_interface->disassembling.message_surface = TTF_RenderText_Blended_Wrapped(
-        user_interface->font,
-        "Disassembling...", 
-        (SDL_Color){255, 255, 255, 255},
-        300
-    );
-
-    printf("%lu: %04x: ", (long unsigned int)emulated_system->PC, emulated_system->encoded_instruction);
-    instruction_decoded_print(emulated_system->decoded_instruction);
-
-    user_interface->disassembling.message = SDL_CreateTextureFromSurface(
-        user_interface->renderer,
-        user_interface->disassembling.message_surface
-    );
-
-    SDL_Rect rectangle = {
-        .x = 100,
-        .y = 100,
-        .w = user_interface->disassembling.message_surface->w,
-        .h = user_interface->disassembling.message_surface->h
-    };
-
-    SDL_SetRenderDrawColor(user_interface->renderer, 0, 0, 0, 255);
-    SDL_RenderCopy(user_interface->renderer, user_interface->disassembling.message, NULL, &rectangle);
+    struct GlyphAtlas *glyph_atlas = &user_interface->disassembling.glyph_atlas;
+    const uint64_t start = SDL_GetPerformanceCounter();
+
+    if (!glyph_atlas->texture && !emulator_user_interface_open_font(user_interface)) {
+        user_interface->disassembling.is_active = false;
+        return;
+    }
+    else if (!glyph_atlas->texture && !glyph_atlas_create(glyph_atlas, user_interface->renderer, user_interface->font)) {
+        SDL_Log("Could not create glyph atlas: %s\n", SDL_GetError());
+        user_interface->disassembling.is_active = false;
+        return;
+    }
+
+    const SDL_Color text_color = {255, 255, 0, 255};
+    const SDL_Color current_color = {0, 255, 255, 255};
+    const int margin = 10;
+    const int right_pane_x = user_interface->desired_window_width * user_interface->scale_factor - 360;
+    char text[512];
+    int length = 0;
+
+    // Registers
+    for (uint8_t i = 0; i < 16; i++)
+        length += snprintf(&text[length], sizeof text - length, "V%X %02x%s", i, emulated_system->V[i], (i % 4 == 3) ? "\n" : "  ");
+    snprintf(&text[length], sizeof text - length, "I %03x  PC %03x  SP %u\nDT %02x  ST %02x\noverlay %.0f us",
+             emulated_system->I, emulated_system->PC, emulated_system->SP,
+             emulated_system->delay_timer, emulated_system->sound_timer, user_interface->disassembling.draw_microseconds);
+    glyph_atlas_draw_text(glyph_atlas, user_interface->renderer, margin, margin, text, text_color);
+
+    // Stack
+    length = snprintf(text, sizeof text, "stack\n");
+    for (uint8_t i = 0; i < emulated_system->SP && i < STACK_SIZE; i++)
+        length += snprintf(&text[length], sizeof text - length, "%2u: %03x\n", i, emulated_system->stack[i]);
+    glyph_atlas_draw_text(glyph_atlas, user_interface->renderer, margin, margin + 8 * glyph_atlas->line_height, text, text_color);
+
+    // Disassembly, PC points to the next instruction
+    for (int i = -4; i < 8; i++) {
+        const int address = emulated_system->PC + 2 * i;
+        if (address < 0 || address + 1 >= (int)sizeof emulated_system->ram) continue;
+
+        const uint16_t encoded_instruction = (emulated_system->ram[address] << 8) | emulated_system->ram[address + 1];
+        length = snprintf(text, sizeof text, "%03x: %04x ", address, encoded_instruction);
+        instruction_decoded_sprint(&text[length], sizeof text - length, decoded_instruction_from_encoded_instruction(encoded_instruction));
+
+        glyph_atlas_draw_text(glyph_atlas, user_interface->renderer, right_pane_x, margin + (i + 4) * glyph_atlas->line_height,
+                              text, (i == 0) ? current_color : text_color);
+    }
+
+    glyph_atlas_flush(glyph_atlas, user_interface->renderer);
+
+    const float microseconds = (SDL_GetPerformanceCounter() - start) * 1e6f / SDL_GetPerformanceFrequency();
+    user_interface->disassembling.draw_microseconds += (microseconds - user_interface->disassembling.draw_microseconds) * 0.05f;
 }
@@ -0,0 +1,97 @@
+#include "user_interface/sdl/interface.h"
+
+static bool glyph_atlas_create(struct GlyphAtlas *glyph_atlas, SDL_Renderer *renderer, TTF_Font *font) {
+    SDL_Surface *glyph_surfaces[GLYPH_ATLAS_SIZE] = {0};
+    int width = 0, height = 0;
+
+    for (int i = 0; i < GLYPH_ATLAS_SIZE; i++) {
+        glyph_surfaces[i] = TTF_RenderGlyph_Blended(font, GLYPH_ATLAS_FIRST + i, (SDL_Color){255, 255, 255, 255});
+        if (!glyph_surfaces[i]) continue;
+
+        int minx, maxx, miny, maxy;
+        TTF_GlyphMetrics(font, GLYPH_ATLAS_FIRST + i, &minx, &maxx, &miny, &maxy, &glyph_atlas->advances[i]);
+
+        // One row, 1 pixel apart so filtering doesn't bleed between glyphs
+        glyph_atlas->glyphs[i] = (SDL_Rect){ .x = width, .y = 0, .w = glyph_surfaces[i]->w, .h = glyph_surfaces[i]->h };
+        width += glyph_surfaces[i]->w + 1;
+        if (glyph_surfaces[i]->h > height) height = glyph_surfaces[i]->h;
+    }
+
+    SDL_Surface *atlas_surface = (width > 0) ? SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32) : NULL;
+
+    for (int i = 0; i < GLYPH_ATLAS_SIZE; i++) {
+        if (!glyph_surfaces[i]) continue;
+
+        if (atlas_surface) {
+            SDL_SetSurfaceBlendMode(glyph_surfaces[i], SDL_BLENDMODE_NONE); // Copy alpha as is
+            SDL_BlitSurface(glyph_surfaces[i], NULL, atlas_surface, &glyph_atlas->glyphs[i]);
+        }
+        SDL_FreeSurface(glyph_surfaces[i]);
+    }
+
+    if (!atlas_surface) return false;
+
+    glyph_atlas->texture = SDL_CreateTextureFromSurface(renderer, atlas_surface);
+    SDL_FreeSurface(atlas_surface);
+    if (!glyph_atlas->texture) return false;
+
+    SDL_SetTextureBlendMode(glyph_atlas->texture, SDL_BLENDMODE_BLEND);
+    glyph_atlas->texture_width = width;
+    glyph_atlas->texture_height = height;
+    glyph_atlas->line_height = TTF_FontHeight(font);
+    glyph_atlas->quad_count = 0;
+
+    // Quads never change shape, indices are set once
+    for (int i = 0; i < GLYPH_ATLAS_MAX_QUADS; i++) {
+        const int quad_indices[6] = {0, 1, 2, 2, 3, 0};
+        for (int j = 0; j < 6; j++) glyph_atlas->indices[i * 6 + j] = i * 4 + quad_indices[j];
+    }
+
+    return true;
+}
+
+static void glyph_atlas_destroy(struct GlyphAtlas *glyph_atlas) {
+    if (glyph_atlas->texture) SDL_DestroyTexture(glyph_atlas->texture);
+    glyph_atlas->texture = NULL;
+}
+
+// Draws every queued quad with a single call
+static void glyph_atlas_flush(struct GlyphAtlas *glyph_atlas, SDL_Renderer *renderer) {
+    if (glyph_atlas->quad_count == 0) return;
+
+    SDL_RenderGeometry(renderer, glyph_atlas->texture,
+                       glyph_atlas->vertices, glyph_atlas->quad_count * 4,
+                       glyph_atlas->indices, glyph_atlas->quad_count * 6);
+    glyph_atlas->quad_count = 0;
+}
+
+// Queues text at (x, y), '\n' starts a new line
+static void glyph_atlas_draw_text(struct GlyphAtlas *glyph_atlas, SDL_Renderer *renderer, int x, int y, const char *text, SDL_Color color) {
+    int pen_x = x;
+
+    for (const char *character = text; *character; character++) {
+        if (*character == '\n') {
+            pen_x = x;
+            y += glyph_atlas->line_height;
+            continue;
+        }
+        if (*character < GLYPH_ATLAS_FIRST || *character > GLYPH_ATLAS_LAST) continue;
+
+        if (glyph_atlas->quad_count == GLYPH_ATLAS_MAX_QUADS) glyph_atlas_flush(glyph_atlas, renderer);
+
+        const int glyph_index = *character - GLYPH_ATLAS_FIRST;
+        const SDL_Rect *glyph = &glyph_atlas->glyphs[glyph_index];
+        const float u0 = (float)glyph->x / glyph_atlas->texture_width;
+        const float u1 = (float)(glyph->x + glyph->w) / glyph_atlas->texture_width;
+        const float v1 = (float)glyph->h / glyph_atlas->texture_height;
+
+        SDL_Vertex *vertices = &glyph_atlas->vertices[glyph_atlas->quad_count * 4];
+        vertices[0] = (SDL_Vertex){ .position = {pen_x, y}, .color = color, .tex_coord = {u0, 0} };
+        vertices[1] = (SDL_Vertex){ .position = {pen_x + glyph->w, y}, .color = color, .tex_coord = {u1, 0} };
+        vertices[2] = (SDL_Vertex){ .position = {pen_x + glyph->w, y + glyph->h}, .color = color, .tex_coord = {u1, v1} };
+        vertices[3] = (SDL_Vertex){ .position = {pen_x, y + glyph->h}, .color = color, .tex_coord = {u0, v1} };
+        glyph_atlas->quad_count++;
+
+        pen_x += glyph_atlas->advances[glyph_index];
+    }
+}
@@ -1,21 +1,41 @@
+#include <stdlib.h>
+
 #include "user_interface/sdl/interface.h"
-#include "user_interface/color_lerp.h"
+#include "user_interface/phosphor.h"
+
+// Opened the first time text is drawn, false when no font could be opened
+static bool emulator_user_interface_open_font(struct UserInterface *user_interface);
 
 // pause_menu.c
 // Draws pause menu
 static void pause_menu_user_interface_draw(struct UserInterface *user_interface);
 
+// glyph_atlas.c
+// Text rendering through a texture holding every glyph
+static bool glyph_atlas_create(struct GlyphAtlas *glyph_atlas, SDL_Renderer *renderer, TTF_Font *font);
+static void glyph_atlas_destroy(struct GlyphAtlas *glyph_atlas);
+static void glyph_atlas_flush(struct GlyphAtlas *glyph_atlas, SDL_Renderer *renderer);
+static void glyph_atlas_draw_text(struct GlyphAtlas *glyph_atlas, SDL_Renderer *renderer, int x, int y, const char *text, SDL_Color color);
+
 // disassembling.c
 // Prints instruction decoding info on screen in real time
 static inline void disassembling_user_interface_draw(struct UserInterface *user_interface, struct EmulatedSystem *emulated_system);
 
 #include "pause_menu.c"
+#include "glyph_atlas.c"
 #include "disassembling.c"
 
 void emulator_user_interface_destroy(struct UserInterface *user_interface) {
-    SDL_DestroyRenderer(user_interface->renderer);
-    SDL_DestroyWindow(user_interface->window);
-    SDL_CloseAudioDevice(user_interface->dev);
+    glyph_atlas_destroy(&user_interface->disassembling.glyph_atlas);
+    if (user_interface->pause_menu.message) SDL_DestroyTexture(user_interface->pause_menu.message);
+    if (user_interface->pause_menu.message_surface) SDL_FreeSurface(user_interface->pause_menu.message_surface);
+    if (user_interface->font) {
+        TTF_CloseFont(user_interface->font);
+        TTF_Quit();
+    }
+    if (user_interface->renderer) SDL_DestroyRenderer(user_interface->renderer);
+    if (user_interface->window) SDL_DestroyWindow(user_interface->window);
+    if (user_interface->dev) SDL_CloseAudioDevice(user_interface->dev);
     SDL_Quit();
 }
 
@@ -47,28 +67,44 @@ void emulator_user_interface_audio_callback(void *userdata, uint8_t *stream, int
     }
 }
 
-bool emulator_user_interface_initialize(struct UserInterface *user_interface) {
+void emulator_user_interface_configure_defaults(struct UserInterface *user_interface) {
+    const uint32_t scale_factor = user_interface->scale_factor; // May come from the command line
+
     *user_interface = (struct UserInterface){
         .desired_window_width = 64,
         .desired_window_height = 32,
         .fg_color = 0xFFFFFFFF,
         .bg_color = 0x000000FF,
-        .scale_factor = 20,
+        .scale_factor = scale_factor ? scale_factor : 20,
         .pixel_outlines = true,
         .square_wave_freq = 440,
         .audio_sample_rate = 44100,
         .volume = 3000,
         .color_lerp_rate = 0.7,
+        /*
+        CHIP8 Keypad  QWERTY
+        123C          1234
+        456D          qwer
+        789E          asdf
+        A0BF          zxcv
+        */
+        .keymap = {
+            SDLK_x, SDLK_1, SDLK_2, SDLK_3,
+            SDLK_q, SDLK_w, SDLK_e, SDLK_a,
+            SDLK_s, SDLK_d, SDLK_z, SDLK_c,
+            SDLK_4, SDLK_r, SDLK_f, SDLK_v,
+        },
     };
 
     // Init pixels to bg color
-    memset(
-        &user_interface->pixel_color[0],
-        user_interface->bg_color,
-        sizeof user_interface->pixel_color
-    );
+    phosphor_reset(&user_interface->phosphor, user_interface->bg_color);
+}
+
+bool emulator_user_interface_initialize(struct UserInterface *user_interface) {
+    emulator_user_interface_configure_defaults(user_interface);
 
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_TIMER) != 0) {
+    // Audio and fonts are opened when first needed, see emulator_user_interface_open_audio and _open_font
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
         SDL_Log("Could not Initialize SDL: %s\n", SDL_GetError());
         return false;
     }
@@ -92,6 +128,22 @@ bool emulator_user_interface_initialize(struct UserInterface *user_interface) {
         return false;
     }
 
+    return true;
+}
+
+// Only roms that beep need audio, the device is opened the first time the sound timer runs.
+// Without one the rom runs silent.
+static bool emulator_user_interface_open_audio(struct UserInterface *user_interface) {
+    if (user_interface->dev) return true;
+    else if (user_interface->is_audio_unavailable) return false;
+
+    user_interface->is_audio_unavailable = true; // Until it opens, so a failure is only reported once
+
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0) {
+        SDL_Log("Could not initialize audio: %s\n", SDL_GetError());
+        return false;
+    }
+
     user_interface->want = (SDL_AudioSpec){
         .freq = 44100,
         .format = AUDIO_S16LSB,
@@ -110,32 +162,49 @@ bool emulator_user_interface_initialize(struct UserInterface *user_interface) {
 
     if ((user_interface->want.format != user_interface->have.format) || (user_interface->want.channels != user_interface->have.channels)) {
         SDL_Log("Could not get audio spec: %s\n", SDL_GetError());
+        SDL_CloseAudioDevice(user_interface->dev);
+        user_interface->dev = 0;
         return false;
     }
 
-    // TTF font
+    user_interface->is_audio_unavailable = false;
+    return true;
+}
 
-    TTF_Init();
+// Tried in order after TRACUA_CHIP8_FONT, where distributions put DejaVu
+static const char *const emulator_user_interface_font_names[] = {
+    "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+    "/usr/share/fonts/TTF/DejaVuSans.ttf",
+    "/usr/share/fonts/dejavu/DejaVuSans.ttf",
+    "/usr/share/fonts/dejavu-sans-fonts/DejaVuSans.ttf",
+};
 
-    //temporary arrangement, will look for other fonts later
-    user_interface->font = TTF_OpenFont("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf", 24);
-    if (!user_interface->font) {
-        printf("Font error: %s\n", TTF_GetError());
+// Only the pause menu and the overlay draw text. Without a font the pause menu is a blank screen and the overlay
+// stays off, the rom runs either way.
+static bool emulator_user_interface_open_font(struct UserInterface *user_interface) {
+    if (user_interface->font) return true;
+    else if (user_interface->is_font_unavailable) return false;
+
+    user_interface->is_font_unavailable = true;
+
+    if (TTF_Init() != 0) {
+        SDL_Log("Could not initialize TTF: %s\n", TTF_GetError());
         return false;
     }
 
-    user_interface->pause_menu.message_surface = TTF_RenderText_Blended_Wrapped(
-        user_interface->font,
-        "Game paused\n\nSpace: pause/resume\nF5: save state\nF9: load state\nt: slow/normal", 
-        (SDL_Color){255, 255, 255, 255},
-        300
-    );
+    const char *const font_name = getenv("TRACUA_CHIP8_FONT");
+    if (font_name) user_interface->font = TTF_OpenFont(font_name, 24);
 
-    user_interface->pause_menu.message = SDL_CreateTextureFromSurface(
-        user_interface->renderer,
-        user_interface->pause_menu.message_surface
-    );
+    for (size_t i = 0; !user_interface->font && i < sizeof emulator_user_interface_font_names / sizeof *emulator_user_interface_font_names; i++)
+        user_interface->font = TTF_OpenFont(emulator_user_interface_font_names[i], 24);
 
+    if (!user_interface->font) {
+        SDL_Log("No font found, set TRACUA_CHIP8_FONT to a TrueType font for the pause menu and overlay\n");
+        TTF_Quit();
+        return false;
+    }
+
+    user_interface->is_font_unavailable = false;
     return true;
 }
 
@@ -153,64 +222,71 @@ static void emulated_user_interface_draw(struct UserInterface *user_interface, s
     const uint8_t bg_b = (bg_color >>  8) & 0xFF;
     const uint8_t bg_a = (bg_color >>  0) & 0xFF;
 
-    for (uint32_t i = 0; i < sizeof emulated_system->display; i++) {
+    phosphor_update(
+        &user_interface->phosphor,
+        emulated_system->display,
+        user_interface->fg_color,
+        user_interface->bg_color,
+        user_interface->color_lerp_rate
+    );
+
+    for (uint32_t i = 0; i < EMULATED_DISPLAY_WIDTH * EMULATED_DISPLAY_HEIGHT; i++) {
         rect.x = (i % user_interface->desired_window_width) * user_interface->scale_factor;
         rect.y = (i / user_interface->desired_window_width) * user_interface->scale_factor;
 
-        if (emulated_system->display[i]) {
-            if (user_interface->pixel_color[i] != user_interface->fg_color) {
-                user_interface->pixel_color[i] = user_interface_color_lerp(
-                    user_interface->pixel_color[i], 
-                    user_interface->fg_color, 
-                    user_interface->color_lerp_rate
-                );
-            }
-
-            const uint8_t r = (user_interface->pixel_color[i] >> 24) & 0xFF;
-            const uint8_t g = (user_interface->pixel_color[i] >> 16) & 0xFF;
-            const uint8_t b = (user_interface->pixel_color[i] >>  8) & 0xFF;
-            const uint8_t a = (user_interface->pixel_color[i] >>  0) & 0xFF;
-
-            SDL_SetRenderDrawColor(user_interface->renderer, r, g, b, a);
-            SDL_RenderFillRect(user_interface->renderer, &rect);
-        
-            if (user_interface->pixel_outlines) {
-                SDL_SetRenderDrawColor(user_interface->renderer, bg_r, bg_g, bg_b, bg_a);
-                SDL_RenderDrawRect(user_interface->renderer, &rect);
-            }
-
-        } else {
-            if (user_interface->pixel_color[i] != user_interface->bg_color) {
-                // Lerp
-                user_interface->pixel_color[i] = user_interface_color_lerp(
-                    user_interface->pixel_color[i], 
-                    user_interface->bg_color, 
-                    user_interface->color_lerp_rate
-                );
-            }
-
-            const uint8_t r = (user_interface->pixel_color[i] >> 24) & 0xFF;
-            const uint8_t g = (user_interface->pixel_color[i] >> 16) & 0xFF;
-            const uint8_t b = (user_interface->pixel_color[i] >>  8) & 0xFF;
-            const uint8_t a = (user_interface->pixel_color[i] >>  0) & 0xFF;
-
-            SDL_SetRenderDrawColor(user_interface->renderer, r, g, b, a);
-            SDL_RenderFillRect(user_interface->renderer, &rect);
+        const uint32_t pixel_color = user_interface->phosphor.pixel_color[i];
+        const uint8_t r = (pixel_color >> 24) & 0xFF;
+        const uint8_t g = (pixel_color >> 16) & 0xFF;
+        const uint8_t b = (pixel_color >>  8) & 0xFF;
+        const uint8_t a = (pixel_color >>  0) & 0xFF;
+
+        SDL_SetRenderDrawColor(user_interface->renderer, r, g, b, a);
+        SDL_RenderFillRect(user_interface->renderer, &rect);
+
+        if (user_interface->pixel_outlines && emulated_display_pixel(emulated_system->display, i % EMULATED_DISPLAY_WIDTH, i / EMULATED_DISPLAY_WIDTH)) {
+            SDL_SetRenderDrawColor(user_interface->renderer, bg_r, bg_g, bg_b, bg_a);
+            SDL_RenderDrawRect(user_interface->renderer, &rect);
         }
     }
-    disassembling_user_interface_draw(user_interface, emulated_system);
+    if (user_interface->disassembling.is_active)
+        disassembling_user_interface_draw(user_interface, emulated_system);
     SDL_RenderPresent(user_interface->renderer);
 }
 
-/*
-CHIP8 Keypad  QWERTY 
-123C          1234
-456D          qwer
-789E          asdf
-A0BF          zxcv
-*/
+// CHIP8 key bound to an SDL key, -1 when there is none
+static int emulator_user_interface_keypad_key(const struct UserInterface *user_interface, SDL_Keycode key) {
+  for (int i = 0; i < 16; i++) {
+    if (user_interface->keymap[i] == key) return i;
+  }
+  return -1;
+}
+
+bool emulator_user_interface_set_keymap(struct UserInterface *user_interface, const char *keys) {
+  if (strlen(keys) != 16) {
+    fprintf(stderr, "A keymap has one key for each of 0 to F, got \"%s\"\n", keys);
+    return false;
+  }
+
+  // Printable characters are their own SDL_Keycode
+  for (int i = 0; i < 16; i++) user_interface->keymap[i] = (SDL_Keycode)SDL_tolower((unsigned char)keys[i]);
+  return true;
+}
+
+static void emulator_user_interface_handle_keyboard_event_key_down(struct UserInterface *user_interface, struct EmulatedSystem *emulated_system, const SDL_KeyboardEvent *event) {
+  const SDL_Keycode key = event->keysym.sym;
+  const int keypad_key = emulator_user_interface_keypad_key(user_interface, key);
+
+  // Keypad first, so remapped keys win over the shortcuts below
+  if (keypad_key >= 0) {
+    emulated_system->keypad |= 1u << keypad_key;
+
+    if (!event->repeat) {
+      emulated_system->keypad_observed &= ~(1u << keypad_key);
+      input_latency_key_down(&user_interface->input_latency, keypad_key, event->timestamp);
+    }
+    return;
+  }
 
-static void emulator_user_interface_handle_keyboard_event_key_down(struct UserInterface *user_interface, struct EmulatedSystem *emulated_system, SDL_Keycode key) {
   switch (key) {
       case SDLK_ESCAPE:
           // Escape key; Exit window & End program
@@ -229,7 +305,11 @@ static void emulator_user_interface_handle_keyboard_event_key_down(struct UserIn
 
       case SDLK_EQUALS:
           // '=': Reset CHIP8 machine for the current ROM
-          //init_chip8(chip8, *config, chip8->rom_name);
+          user_interface->should_reset = true;
+          break;
+
+      case SDLK_F1:
+          user_interface->disassembling.is_active = !user_interface->disassembling.is_active;
           break;
 
       case SDLK_t:
@@ -281,61 +361,25 @@ static void emulator_user_interface_handle_keyboard_event_key_down(struct UserIn
           }
           break;
 
-      // Map qwerty keys to CHIP8 keypad
-      case SDLK_1: emulated_system->keypad[0x1] = true; break;
-      case SDLK_2: emulated_system->keypad[0x2] = true; break;
-      case SDLK_3: emulated_system->keypad[0x3] = true; break;
-      case SDLK_4: emulated_system->keypad[0xC] = true; break;
-
-      case SDLK_q: emulated_system->keypad[0x4] = true; break;
-      case SDLK_w: emulated_system->keypad[0x5] = true; break;
-      case SDLK_e: emulated_system->keypad[0x6] = true; break;
-      case SDLK_r: emulated_system->keypad[0xD] = true; break;
-
-      case SDLK_a: emulated_system->keypad[0x7] = true; break;
-      case SDLK_s: emulated_system->keypad[0x8] = true; break;
-      case SDLK_d: emulated_system->keypad[0x9] = true; break;
-      case SDLK_f: emulated_system->keypad[0xE] = true; break;
-
-      case SDLK_z: emulated_system->keypad[0xA] = true; break;
-      case SDLK_x: emulated_system->keypad[0x0] = true; break;
-      case SDLK_c: emulated_system->keypad[0xB] = true; break;
-      case SDLK_v: emulated_system->keypad[0xF] = true; break;
-
       default: break;
   }
 }
 
-static void emulator_user_interface_handle_keyboard_event_key_up(struct EmulatedSystem *emulated_system, SDL_Keycode key) {
-  switch (key) {
-      // qwerty to CHIP8 keypad
-      case SDLK_1: emulated_system->keypad[0x1] = false; break;
-      case SDLK_2: emulated_system->keypad[0x2] = false; break;
-      case SDLK_3: emulated_system->keypad[0x3] = false; break;
-      case SDLK_4: emulated_system->keypad[0xC] = false; break;
-
-      case SDLK_q: emulated_system->keypad[0x4] = false; break;
-      case SDLK_w: emulated_system->keypad[0x5] = false; break;
-      case SDLK_e: emulated_system->keypad[0x6] = false; break;
-      case SDLK_r: emulated_system->keypad[0xD] = false; break;
-
-      case SDLK_a: emulated_system->keypad[0x7] = false; break;
-      case SDLK_s: emulated_system->keypad[0x8] = false; break;
-      case SDLK_d: emulated_system->keypad[0x9] = false; break;
-      case SDLK_f: emulated_system->keypad[0xE] = false; break;
-
-      case SDLK_z: emulated_system->keypad[0xA] = false; break;
-      case SDLK_x: emulated_system->keypad[0x0] = false; break;
-      case SDLK_c: emulated_system->keypad[0xB] = false; break;
-      case SDLK_v: emulated_system->keypad[0xF] = false; break;
+static void emulator_user_interface_handle_keyboard_event_key_up(struct UserInterface *user_interface, struct EmulatedSystem *emulated_system, SDL_Keycode key) {
+  const int keypad_key = emulator_user_interface_keypad_key(user_interface, key);
+  if (keypad_key < 0) return;
 
-      default: break;
-  }
+  emulated_system->keypad &= ~(1u << keypad_key);
+  input_latency_key_up(&user_interface->input_latency, keypad_key);
 }
 
 void emulator_user_interface_update(struct UserInterface *user_interface, struct EmulatedSystem *emulated_system) {
   SDL_Event event;
 
+  // The frame's instructions just ran, any key they read was seen now
+  if (user_interface->input_latency.pending)
+    input_latency_collect(&user_interface->input_latency, emulated_system->keypad_observed, SDL_GetTicks64());
+
   while (SDL_PollEvent(&event)) {
       switch (event.type) {
           case SDL_QUIT:
@@ -344,11 +388,11 @@ void emulator_user_interface_update(struct UserInterface *user_interface, struct
               break;
 
           case SDL_KEYDOWN:
-              emulator_user_interface_handle_keyboard_event_key_down(user_interface, emulated_system, event.key.keysym.sym);
+              emulator_user_interface_handle_keyboard_event_key_down(user_interface, emulated_system, &event.key);
               break;
 
           case SDL_KEYUP:
-              emulator_user_interface_handle_keyboard_event_key_up(emulated_system, event.key.keysym.sym);
+              emulator_user_interface_handle_keyboard_event_key_up(user_interface, emulated_system, event.key.keysym.sym);
               break;
       }
   }
@@ -356,7 +400,8 @@ void emulator_user_interface_update(struct UserInterface *user_interface, struct
   switch (emulated_system->state) {
     case RUNNING:
       emulated_user_interface_draw(user_interface, emulated_system);
-      SDL_PauseAudioDevice(user_interface->dev, !user_interface->should_play_sound); // Maybe pause sound
+      if (user_interface->should_play_sound ? emulator_user_interface_open_audio(user_interface) : user_interface->dev != 0)
+        SDL_PauseAudioDevice(user_interface->dev, !user_interface->should_play_sound); // Maybe pause sound
       break;
     case PAUSE:
       pause_menu_user_interface_draw(user_interface);
@@ -1,14 +1,42 @@
 #include "user_interface/sdl/interface.h"
 
+// Rendered on the first pause, most runs never pause
+static bool pause_menu_user_interface_create(struct UserInterface *user_interface) {
+    if (user_interface->pause_menu.message) return true;
+    else if (!emulator_user_interface_open_font(user_interface)) return false;
+
+    if (!user_interface->pause_menu.message_surface) {
+        user_interface->pause_menu.message_surface = TTF_RenderText_Blended_Wrapped(
+            user_interface->font,
+            "Game paused\n\nSpace: pause/resume\nF5: save state\nF9: load state\nt: slow/normal\nF1: disassembly overlay",
+            (SDL_Color){255, 255, 255, 255},
+            300
+        );
+        if (!user_interface->pause_menu.message_surface) return false;
+    }
+
+    user_interface->pause_menu.message = SDL_CreateTextureFromSurface(
+        user_interface->renderer,
+        user_interface->pause_menu.message_surface
+    );
+    return user_interface->pause_menu.message != NULL;
+}
+
 static void pause_menu_user_interface_draw(struct UserInterface *user_interface) {
+    SDL_SetRenderDrawColor(user_interface->renderer, 0, 0, 0, 255);
+    SDL_RenderClear(user_interface->renderer);
+
+    if (!pause_menu_user_interface_create(user_interface)) {
+        SDL_RenderPresent(user_interface->renderer);
+        return;
+    }
+
     SDL_Rect rectangle = {
         .x = 100,
         .y = 100,
         .w = user_interface->pause_menu.message_surface->w,
         .h = user_interface->pause_menu.message_surface->h
     };
-    SDL_SetRenderDrawColor(user_interface->renderer, 0, 0, 0, 255);
-    SDL_RenderClear(user_interface->renderer);
     SDL_RenderCopy(user_interface->renderer, user_interface->pause_menu.message, NULL, &rectangle);
     SDL_RenderPresent(user_interface->renderer);
 }
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "user_interface/video_stream.h"
+#include "user_interface/phosphor.h"
+
+static const char video_stream_y4m_frame_header[] = "FRAME\n";
+
+static void *video_stream_writer(void *userdata) {
+    struct VideoStream *video_stream = userdata;
+
+    pthread_mutex_lock(&video_stream->lock);
+    while (true) {
+        while (video_stream->count == 0 && !video_stream->is_closing)
+            pthread_cond_wait(&video_stream->not_empty, &video_stream->lock);
+
+        if (video_stream->count == 0) break; // Closing and drained
+
+        const uint8_t *frame = &video_stream->slots[video_stream->tail * video_stream->frame_size];
+        pthread_mutex_unlock(&video_stream->lock);
+
+        fwrite(frame, 1, video_stream->frame_size, video_stream->output);
+
+        pthread_mutex_lock(&video_stream->lock);
+        video_stream->tail = (video_stream->tail + 1) % VIDEO_STREAM_SLOTS;
+        video_stream->count--;
+        pthread_cond_signal(&video_stream->not_full);
+    }
+    pthread_mutex_unlock(&video_stream->lock);
+
+    fflush(video_stream->output);
+    return NULL;
+}
+
+bool video_stream_open(struct VideoStream *video_stream, const char *filename, int format,
+                       uint32_t fg_color, uint32_t bg_color, float color_lerp_rate, unsigned int frames_per_second) {
+    *video_stream = (struct VideoStream){
+        .format = format,
+        .fg_color = fg_color,
+        .bg_color = bg_color,
+        .color_lerp_rate = color_lerp_rate,
+    };
+
+    phosphor_reset(&video_stream->phosphor, bg_color);
+
+    const size_t pixel_count = VIDEO_STREAM_WIDTH * VIDEO_STREAM_HEIGHT;
+    video_stream->frame_size = (format == VIDEO_STREAM_Y4M)
+        ? sizeof video_stream_y4m_frame_header - 1 + pixel_count * 3
+        : pixel_count * 4;
+
+    // Every slot is allocated up front, nothing is allocated per frame
+    video_stream->slots = malloc(video_stream->frame_size * VIDEO_STREAM_SLOTS);
+    if (!video_stream->slots) return false;
+
+    video_stream->output = (strcmp(filename, "-") == 0) ? stdout : fopen(filename, "wb");
+    if (!video_stream->output) {
+        fprintf(stderr, "Could not open video output %s\n", filename);
+        free(video_stream->slots);
+        return false;
+    }
+    setvbuf(video_stream->output, NULL, _IOFBF, 1 << 20);
+
+    if (format == VIDEO_STREAM_Y4M)
+        fprintf(video_stream->output, "YUV4MPEG2 W%d H%d F%u:1 Ip A1:1 C444\n",
+                VIDEO_STREAM_WIDTH, VIDEO_STREAM_HEIGHT, frames_per_second);
+
+    pthread_mutex_init(&video_stream->lock, NULL);
+    pthread_cond_init(&video_stream->not_empty, NULL);
+    pthread_cond_init(&video_stream->not_full, NULL);
+
+    if (pthread_create(&video_stream->writer, NULL, video_stream_writer, video_stream) != 0) {
+        fprintf(stderr, "Could not start video writer thread\n");
+        pthread_cond_destroy(&video_stream->not_full);
+        pthread_cond_destroy(&video_stream->not_empty);
+        pthread_mutex_destroy(&video_stream->lock);
+        if (video_stream->output != stdout) fclose(video_stream->output);
+        video_stream->output = NULL;
+        free(video_stream->slots);
+        return false;
+    }
+
+    return true;
+}
+
+// Full range BT.601
+static inline void video_stream_rgb_to_yuv(uint32_t color, uint8_t *y, uint8_t *u, uint8_t *v) {
+    const int32_t r = (color >> 24) & 0xFF;
+    const int32_t g = (color >> 16) & 0xFF;
+    const int32_t b = (color >>  8) & 0xFF;
+
+    *y = (uint8_t)((  77 * r + 150 * g +  29 * b + 128) >> 8);
+    *u = (uint8_t)(((-43 * r -  85 * g + 128 * b + 128) >> 8) + 128);
+    *v = (uint8_t)(((128 * r - 107 * g -  21 * b + 128) >> 8) + 128);
+}
+
+void video_stream_push_frame(struct VideoStream *video_stream, const struct EmulatedSystem *emulated_system) {
+    const size_t pixel_count = VIDEO_STREAM_WIDTH * VIDEO_STREAM_HEIGHT;
+
+    pthread_mutex_lock(&video_stream->lock);
+    while (video_stream->count == VIDEO_STREAM_SLOTS)
+        pthread_cond_wait(&video_stream->not_full, &video_stream->lock);
+    uint8_t *frame = &video_stream->slots[video_stream->head * video_stream->frame_size];
+    pthread_mutex_unlock(&video_stream->lock);
+
+    // Same phosphor effect as the window
+    phosphor_update(&video_stream->phosphor, emulated_system->display,
+                    video_stream->fg_color, video_stream->bg_color, video_stream->color_lerp_rate);
+    const uint32_t *pixel_color = video_stream->phosphor.pixel_color;
+
+    if (video_stream->format == VIDEO_STREAM_Y4M) {
+        memcpy(frame, video_stream_y4m_frame_header, sizeof video_stream_y4m_frame_header - 1);
+        uint8_t *y_plane = frame + sizeof video_stream_y4m_frame_header - 1;
+        uint8_t *u_plane = y_plane + pixel_count;
+        uint8_t *v_plane = u_plane + pixel_count;
+
+        for (size_t i = 0; i < pixel_count; i++)
+            video_stream_rgb_to_yuv(pixel_color[i], &y_plane[i], &u_plane[i], &v_plane[i]);
+    }
+    else {
+        for (size_t i = 0; i < pixel_count; i++) {
+            const uint32_t color = pixel_color[i];
+            frame[i * 4 + 0] = (color >> 24) & 0xFF;
+            frame[i * 4 + 1] = (color >> 16) & 0xFF;
+            frame[i * 4 + 2] = (color >>  8) & 0xFF;
+            frame[i * 4 + 3] = (color >>  0) & 0xFF;
+        }
+    }
+
+    pthread_mutex_lock(&video_stream->lock);
+    video_stream->head = (video_stream->head + 1) % VIDEO_STREAM_SLOTS;
+    video_stream->count++;
+    pthread_cond_signal(&video_stream->not_empty);
+    pthread_mutex_unlock(&video_stream->lock);
+}
+
+void video_stream_close(struct VideoStream *video_stream) {
+    if (!video_stream->output) return;
+
+    pthread_mutex_lock(&video_stream->lock);
+    video_stream->is_closing = true;
+    pthread_cond_signal(&video_stream->not_empty);
+    pthread_mutex_unlock(&video_stream->lock);
+
+    pthread_join(video_stream->writer, NULL);
+
+    if (video_stream->output != stdout) fclose(video_stream->output);
+    video_stream->output = NULL;
+
+    pthread_mutex_destroy(&video_stream->lock);
+    pthread_cond_destroy(&video_stream->not_empty);
+    pthread_cond_destroy(&video_stream->not_full);
+    free(video_stream->slots);
+}